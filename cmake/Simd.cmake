@@ -0,0 +1,14 @@
+# Enables the AVX2/BMI2/F16C code paths (Haswell or newer) of the CPU voxelization kernels.
+# Without it the kernels fall back to portable scalar code.
+function(enable_simd project_name)
+  option(ENABLE_AVX2 "Build the CPU voxelization kernels with AVX2, BMI2 and F16C" TRUE)
+  if (NOT ENABLE_AVX2)
+    return()
+  endif()
+
+  if (MSVC)
+    target_compile_options(${project_name} PRIVATE /arch:AVX2)
+  elseif (CMAKE_CXX_COMPILER_ID MATCHES ".*Clang" OR CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+    target_compile_options(${project_name} PRIVATE -mavx2 -mbmi2 -mfma -mf16c)
+  endif()
+endfunction()
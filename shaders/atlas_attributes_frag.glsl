@@ -0,0 +1,49 @@
+#version 450
+
+layout(std140) uniform Material // Must match the GPUMaterial defined in src/mesh.h
+{
+    vec3 kd;
+	vec3 ks;
+	float shininess;
+	float transparency;
+};
+
+layout(location = 3) uniform sampler2D kdTexture;
+layout(location = 4) uniform bool hasTexCoords;
+layout(location = 5) uniform bool useMaterial;
+// Nearest texel of kdTexture at the texel's sample position, like rasterizeTexelCloud: the offset of the sample from
+// the texel corner and the kdTexture texels per atlas texel
+layout(location = 12) uniform vec2 albedoSampleOffset;
+layout(location = 13) uniform vec2 albedoTexelScale;
+
+// The atlas G-buffer next to the position that atlas_frag.glsl and atlas_packed_frag.glsl write, see
+// setupAtlasShader: octahedral normal (RG16_SNORM), albedo (RGBA8)
+layout(location = 1) out vec2 fragOctahedralNormal;
+layout(location = 2) out vec4 fragAlbedo;
+
+// Same encoding as voxel_attributes::packNormal in src/voxel_attributes.h
+vec2 octahedralEncode(vec3 n)
+{
+    const float l1 = abs(n.x) + abs(n.y) + abs(n.z);
+    if (l1 == 0.0) {
+        return vec2(0.0);
+    }
+    vec2 octahedral = n.xy / l1;
+    if (n.z < 0.0) {
+        const vec2 signs = vec2(octahedral.x >= 0.0 ? 1.0 : -1.0, octahedral.y >= 0.0 ? 1.0 : -1.0);
+        octahedral = (1.0 - abs(octahedral.yx)) * signs;
+    }
+    return octahedral;
+}
+
+// Writes the normal and albedo of the texel.
+void writeAtlasAttributes(vec3 normal)
+{
+    fragOctahedralNormal = octahedralEncode(normal);
+    if (hasTexCoords) {
+        precise vec2 samplePosition = (floor(gl_FragCoord.xy) + albedoSampleOffset) * albedoTexelScale;
+        fragAlbedo = vec4(texelFetch(kdTexture, ivec2(samplePosition), 0).rgb, 1.0);
+    } else {
+        fragAlbedo = vec4(useMaterial ? kd : vec3(1.0), 1.0);
+    }
+}
@@ -0,0 +1,75 @@
+#version 450
+
+flat in vec2 triangleWindow[3];
+flat in vec3 trianglePosition[3];
+flat in vec3 triangleNormal[3];
+flat in vec2 triangleTexCoord[3];
+
+// Barycentric coordinates of the point of triangle abc closest to p, the same cases as closestPoint in
+// src/atlas_rasterizer.cpp (Ericson, Real-Time Collision Detection 5.1.5).
+vec3 closestBarycentrics(vec2 p, vec2 a, vec2 b, vec2 c)
+{
+    const vec2 ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0) {
+        return vec3(1.0, 0.0, 0.0);
+    }
+    const vec2 bp = p - b;
+    const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3) {
+        return vec3(0.0, 1.0, 0.0);
+    }
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+        const float v = d1 / (d1 - d3);
+        return vec3(1.0 - v, v, 0.0);
+    }
+    const vec2 cp = p - c;
+    const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6) {
+        return vec3(0.0, 0.0, 1.0);
+    }
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+        const float w = d2 / (d2 - d6);
+        return vec3(1.0 - w, 0.0, w);
+    }
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) {
+        const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return vec3(0.0, 1.0 - w, w);
+    }
+    const float denominator = 1.0 / (va + vb + vc);
+    const float v = vb * denominator, w = vc * denominator;
+    return vec3(1.0 - v - w, v, w);
+}
+
+// atlasSample of atlas_frag.glsl and atlas_packed_frag.glsl for conservative rasterization: drops the texels of
+// the grown triangle (atlas_conservative_geom.glsl) whose square misses the original triangle, and takes the
+// attributes at the point of the triangle closest to the texel center. renderAtlas only lets this pass write the
+// texels no triangle covers at the center (stencil test), so those keep their center sample.
+void atlasSample(out vec3 position, out vec3 normal, out vec2 texCoord)
+{
+    const vec2 center = gl_FragCoord.xy;
+    const vec2 lower = min(triangleWindow[0], min(triangleWindow[1], triangleWindow[2]));
+    const vec2 upper = max(triangleWindow[0], max(triangleWindow[1], triangleWindow[2]));
+    if (any(lessThan(center + 0.5, lower)) || any(greaterThan(center - 0.5, upper))) {
+        discard;
+    }
+    const vec2 e1 = triangleWindow[1] - triangleWindow[0];
+    const vec2 e2 = triangleWindow[2] - triangleWindow[0];
+    const float winding = e1.x * e2.y - e1.y * e2.x > 0.0 ? 1.0 : -1.0;
+    for (int k = 0; k < 3; ++k) {
+        const vec2 edge = triangleWindow[(k + 1) % 3] - triangleWindow[k];
+        const vec2 n = winding * vec2(-edge.y, edge.x);
+        // the corner of the texel furthest inside the edge
+        if (dot(n, center - triangleWindow[k]) + 0.5 * (abs(n.x) + abs(n.y)) < 0.0) {
+            discard;
+        }
+    }
+
+    const vec3 weights = closestBarycentrics(center, triangleWindow[0], triangleWindow[1], triangleWindow[2]);
+    position = weights.x * trianglePosition[0] + weights.y * trianglePosition[1] + weights.z * trianglePosition[2];
+    normal = weights.x * triangleNormal[0] + weights.y * triangleNormal[1] + weights.z * triangleNormal[2];
+    texCoord = weights.x * triangleTexCoord[0] + weights.y * triangleTexCoord[1] + weights.z * triangleTexCoord[2];
+}
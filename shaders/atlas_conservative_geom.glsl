@@ -0,0 +1,58 @@
+#version 450
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+layout(location = 11) uniform int atlasLength;
+
+in vec3 fragPosition[];
+in vec3 fragNormal[];
+in vec2 fragTexCoord[];
+
+// The original triangle in window coordinates, for atlas_conservative_frag.glsl
+flat out vec2 triangleWindow[3];
+flat out vec3 trianglePosition[3];
+flat out vec3 triangleNormal[3];
+flat out vec2 triangleTexCoord[3];
+
+// Grows the triangle so that it covers every texel whose square it overlaps (conservative rasterization, Hasselgren
+// et al., GPU Gems 2 chapter 42): every edge moves outwards until it passes the far corner of the texels it touches,
+// and the new vertices are where neighbouring edges meet. Near sharp corners the grown triangle also covers texels
+// the original one does not touch, atlas_conservative_frag.glsl discards those.
+void main()
+{
+    const float halfLength = 0.5 * float(atlasLength);
+    vec2 window[3];
+    for (int i = 0; i < 3; ++i) {
+        window[i] = (gl_in[i].gl_Position.xy + 1.0) * halfLength;
+    }
+    const vec2 e1 = window[1] - window[0];
+    const vec2 e2 = window[2] - window[0];
+    const float area = e1.x * e2.y - e1.y * e2.x;
+    // Zero area triangles produce no fragments, like in AtlasRasterizer
+    if (area == 0.0) {
+        return;
+    }
+
+    // Edge k runs from vertex k to vertex k + 1, as the line dot(n, p) + c = 0 with the triangle on the positive side
+    vec3 edges[3];
+    for (int k = 0; k < 3; ++k) {
+        const vec2 edge = window[(k + 1) % 3] - window[k];
+        const vec2 n = (area > 0.0 ? 1.0 : -1.0) * vec2(-edge.y, edge.x);
+        edges[k] = vec3(n, -dot(n, window[k]) + 0.5 * (abs(n.x) + abs(n.y)));
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        // Vertex i lies on edges i - 1 and i, the cross product of two lines is their intersection
+        const vec3 corner = cross(edges[(i + 2) % 3], edges[i]);
+        gl_Position = vec4(corner.xy / corner.z / halfLength - 1.0, 0.0, 1.0);
+        for (int v = 0; v < 3; ++v) {
+            triangleWindow[v] = window[v];
+            trianglePosition[v] = fragPosition[v];
+            triangleNormal[v] = fragNormal[v];
+            triangleTexCoord[v] = fragTexCoord[v];
+        }
+        EmitVertex();
+    }
+    EndPrimitive();
+}
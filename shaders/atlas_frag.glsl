@@ -1,24 +1,19 @@
 #version 450
 
-layout(std140) uniform Material // Must match the GPUMaterial defined in src/mesh.h
-{
-    vec3 kd;
-	vec3 ks;
-	float shininess;
-	float transparency;
-};
-
-layout(location = 3) uniform sampler2D colorMap;
-layout(location = 4) uniform bool hasTexCoords;
-layout(location = 5) uniform bool useMaterial;
-
-in vec3 fragPosition;
-in vec3 fragNormal;
-in vec2 fragTexCoord;
+// Surface point the texel samples, see atlas_sample_frag.glsl and atlas_conservative_frag.glsl
+void atlasSample(out vec3 position, out vec3 normal, out vec2 texCoord);
+// Normal and albedo attachments, see atlas_attributes_frag.glsl
+void writeAtlasAttributes(vec3 normal);
 
+// Position attachment of the atlas G-buffer (RGB32F or RGBA16F), see setupAtlasShader
 layout(location = 0) out vec4 fragColor;
 
 void main()
 {
-    fragColor = vec4(fragPosition, 1.0);
+    vec3 position, normal;
+    vec2 texCoord;
+    atlasSample(position, normal, texCoord);
+
+    fragColor = vec4(position, 1.0);
+    writeAtlasAttributes(normal);
 }
@@ -0,0 +1,31 @@
+#version 450
+
+// Bounded voxel grid the positions are quantized to
+layout(location = 6) uniform vec3 worldMin;
+layout(location = 7) uniform vec3 worldMax;
+layout(location = 8) uniform int gridLength;
+layout(location = 9) uniform mat4 voxelModelMatrix;
+
+// Surface point the texel samples, see atlas_sample_frag.glsl and atlas_conservative_frag.glsl
+void atlasSample(out vec3 position, out vec3 normal, out vec2 texCoord);
+// Normal and albedo attachments, see atlas_attributes_frag.glsl
+void writeAtlasAttributes(vec3 normal);
+
+// atlas_frag.glsl with the position replaced by the voxel it falls in (R32UI): the grid position packed as in
+// src/voxel_instance.h, with bit 31 set. Texels no triangle covers keep their clear value 0.
+layout(location = 0) out uint fragVoxel;
+
+void main()
+{
+    vec3 position, normal;
+    vec2 texCoord;
+    atlasSample(position, normal, texCoord);
+
+    // Same arithmetic as VoxelGrid::worldToGridPosition for a bounded grid, like voxelize_atlas_comp.glsl.
+    precise vec3 worldPos = (voxelModelMatrix * vec4(position, 1.0)).xyz;
+    precise vec3 normalizedPos = clamp((worldPos - worldMin) / (worldMax - worldMin), vec3(0.0), vec3(1.0));
+    const uvec3 gridPos = uvec3(min(ivec3(floor(normalizedPos * float(gridLength))), ivec3(gridLength - 1)));
+    fragVoxel = gridPos.x | (gridPos.y << 10) | (gridPos.z << 20) | (1u << 31);
+
+    writeAtlasAttributes(normal);
+}
@@ -0,0 +1,30 @@
+#version 450
+
+in vec2 fragTexCoord;
+
+// Attribute planes of the mesh's triangles in window coordinates, AtlasRasterizer::attributePlanes in
+// src/atlas_rasterizer.h. The interpolators round as the driver likes, the planes give the CPU rasterizer's bits.
+struct AttributePlanes {
+    vec4 origin;
+    vec4 value[2];
+    vec4 ddx[2];
+    vec4 ddy[2];
+};
+layout(std430, binding = 0) readonly buffer AtlasPlanes
+{
+    AttributePlanes planes[];
+};
+
+// atlasSample of atlas_frag.glsl and atlas_packed_frag.glsl for regular rasterization: the attributes at the texel
+// center.
+void atlasSample(out vec3 position, out vec3 normal, out vec2 texCoord)
+{
+    const AttributePlanes plane = planes[gl_PrimitiveID];
+    precise float dx = gl_FragCoord.x - plane.origin.x;
+    precise float dy = gl_FragCoord.y - plane.origin.y;
+    precise vec3 planePosition = plane.value[0].xyz + plane.ddx[0].xyz * dx + plane.ddy[0].xyz * dy;
+    precise vec3 planeNormal = plane.value[1].xyz + plane.ddx[1].xyz * dx + plane.ddy[1].xyz * dy;
+    position = planePosition;
+    normal = planeNormal;
+    texCoord = fragTexCoord;
+}
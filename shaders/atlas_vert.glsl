@@ -5,6 +5,8 @@ layout(location = 1) uniform mat4 modelMatrix;
 // Normals should be transformed differently than positions:
 // https://paroj.github.io/gltut/Illumination/Tut09%20Normal%20Transformation.html
 layout(location = 2) uniform mat3 normalModelMatrix;
+// Jittered atlas passes move the triangles instead of the sample, see AtlasRasterizer::jitterClipOffset
+layout(location = 10) uniform vec2 clipOffset;
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -16,7 +18,7 @@ out vec2 fragTexCoord;
 
 void main()
 {
-    gl_Position = vec4(texCoord * 2.0 - 1.0, 0.0, 1.0);
+    gl_Position = vec4(texCoord * 2.0 - 1.0 - clipOffset, 0.0, 1.0);
 
     fragPosition = (modelMatrix * vec4(position, 1)).xyz;
     fragNormal = normalModelMatrix * normal;
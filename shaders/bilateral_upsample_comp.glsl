@@ -0,0 +1,62 @@
+#version 450
+
+// Joint bilateral upsampling of a low resolution lighting texture guided by the full resolution G-buffer, see
+// BilateralUpsampler.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform int factor;
+layout(location = 1) uniform vec3 cameraPos;
+
+layout(binding = 0) uniform sampler2D positions; // w = 0 where no surface was rendered
+layout(binding = 1) uniform sampler2D normals;
+layout(binding = 2) uniform sampler2D lowResPositions;
+layout(binding = 3) uniform sampler2D lowResNormals;
+layout(binding = 4) uniform sampler2D lowResSignal;
+
+layout(rgba16f, binding = 0) writeonly uniform image2D upsampled;
+
+// Relative difference in the distance to the camera at which a sample's weight falls to 1/e
+const float depthSigma = 0.02;
+const float normalExponent = 16.0;
+
+void main()
+{
+    const ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, imageSize(upsampled))))
+        return;
+    const vec4 position = texelFetch(positions, pixel, 0);
+    if (position.w == 0.0) {
+        imageStore(upsampled, pixel, vec4(0.0));
+        return;
+    }
+    const vec3 normal = normalize(texelFetch(normals, pixel, 0).xyz);
+    const float distance = length(position.xyz - cameraPos);
+
+    const ivec2 lowResSize = textureSize(lowResSignal, 0);
+    const vec2 lowResTexel = (vec2(pixel) + 0.5) / float(factor) - 0.5;
+    const ivec2 base = ivec2(floor(lowResTexel));
+    const vec2 f = lowResTexel - vec2(base);
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    vec4 closest = vec4(0.0);
+    float closestDifference = 1e30;
+    for (int tap = 0; tap < 4; ++tap) {
+        const ivec2 offset = ivec2(tap & 1, tap >> 1);
+        const ivec2 texel = clamp(base + offset, ivec2(0), lowResSize - 1);
+        const vec4 samplePosition = texelFetch(lowResPositions, texel, 0);
+        if (samplePosition.w == 0.0)
+            continue;
+        const vec4 value = texelFetch(lowResSignal, texel, 0);
+        const float difference = abs(length(samplePosition.xyz - cameraPos) - distance) / distance;
+        const float normalWeight = pow(max(dot(normalize(texelFetch(lowResNormals, texel, 0).xyz), normal), 0.0), normalExponent);
+        const vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        const float weight = bilinear.x * bilinear.y * exp(-difference / depthSigma) * normalWeight;
+        sum += weight * value;
+        weightSum += weight;
+        if (difference < closestDifference) {
+            closest = value;
+            closestDifference = difference;
+        }
+    }
+    imageStore(upsampled, pixel, weightSum > 1e-4 ? sum / weightSum : closest);
+}
@@ -0,0 +1,33 @@
+#version 450
+
+// Appends the grid position of every occupied voxel to the instance buffer, one invocation per occupancy word.
+// The instance count of the indirect draw command doubles as the atomic counter.
+// Dispatched over (words per row, y, z) so large grids stay below the work group count limit of a dimension.
+layout(local_size_x = 1, local_size_y = 8, local_size_z = 8) in;
+
+layout(r32ui, binding = 0) readonly uniform uimage3D occupancy;
+
+// DrawElementsIndirectCommand { count, instanceCount, firstIndex, baseVertex, baseInstance }
+layout(binding = 0, offset = 4) uniform atomic_uint instanceCount;
+
+// 10:10:10 packed grid positions, x in the lowest bits
+layout(std430, binding = 1) writeonly buffer VoxelInstances
+{
+    uint packedGridPositions[];
+};
+
+void main()
+{
+    const ivec3 wordPos = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(wordPos, imageSize(occupancy))))
+        return;
+
+    uint word = imageLoad(occupancy, wordPos).r;
+    while (word != 0u) {
+        const int bit = findLSB(word);
+        const uint instance = atomicCounterIncrement(instanceCount);
+        if (instance < uint(packedGridPositions.length()))
+            packedGridPositions[instance] = uint(wordPos.x * 32 + bit) | (uint(wordPos.y) << 10) | (uint(wordPos.z) << 20);
+        word &= word - 1u; // clear lowest set bit
+    }
+}
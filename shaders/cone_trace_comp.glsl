@@ -0,0 +1,104 @@
+#version 450
+
+// Traces diffuse cones over the hemisphere of every G-buffer pixel and a glossy cone along the reflected view
+// direction through the radiance volume and its directional mip chains, see VoxelConeTracer.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform vec3 volumeMin;
+layout(location = 1) uniform float volumeWorldLength;
+layout(location = 2) uniform int volumeLength;
+layout(location = 3) uniform vec3 cameraPos;
+layout(location = 4) uniform int coneCount;
+layout(location = 5) uniform float maxDistance;
+layout(location = 6) uniform bool glossy;
+layout(location = 7) uniform float glossyTanHalfAngle;
+layout(location = 8) uniform uint frame;
+layout(location = 9) uniform int frameCount; // the diffuse cones are spread over this many frames, see SampleInterleave
+
+layout(binding = 0) uniform sampler2D positions; // G-buffer, w = 0 where no surface was rendered
+layout(binding = 1) uniform sampler2D normals;
+layout(binding = 2) uniform sampler3D radiance;
+layout(binding = 3) uniform sampler3D directionalRadiance[6]; // +x, -x, +y, -y, +z, -z at half resolution
+
+layout(rgba16f, binding = 0) writeonly uniform image2D indirectDiffuse;
+layout(rgba16f, binding = 1) writeonly uniform image2D indirectGlossy;
+
+const float goldenAngle = 2.39996323;
+const int bayer4x4[16] = int[](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+const float maxDiffuseHalfAngle = radians(60.0);
+
+float voxelSize;
+
+// The three directional volumes facing dir, weighted by the squared components of dir (which sum to 1)
+vec4 sampleDirectional(vec3 uvw, vec3 dir, float level)
+{
+    const vec3 weights = dir * dir;
+    const vec4 x = dir.x >= 0.0 ? textureLod(directionalRadiance[0], uvw, level) : textureLod(directionalRadiance[1], uvw, level);
+    const vec4 y = dir.y >= 0.0 ? textureLod(directionalRadiance[2], uvw, level) : textureLod(directionalRadiance[3], uvw, level);
+    const vec4 z = dir.z >= 0.0 ? textureLod(directionalRadiance[4], uvw, level) : textureLod(directionalRadiance[5], uvw, level);
+    return weights.x * x + weights.y * y + weights.z * z;
+}
+
+// Premultiplied radiance (rgb) and occlusion (a) seen through a cone starting above the surface at position
+vec4 traceCone(vec3 position, vec3 normal, vec3 origin, vec3 dir, float tanHalfAngle)
+{
+    vec4 accumulated = vec4(0.0);
+    float distance = voxelSize;
+    while (distance < maxDistance && accumulated.a < 0.95) {
+        const float diameter = max(voxelSize, 2.0 * tanHalfAngle * distance);
+        const vec3 uvw = (origin + distance * dir - volumeMin) / volumeWorldLength;
+        if (any(lessThan(uvw, vec3(0.0))) || any(greaterThan(uvw, vec3(1.0))))
+            break;
+        // Level 0 of the directional volumes has twice the voxel size of the radiance volume. Cells larger than
+        // half the height above the surface would filter in the surface the cone starts from.
+        const float height = dot(origin + distance * dir - position, normal);
+        const float level = max(min(log2(diameter / voxelSize), log2(height / voxelSize) - 1.0), 0.0);
+        const vec4 voxel = level < 1.0 ? mix(textureLod(radiance, uvw, 0.0), sampleDirectional(uvw, dir, 0.0), level)
+                                       : sampleDirectional(uvw, dir, level - 1.0);
+        accumulated += (1.0 - accumulated.a) * voxel;
+        distance += 0.5 * diameter;
+    }
+    return accumulated;
+}
+
+void main()
+{
+    const ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, imageSize(indirectDiffuse))))
+        return;
+    const vec4 position = texelFetch(positions, pixel, 0);
+    if (position.w == 0.0) {
+        imageStore(indirectDiffuse, pixel, vec4(0.0));
+        imageStore(indirectGlossy, pixel, vec4(0.0));
+        return;
+    }
+    voxelSize = volumeWorldLength / float(volumeLength);
+    const vec3 normal = normalize(texelFetch(normals, pixel, 0).xyz);
+    const vec3 tangent = normalize(cross(normal, abs(normal.x) < 0.9 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0)));
+    const vec3 bitangent = cross(normal, tangent);
+    // Start outside the voxel of the surface itself, about a trilinear footprint away
+    const vec3 origin = position.xyz + 1.75 * voxelSize * normal;
+
+    // Every cone covers an equal share of the hemisphere's solid angle. This frame traces every frameCount-th.
+    const float halfAngle = min(acos(1.0 - 1.0 / float(coneCount)), maxDiffuseHalfAngle);
+    const float tanHalfAngle = tan(halfAngle);
+    const int firstCone = int((uint(bayer4x4[4 * (pixel.y & 3) + (pixel.x & 3)]) + frame) % uint(frameCount));
+    vec4 diffuse = vec4(0.0);
+    int traced = 0;
+    for (int cone = firstCone; cone < coneCount; cone += frameCount, ++traced) {
+        // Cosine weighted Fibonacci points, the first cone along the normal when there is only one
+        const float cosTheta = coneCount == 1 ? 1.0 : sqrt(1.0 - (float(cone) + 0.5) / float(coneCount));
+        const float sinTheta = sqrt(max(1.0 - cosTheta * cosTheta, 0.0));
+        const float phi = goldenAngle * float(cone);
+        const vec3 dir = normalize(sinTheta * (cos(phi) * tangent + sin(phi) * bitangent) + cosTheta * normal);
+        diffuse += traceCone(position.xyz, normal, origin, dir, tanHalfAngle);
+    }
+    imageStore(indirectDiffuse, pixel, diffuse / float(max(traced, 1)));
+
+    vec4 specular = vec4(0.0);
+    if (glossy) {
+        const vec3 reflected = reflect(normalize(position.xyz - cameraPos), normal);
+        specular = traceCone(position.xyz, normal, origin, reflected, glossyTanHalfAngle);
+    }
+    imageStore(indirectGlossy, pixel, specular);
+}
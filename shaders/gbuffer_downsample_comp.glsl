@@ -0,0 +1,48 @@
+#version 450
+
+// Reduces the G-buffer positions and normals by factor, see BilateralUpsampler: every low resolution pixel keeps
+// the surface of its block closest to the camera, or the farthest on the odd squares of a checkerboard.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform int factor;
+layout(location = 1) uniform vec3 cameraPos;
+
+layout(binding = 0) uniform sampler2D positions; // w = 0 where no surface was rendered
+layout(binding = 1) uniform sampler2D normals;
+
+layout(rgba32f, binding = 0) writeonly uniform image2D lowResPositions;
+layout(rgba16f, binding = 1) writeonly uniform image2D lowResNormals;
+
+void main()
+{
+    const ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, imageSize(lowResPositions))))
+        return;
+    const ivec2 size = textureSize(positions, 0);
+    const bool farthest = ((pixel.x + pixel.y) & 1) == 1;
+
+    ivec2 chosen = ivec2(-1);
+    float chosenDistance = farthest ? -1.0 : 1e30;
+    for (int y = 0; y < factor; ++y) {
+        for (int x = 0; x < factor; ++x) {
+            const ivec2 texel = factor * pixel + ivec2(x, y);
+            if (any(greaterThanEqual(texel, size)))
+                continue;
+            const vec4 position = texelFetch(positions, texel, 0);
+            if (position.w == 0.0)
+                continue;
+            const float distance = length(position.xyz - cameraPos);
+            if (farthest ? distance > chosenDistance : distance < chosenDistance) {
+                chosen = texel;
+                chosenDistance = distance;
+            }
+        }
+    }
+    if (chosen.x < 0) {
+        imageStore(lowResPositions, pixel, vec4(0.0));
+        imageStore(lowResNormals, pixel, vec4(0.0));
+        return;
+    }
+    imageStore(lowResPositions, pixel, texelFetch(positions, chosen, 0));
+    imageStore(lowResNormals, pixel, texelFetch(normals, chosen, 0));
+}
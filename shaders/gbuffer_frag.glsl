@@ -0,0 +1,34 @@
+#version 450
+
+layout(std140) uniform Material // Must match the GPUMaterial defined in src/mesh.h
+{
+    vec3 kd;
+	vec3 ks;
+	float shininess;
+	float transparency;
+};
+
+layout(location = 3) uniform sampler2D colorMap;
+layout(location = 4) uniform bool hasTexCoords;
+layout(location = 5) uniform bool useMaterial;
+
+in vec3 fragPosition;
+in vec3 fragNormal;
+in vec2 fragTexCoord;
+
+// Screen G-buffer, see GBuffer: world position (w = 1 marks a surface), world normal, albedo
+layout(location = 0) out vec4 gPosition;
+layout(location = 1) out vec4 gNormal;
+layout(location = 2) out vec4 gAlbedo;
+
+void main()
+{
+    gPosition = vec4(fragPosition, 1.0);
+    gNormal = vec4(normalize(fragNormal), 0.0);
+    // Same albedo as the atlas G-buffer, see atlas_attributes_frag.glsl
+    if (hasTexCoords) {
+        gAlbedo = vec4(texture(colorMap, fragTexCoord).rgb, 1.0);
+    } else {
+        gAlbedo = vec4(useMaterial ? kd : vec3(1.0), 1.0);
+    }
+}
@@ -0,0 +1,43 @@
+#version 450
+
+// Shades the screen G-buffer: direct Lambert from the point light plus the indirect lighting of the GI passes.
+layout(location = 0) uniform vec3 lightPos;
+layout(location = 1) uniform int giView; // 0 = direct + indirect, 1 = indirect only, 2 = direct only
+layout(location = 2) uniform float indirectStrength;
+layout(location = 3) uniform float glossyStrength;
+
+layout(binding = 0) uniform sampler2D positions;
+layout(binding = 1) uniform sampler2D normals;
+layout(binding = 2) uniform sampler2D albedos;
+layout(binding = 3) uniform sampler2D depths;
+layout(binding = 4) uniform sampler2D indirectDiffuse; // average incoming radiance, a = occlusion
+layout(binding = 5) uniform sampler2D indirectGlossy;
+
+in vec2 screenTexCoord;
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    const ivec2 pixel = ivec2(gl_FragCoord.xy);
+    const vec4 position = texelFetch(positions, pixel, 0);
+    if (position.w == 0.0)
+        discard;
+    // Keeps the depth test working for what is drawn on top, such as the grid bounds
+    gl_FragDepth = texelFetch(depths, pixel, 0).r;
+
+    const vec3 lightColor = vec3(1.0, 1.0, 1.0);
+    const vec3 normal = normalize(texelFetch(normals, pixel, 0).xyz);
+    const vec3 albedo = texelFetch(albedos, pixel, 0).rgb;
+    const vec3 direct = max(dot(normal, normalize(lightPos - position.xyz)), 0.0) * lightColor;
+    const vec3 indirect = indirectStrength * texelFetch(indirectDiffuse, pixel, 0).rgb;
+    const vec3 glossy = glossyStrength * texelFetch(indirectGlossy, pixel, 0).rgb;
+
+    if (giView == 1) {
+        fragColor = vec4(albedo * indirect + glossy, 1.0);
+    } else if (giView == 2) {
+        fragColor = vec4(albedo * direct, 1.0);
+    } else {
+        fragColor = vec4(albedo * (direct + indirect) + glossy, 1.0);
+    }
+}
@@ -0,0 +1,81 @@
+#version 450
+
+// Lights every voxel instance by a point light (Lambert, unshadowed) and adds its outgoing radiance to the voxel of
+// the radiance volume it lies in, as fixed point sums with a count that radiance_resolve_comp.glsl averages, see
+// VoxelConeTracer::injectInstances. Invocations loop over the instances, so a fixed number of work groups covers any
+// instance count.
+layout(local_size_x = 64) in;
+
+layout(location = 0) uniform uint maxInstances;
+layout(location = 1) uniform bool countFromCommand; // the instance count is in DrawCommand, maxInstances is the capacity
+layout(location = 2) uniform bool hasAttributes;
+layout(location = 3) uniform vec3 gridOrigin; // world space minimum corner of the voxel at packed position 0
+layout(location = 4) uniform float voxelScale;
+layout(location = 5) uniform vec3 volumeMin;
+layout(location = 6) uniform float volumeVoxelScale;
+layout(location = 7) uniform vec3 lightPos;
+layout(location = 8) uniform vec3 lightColor;
+layout(location = 9) uniform float fixedPointScale;
+
+// 10:10:10 packed grid positions, x in the lowest bits (see voxel_instance.h)
+layout(std430, binding = 1) readonly buffer VoxelInstances
+{
+    uint packedGridPositions[];
+};
+
+// Octahedral normal (snorm16 x2) and albedo (RGBA8) per instance, see voxel_attributes.h
+layout(std430, binding = 2) readonly buffer VoxelInstanceAttributes
+{
+    uvec2 packedAttributes[];
+};
+
+// DrawElementsIndirectCommand of the GPU voxelizer
+layout(std430, binding = 3) readonly buffer DrawCommand
+{
+    uint indexCount;
+    uint instanceCount;
+};
+
+// Texel (4x + channel, y, z) holds red, green, blue and the count of voxel (x, y, z)
+layout(r32ui, binding = 0) uniform uimage3D accumulation;
+
+// Same decoding as voxel_attributes::unpackNormal in src/voxel_attributes.h
+vec3 unpackNormal(uint bits)
+{
+    const vec2 octahedral = unpackSnorm2x16(bits);
+    vec3 normal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+    const float fold = max(-normal.z, 0.0);
+    normal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(normal.xy, vec2(0.0)));
+    return normalize(normal);
+}
+
+void main()
+{
+    const uint count = countFromCommand ? min(instanceCount, maxInstances) : maxInstances;
+    const uint stride = gl_NumWorkGroups.x * gl_WorkGroupSize.x;
+    const ivec3 volumeSize = imageSize(accumulation) / ivec3(4, 1, 1);
+    for (uint instance = gl_GlobalInvocationID.x; instance < count; instance += stride) {
+        const uvec3 gridPos = (uvec3(packedGridPositions[instance]) >> uvec3(0, 10, 20)) & 0x3ffu;
+        const vec3 center = gridOrigin + (vec3(gridPos) + 0.5) * voxelScale;
+        const ivec3 volumePos = ivec3(floor((center - volumeMin) / volumeVoxelScale));
+        if (any(lessThan(volumePos, ivec3(0))) || any(greaterThanEqual(volumePos, volumeSize)))
+            continue;
+
+        // The average of the clamped cosine over all orientations is 1/4
+        vec3 albedo = vec3(1.0);
+        float cosine = 0.25;
+        if (hasAttributes) {
+            const vec4 voxelAlbedo = unpackUnorm4x8(packedAttributes[instance].y);
+            if (voxelAlbedo.a > 0.0) {
+                albedo = voxelAlbedo.rgb;
+                cosine = max(dot(unpackNormal(packedAttributes[instance].x), normalize(lightPos - center)), 0.0);
+            }
+        }
+        const uvec3 radiance = uvec3(round(max(albedo * lightColor * cosine, vec3(0.0)) * fixedPointScale));
+        const ivec3 base = ivec3(4 * volumePos.x, volumePos.yz);
+        imageAtomicAdd(accumulation, base, radiance.r);
+        imageAtomicAdd(accumulation, base + ivec3(1, 0, 0), radiance.g);
+        imageAtomicAdd(accumulation, base + ivec3(2, 0, 0), radiance.b);
+        imageAtomicAdd(accumulation, base + ivec3(3, 0, 0), 1u);
+    }
+}
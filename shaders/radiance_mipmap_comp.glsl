@@ -0,0 +1,60 @@
+#version 450
+
+// Filters one level of the six directional radiance volumes (+x, -x, +y, -y, +z, -z) from the level before it,
+// or level 0 from the radiance volume. Every texel composites its 2x2x2 children front to back along its
+// direction and averages the four results.
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+layout(location = 0) uniform int sourceLevel; // -1: the radiance volume
+layout(location = 1) uniform int sourceLength;
+
+layout(binding = 0) uniform sampler3D radiance;
+layout(binding = 1) uniform sampler3D directionalRadiance[6];
+
+layout(rgba16f, binding = 0) writeonly uniform image3D targets[6];
+
+vec4 fetchChild(int direction, ivec3 position)
+{
+    position = min(position, ivec3(sourceLength - 1));
+    return sourceLevel < 0 ? texelFetch(radiance, position, 0) : texelFetch(directionalRadiance[direction], position, sourceLevel);
+}
+
+// Premultiplied colors, front occludes back
+vec4 composite(vec4 front, vec4 back)
+{
+    return front + (1.0 - front.a) * back;
+}
+
+vec4 filterDirection(int direction, ivec3 base)
+{
+    const int axis = direction / 2;
+    // A cone looking along +x meets the child with the lower x first
+    const int frontOffset = direction % 2 == 0 ? 0 : 1;
+    vec4 sum = vec4(0.0);
+    for (int i = 0; i < 4; ++i) {
+        ivec3 front = base, back = base;
+        front[axis] += frontOffset;
+        back[axis] += 1 - frontOffset;
+        const ivec2 across = ivec2(i & 1, i >> 1);
+        front[(axis + 1) % 3] += across.x;
+        back[(axis + 1) % 3] += across.x;
+        front[(axis + 2) % 3] += across.y;
+        back[(axis + 2) % 3] += across.y;
+        sum += composite(fetchChild(direction, front), fetchChild(direction, back));
+    }
+    return 0.25 * sum;
+}
+
+void main()
+{
+    const ivec3 position = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(position, imageSize(targets[0]))))
+        return;
+    const ivec3 base = 2 * position;
+    imageStore(targets[0], position, filterDirection(0, base));
+    imageStore(targets[1], position, filterDirection(1, base));
+    imageStore(targets[2], position, filterDirection(2, base));
+    imageStore(targets[3], position, filterDirection(3, base));
+    imageStore(targets[4], position, filterDirection(4, base));
+    imageStore(targets[5], position, filterDirection(5, base));
+}
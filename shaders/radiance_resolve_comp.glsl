@@ -0,0 +1,24 @@
+#version 450
+
+// Writes the average of the radiance (radiance_inject_comp.glsl) or flux (rsm_inject_comp.glsl) summed into every
+// voxel to the radiance volume, opaque. Voxels nothing was added to keep what was written before.
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+layout(location = 0) uniform float fixedPointScale;
+
+layout(r32ui, binding = 0) readonly uniform uimage3D accumulation;
+layout(rgba16f, binding = 1) writeonly uniform image3D radiance;
+
+void main()
+{
+    const ivec3 voxel = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(voxel, imageSize(radiance))))
+        return;
+    const ivec3 base = ivec3(4 * voxel.x, voxel.yz);
+    const uint count = imageLoad(accumulation, base + ivec3(3, 0, 0)).r;
+    if (count == 0u)
+        return;
+    const vec3 sum = vec3(imageLoad(accumulation, base).r, imageLoad(accumulation, base + ivec3(1, 0, 0)).r,
+        imageLoad(accumulation, base + ivec3(2, 0, 0)).r);
+    imageStore(radiance, voxel, vec4(sum / (fixedPointScale * float(count)), 1.0));
+}
@@ -0,0 +1,34 @@
+#version 450
+
+layout(std140) uniform Material // Must match the GPUMaterial defined in src/mesh.h
+{
+    vec3 kd;
+	vec3 ks;
+	float shininess;
+	float transparency;
+};
+
+layout(location = 3) uniform sampler2D colorMap;
+layout(location = 4) uniform bool hasTexCoords;
+layout(location = 5) uniform bool useMaterial;
+layout(location = 6) uniform vec3 lightPos;
+layout(location = 7) uniform vec3 lightColor;
+
+in vec3 fragPosition;
+in vec3 fragNormal;
+in vec2 fragTexCoord;
+
+// Reflective shadow map, see ReflectiveShadowMap: world position (w = 1 marks a surface), world normal, flux
+layout(location = 0) out vec4 rsmPosition;
+layout(location = 1) out vec4 rsmNormal;
+layout(location = 2) out vec4 rsmFlux;
+
+void main()
+{
+    const vec3 normal = normalize(fragNormal);
+    // Same albedo as the screen G-buffer, see gbuffer_frag.glsl
+    const vec3 albedo = hasTexCoords ? texture(colorMap, fragTexCoord).rgb : (useMaterial ? kd : vec3(1.0));
+    rsmPosition = vec4(fragPosition, 1.0);
+    rsmNormal = vec4(normal, 0.0);
+    rsmFlux = vec4(albedo * lightColor * max(dot(normal, normalize(lightPos - fragPosition)), 0.0), 1.0);
+}
@@ -0,0 +1,39 @@
+#version 450
+
+// Adds the flux of every reflective shadow map texel to the voxel of the radiance volume its surface lies in, as
+// fixed point sums with a count, see VoxelConeTracer::injectReflectiveShadowMap.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform vec3 volumeMin;
+layout(location = 1) uniform float volumeVoxelScale;
+layout(location = 2) uniform int volumeLength;
+layout(location = 3) uniform float fixedPointScale;
+
+layout(binding = 0) uniform sampler2D rsmPositions; // w = 0 where the light sees nothing
+layout(binding = 1) uniform sampler2D rsmNormals;
+layout(binding = 2) uniform sampler2D rsmFlux;
+
+// Texel (4x + channel, y, z) holds red, green, blue and the count of voxel (x, y, z)
+layout(r32ui, binding = 0) uniform uimage3D accumulation;
+
+void main()
+{
+    const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, textureSize(rsmPositions, 0))))
+        return;
+    const vec4 position = texelFetch(rsmPositions, texel, 0);
+    if (position.w == 0.0)
+        return;
+    // Half a voxel below the surface, so surfaces on a voxel face land in the voxel behind them
+    const vec3 inside = position.xyz - 0.5 * volumeVoxelScale * texelFetch(rsmNormals, texel, 0).xyz;
+    const ivec3 voxel = ivec3(floor((inside - volumeMin) / volumeVoxelScale));
+    if (any(lessThan(voxel, ivec3(0))) || any(greaterThanEqual(voxel, ivec3(volumeLength))))
+        return;
+
+    const uvec3 flux = uvec3(round(max(texelFetch(rsmFlux, texel, 0).rgb, vec3(0.0)) * fixedPointScale));
+    const ivec3 base = ivec3(4 * voxel.x, voxel.yz);
+    imageAtomicAdd(accumulation, base, flux.r);
+    imageAtomicAdd(accumulation, base + ivec3(1, 0, 0), flux.g);
+    imageAtomicAdd(accumulation, base + ivec3(2, 0, 0), flux.b);
+    imageAtomicAdd(accumulation, base + ivec3(3, 0, 0), 1u);
+}
@@ -0,0 +1,11 @@
+#version 450
+
+// Full screen triangle, drawn with glDrawArrays(GL_TRIANGLES, 0, 3) and no vertex attributes
+out vec2 screenTexCoord;
+
+void main()
+{
+    const vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    screenTexCoord = corner;
+    gl_Position = vec4(2.0 * corner - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,87 @@
+#version 450
+
+// Blends the new samples of every G-buffer pixel into its reprojected history, see TemporalAccumulator.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform mat4 viewProjection;
+layout(location = 1) uniform mat4 previousViewProjection;
+layout(location = 2) uniform bool historyValid;
+layout(location = 3) uniform float historyLength;
+layout(location = 4) uniform float depthTolerance; // relative
+layout(location = 5) uniform float minNormalCosine;
+
+layout(binding = 0) uniform sampler2D positions; // G-buffer, w = 0 where no surface was rendered
+layout(binding = 1) uniform sampler2D normals;
+layout(binding = 2) uniform sampler2D samples;
+layout(binding = 3) uniform sampler2D history;
+layout(binding = 4) uniform sampler2D historyGeometry; // octahedral normal, view depth, frame count
+
+layout(rgba16f, binding = 0) writeonly uniform image2D accumulated;
+layout(rgba32f, binding = 1) writeonly uniform image2D accumulatedGeometry;
+
+vec2 packOctahedral(vec3 normal)
+{
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+    if (normal.z < 0.0)
+        normal.xy = (1.0 - abs(normal.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(normal.xy, vec2(0.0)));
+    return normal.xy;
+}
+
+vec3 unpackOctahedral(vec2 octahedral)
+{
+    vec3 normal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+    const float fold = max(-normal.z, 0.0);
+    normal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(normal.xy, vec2(0.0)));
+    return normalize(normal);
+}
+
+void main()
+{
+    const ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 size = imageSize(accumulated);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+    const vec4 position = texelFetch(positions, pixel, 0);
+    if (position.w == 0.0) {
+        imageStore(accumulated, pixel, vec4(0.0));
+        imageStore(accumulatedGeometry, pixel, vec4(0.0));
+        return;
+    }
+    const vec3 normal = normalize(texelFetch(normals, pixel, 0).xyz);
+    const vec4 current = texelFetch(samples, pixel, 0);
+
+    // Bilinear filter of the history texels around the reprojected point that saw the same surface
+    vec4 previous = vec4(0.0);
+    float previousFrames = 0.0;
+    float weightSum = 0.0;
+    const vec4 previousClip = previousViewProjection * vec4(position.xyz, 1.0);
+    if (historyValid && previousClip.w > 0.0) {
+        const vec2 texel = (0.5 * previousClip.xy / previousClip.w + 0.5) * vec2(size) - 0.5;
+        const ivec2 base = ivec2(floor(texel));
+        const vec2 f = texel - vec2(base);
+        for (int tap = 0; tap < 4; ++tap) {
+            const ivec2 offset = ivec2(tap & 1, tap >> 1);
+            const ivec2 tapPixel = base + offset;
+            if (any(lessThan(tapPixel, ivec2(0))) || any(greaterThanEqual(tapPixel, size)))
+                continue;
+            const vec4 geometry = texelFetch(historyGeometry, tapPixel, 0);
+            if (geometry.w == 0.0 || abs(geometry.z - previousClip.w) > depthTolerance * previousClip.w
+                || dot(unpackOctahedral(geometry.xy), normal) < minNormalCosine)
+                continue;
+            const vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+            const float weight = bilinear.x * bilinear.y;
+            previous += weight * texelFetch(history, tapPixel, 0);
+            previousFrames += weight * geometry.w;
+            weightSum += weight;
+        }
+    }
+
+    float frames = 1.0;
+    vec4 result = current;
+    if (weightSum > 1e-3) {
+        frames = min(previousFrames / weightSum + 1.0, historyLength);
+        result = mix(previous / weightSum, current, 1.0 / frames);
+    }
+    imageStore(accumulated, pixel, result);
+    imageStore(accumulatedGeometry, pixel, vec4(packOctahedral(normal), (viewProjection * vec4(position.xyz, 1.0)).w, frames));
+}
@@ -0,0 +1,43 @@
+#version 450
+
+// Sets the bit of every voxel instance in the binary voxelization, see VoxelRayCaster. Invocations loop over the
+// instances, so a fixed number of work groups covers any instance count.
+layout(local_size_x = 64) in;
+
+layout(location = 0) uniform uint maxInstances;
+layout(location = 1) uniform bool countFromCommand; // the instance count is in DrawCommand, maxInstances is the capacity
+layout(location = 2) uniform vec3 gridOrigin; // world space minimum corner of the voxel at packed position 0
+layout(location = 3) uniform float voxelScale;
+layout(location = 4) uniform vec3 bitmaskMin;
+layout(location = 5) uniform float cellSize;
+layout(location = 6) uniform int bitmaskLength;
+
+// 10:10:10 packed grid positions, x in the lowest bits (see voxel_instance.h)
+layout(std430, binding = 1) readonly buffer VoxelInstances
+{
+    uint packedGridPositions[];
+};
+
+// DrawElementsIndirectCommand of the GPU voxelizer
+layout(std430, binding = 3) readonly buffer DrawCommand
+{
+    uint indexCount;
+    uint instanceCount;
+};
+
+// Bit z % 32 of layer z / 32 is the voxel (x, y, z)
+layout(r32ui, binding = 0) uniform uimage2DArray bitmask;
+
+void main()
+{
+    const uint count = countFromCommand ? min(instanceCount, maxInstances) : maxInstances;
+    const uint stride = gl_NumWorkGroups.x * gl_WorkGroupSize.x;
+    for (uint instance = gl_GlobalInvocationID.x; instance < count; instance += stride) {
+        const uvec3 gridPos = (uvec3(packedGridPositions[instance]) >> uvec3(0, 10, 20)) & 0x3ffu;
+        const vec3 center = gridOrigin + (vec3(gridPos) + 0.5) * voxelScale;
+        const ivec3 cell = ivec3(floor((center - bitmaskMin) / cellSize));
+        if (any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, ivec3(bitmaskLength))))
+            continue;
+        imageAtomicOr(bitmask, ivec3(cell.xy, cell.z >> 5), 1u << uint(cell.z & 31));
+    }
+}
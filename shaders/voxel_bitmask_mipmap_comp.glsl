@@ -0,0 +1,25 @@
+#version 450
+
+// Builds one level of the binary voxelization from the level before it: every texel is the OR of its 2x2
+// children in x and y, z keeps its full resolution.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform int sourceLevel;
+
+layout(binding = 0) uniform usampler2DArray bitmask;
+
+layout(r32ui, binding = 0) writeonly uniform uimage2DArray target;
+
+void main()
+{
+    const ivec3 size = imageSize(target);
+    const ivec3 texel = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(texel, size)))
+        return;
+    const ivec2 child = 2 * texel.xy;
+    const uint bits = texelFetch(bitmask, ivec3(child, texel.z), sourceLevel).r
+        | texelFetch(bitmask, ivec3(child + ivec2(1, 0), texel.z), sourceLevel).r
+        | texelFetch(bitmask, ivec3(child + ivec2(0, 1), texel.z), sourceLevel).r
+        | texelFetch(bitmask, ivec3(child + ivec2(1, 1), texel.z), sourceLevel).r;
+    imageStore(target, texel, uvec4(bits));
+}
@@ -14,6 +14,8 @@ layout(location = 4) uniform vec3 lightPos;
 in vec3 fragPosition;
 in vec3 fragNormal;
 in vec2 fragTexCoord;
+in vec3 fragVoxelNormal; // average surface normal of the voxel, the face normal for voxels without attributes
+in vec4 fragAlbedo; // average albedo of the voxel, alpha 0 for voxels without attributes
 
 layout(location = 0) out vec4 fragColor;
 
@@ -23,11 +25,16 @@ void main()
     vec3 lightDir = normalize(lightPos - fragPosition);
     
     vec3 diffuse = max(dot(fragNormal, lightDir), 0.0) * lightColor;
+    if (fragAlbedo.a > 0.0) {
+        diffuse *= fragAlbedo.rgb;
+    }
 
     if (shadingMode == 0) {
         fragColor = vec4(diffuse, 1.0);
     } else if (shadingMode == 1) {
         fragColor = vec4(fragPosition, 1.0);
+    } else if (shadingMode == 2) {
+        fragColor = vec4(fragVoxelNormal * 0.5 + 0.5, 1.0);
     } else {
         fragColor = vec4(0.0);
     }
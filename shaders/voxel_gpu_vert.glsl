@@ -0,0 +1,34 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+layout(location = 0) uniform mat4 projectionMatrix;
+layout(location = 1) uniform mat4 viewMatrix;
+layout(location = 5) uniform vec3 gridOrigin; // world space minimum corner of the voxel at packed position 0
+layout(location = 6) uniform float voxelScale;
+
+// Written by compact_voxels_comp.glsl, one 10:10:10 packed grid position per instance (same as voxel_vert.glsl)
+layout(std430, binding = 1) readonly buffer VoxelInstances
+{
+    uint packedGridPositions[];
+};
+
+out vec3 fragPosition;
+out vec3 fragNormal;
+out vec2 fragTexCoord;
+out vec3 fragVoxelNormal;
+out vec4 fragAlbedo; // no voxel attributes, alpha 0
+
+void main()
+{
+    // Cubes are only translated and uniformly scaled, so normals need no transformation
+    const uvec3 gridPos = (uvec3(packedGridPositions[gl_InstanceID]) >> uvec3(0, 10, 20)) & 0x3ffu;
+    fragPosition = gridOrigin + (vec3(gridPos) + 0.5 + position) * voxelScale;
+    gl_Position = projectionMatrix * viewMatrix * vec4(fragPosition, 1.0);
+
+    fragNormal = normal;
+    fragTexCoord = vec2(0.0);
+    fragVoxelNormal = normal;
+    fragAlbedo = vec4(0.0);
+}
@@ -0,0 +1,27 @@
+#version 450
+
+// Greedy meshed voxel surface, positions are in grid units (see src/greedy_mesher.h)
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+layout(location = 0) uniform mat4 projectionMatrix;
+layout(location = 1) uniform mat4 viewMatrix;
+layout(location = 5) uniform vec3 gridOrigin; // world space minimum corner of the voxel grid
+layout(location = 6) uniform float voxelScale;
+
+out vec3 fragPosition;
+out vec3 fragNormal;
+out vec2 fragTexCoord;
+out vec3 fragVoxelNormal;
+out vec4 fragAlbedo; // no voxel attributes, alpha 0
+
+void main()
+{
+    fragPosition = gridOrigin + position * voxelScale;
+    gl_Position = projectionMatrix * viewMatrix * vec4(fragPosition, 1.0);
+
+    fragNormal = normal;
+    fragTexCoord = vec2(0.0);
+    fragVoxelNormal = normal;
+    fragAlbedo = vec4(0.0);
+}
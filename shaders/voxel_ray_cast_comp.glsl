@@ -0,0 +1,150 @@
+#version 450
+
+// Near-field indirect light (Thiedemann et al. 2011): casts short rays from every G-buffer pixel through the
+// binary voxelization and looks up the direct light of the voxels they hit in the reflective shadow map, see
+// VoxelRayCaster.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform vec3 bitmaskMin;
+layout(location = 1) uniform float cellSize;
+layout(location = 2) uniform int bitmaskLength;
+layout(location = 3) uniform int maxLevel;
+layout(location = 4) uniform int rayCount;
+layout(location = 5) uniform float rayLength;
+layout(location = 6) uniform mat4 lightViewProjection;
+layout(location = 10) uniform uint frame;
+layout(location = 11) uniform int frameCount; // the rays are spread over this many frames, see SampleInterleave
+
+layout(binding = 0) uniform sampler2D positions; // G-buffer, w = 0 where no surface was rendered
+layout(binding = 1) uniform sampler2D normals;
+layout(binding = 2) uniform usampler2DArray bitmask; // bit z % 32 of layer z / 32, levels OR 2x2 columns
+layout(binding = 3) uniform sampler2D rsmPositions; // reflective shadow map, w = 0 where the light sees nothing
+layout(binding = 4) uniform sampler2D rsmNormals;
+layout(binding = 5) uniform sampler2D rsmFlux;
+
+layout(rgba16f, binding = 0) writeonly uniform image2D indirect;
+
+const float goldenAngle = 2.39996323;
+const float pi = 3.14159265;
+const int maxSteps = 512;
+const int bayer4x4[16] = int[](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+
+// The first occupied cell of a column at a level between the cells zFirst and zLast, in the order the ray visits
+// them, or -1
+int firstInColumn(ivec2 column, int level, int zFirst, int zLast)
+{
+    const bool up = zLast >= zFirst;
+    const int zMin = min(zFirst, zLast);
+    const int zMax = max(zFirst, zLast);
+    const int wordStep = up ? 1 : -1;
+    for (int word = zFirst >> 5; word != (zLast >> 5) + wordStep; word += wordStep) {
+        const int low = max(zMin - 32 * word, 0);
+        const int high = min(zMax - 32 * word, 31);
+        const uint bits = texelFetch(bitmask, ivec3(column, word), level).r & (0xffffffffu >> uint(31 - high)) & (0xffffffffu << uint(low));
+        if (bits != 0u)
+            return 32 * word + (up ? findLSB(bits) : findMSB(bits));
+    }
+    return -1;
+}
+
+// Hierarchical traversal of the columns the ray passes in x and y, in cells: a column that has a voxel in the z
+// range the ray crosses is refined one level down, an empty one is skipped and the traversal continues a level up.
+bool castRay(vec3 origin, vec3 dir, float tMax, out ivec3 hit)
+{
+    // Axis parallel rays would divide by zero at the cell planes
+    dir = mix(dir, vec3(1e-6), lessThan(abs(dir), vec3(1e-6)));
+    const vec3 invDir = 1.0 / dir;
+    int level = 0;
+    float t = 0.0;
+    for (int i = 0; i < maxSteps && t < tMax; ++i) {
+        const float size = float(1 << level);
+        const ivec2 column = ivec2(floor((origin.xy + t * dir.xy) / size));
+        if (any(lessThan(column, ivec2(0))) || any(greaterThanEqual(column, ivec2(max(bitmaskLength >> level, 1)))))
+            return false;
+        const vec2 exitPlanes = (vec2(column) + step(0.0, dir.xy)) * size;
+        const vec2 tExits = (exitPlanes - origin.xy) * invDir.xy;
+        const float tExit = clamp(min(tExits.x, tExits.y), t, tMax);
+        const float zEnter = origin.z + t * dir.z;
+        const float zExit = origin.z + tExit * dir.z;
+        if (max(zEnter, zExit) >= 0.0 && min(zEnter, zExit) < float(bitmaskLength)) {
+            const int zFirst = clamp(int(floor(zEnter)), 0, bitmaskLength - 1);
+            const int zLast = clamp(int(floor(zExit)), 0, bitmaskLength - 1);
+            const int z = firstInColumn(column, level, zFirst, zLast);
+            if (z >= 0) {
+                if (level == 0) {
+                    hit = ivec3(column, z);
+                    return true;
+                }
+                --level;
+                continue;
+            }
+        }
+        t = tExit + 1e-3;
+        level = min(level + 1, maxLevel);
+    }
+    return false;
+}
+
+// Direct light the reflective shadow map holds for the voxel, zero when the light does not see it or the ray
+// arrives at its back
+vec3 voxelRadiance(ivec3 cell, vec3 dir)
+{
+    const vec3 center = bitmaskMin + (vec3(cell) + 0.5) * cellSize;
+    const vec4 clip = lightViewProjection * vec4(center, 1.0);
+    if (clip.w <= 0.0)
+        return vec3(0.0);
+    const vec2 uv = 0.5 * clip.xy / clip.w + 0.5;
+    if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0))))
+        return vec3(0.0);
+    // The surface the light sees in the direction of the voxel lies in or next to the voxel when it is lit
+    const vec4 lit = textureLod(rsmPositions, uv, 0.0);
+    if (lit.w == 0.0 || any(greaterThan(abs(lit.xyz - center), vec3(cellSize))))
+        return vec3(0.0);
+    if (dot(textureLod(rsmNormals, uv, 0.0).xyz, dir) >= 0.0)
+        return vec3(0.0);
+    return textureLod(rsmFlux, uv, 0.0).rgb;
+}
+
+// Interleaved gradient noise (Jimenez 2014)
+float pixelNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+    const ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, imageSize(indirect))))
+        return;
+    const vec4 position = texelFetch(positions, pixel, 0);
+    if (position.w == 0.0) {
+        imageStore(indirect, pixel, vec4(0.0));
+        return;
+    }
+    const vec3 normal = normalize(texelFetch(normals, pixel, 0).xyz);
+    const vec3 tangent = normalize(cross(normal, abs(normal.x) < 0.9 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0)));
+    const vec3 bitangent = cross(normal, tangent);
+    // Start outside the voxels of the surface itself, in cells of the bitmask
+    const vec3 origin = (position.xyz + 1.75 * cellSize * normal - bitmaskMin) / cellSize;
+
+    // Cosine weighted Fibonacci points, rotated and jittered per pixel so neighbouring pixels sample other directions.
+    // This frame casts every frameCount-th.
+    const float rotation = 2.0 * pi * pixelNoise(vec2(pixel));
+    const float jitter = pixelNoise(vec2(pixel) + vec2(17.0, 59.0));
+    const int firstRay = int((uint(bayer4x4[4 * (pixel.y & 3) + (pixel.x & 3)]) + frame) % uint(frameCount));
+    vec3 radiance = vec3(0.0);
+    float occlusion = 0.0;
+    int castCount = 0;
+    for (int ray = firstRay; ray < rayCount; ray += frameCount, ++castCount) {
+        const float cosTheta = sqrt(1.0 - (float(ray) + jitter) / float(rayCount));
+        const float sinTheta = sqrt(max(1.0 - cosTheta * cosTheta, 0.0));
+        const float phi = goldenAngle * float(ray) + rotation;
+        const vec3 dir = normalize(sinTheta * (cos(phi) * tangent + sin(phi) * bitangent) + cosTheta * normal);
+        ivec3 hit;
+        if (castRay(origin, dir, rayLength / cellSize, hit)) {
+            radiance += voxelRadiance(hit, dir);
+            occlusion += 1.0;
+        }
+    }
+    imageStore(indirect, pixel, vec4(radiance, occlusion) / float(max(castCount, 1)));
+}
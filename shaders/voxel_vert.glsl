@@ -3,21 +3,35 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texCoord;
-layout(location = 3) in mat4 modelMatrix; // passed as attribute
+layout(location = 3) in uint packedGridPosition; // per instance, 10:10:10 bits relative to gridOrigin
+layout(location = 4) in uvec2 packedAttributes; // per instance, octahedral normal (snorm16 x2) and albedo (RGBA8)
 
 layout(location = 0) uniform mat4 projectionMatrix;
 layout(location = 1) uniform mat4 viewMatrix;
+layout(location = 5) uniform vec3 gridOrigin; // world space minimum corner of the voxel at packed position 0
+layout(location = 6) uniform float voxelScale;
 
 out vec3 fragPosition;
 out vec3 fragNormal;
 out vec2 fragTexCoord;
+out vec3 fragVoxelNormal;
+out vec4 fragAlbedo;
 
 void main()
 {
-    mat4 mvpMatrix = projectionMatrix * viewMatrix * modelMatrix;
-    gl_Position = mvpMatrix * vec4(position, 1.0);
-    
-    fragPosition = vec3(modelMatrix * vec4(position, 1.0));
-    fragNormal = mat3(transpose(inverse(modelMatrix))) * normal; // compute normal matrix
+    // Cubes are only translated and uniformly scaled, so normals need no transformation
+    const uvec3 gridPos = (uvec3(packedGridPosition) >> uvec3(0, 10, 20)) & 0x3ffu;
+    fragPosition = gridOrigin + (vec3(gridPos) + 0.5 + position) * voxelScale;
+    gl_Position = projectionMatrix * viewMatrix * vec4(fragPosition, 1.0);
+
+    fragNormal = normal;
     fragTexCoord = texCoord;
+
+    // Same decoding as voxel_attributes::unpackNormal in src/voxel_attributes.h, alpha is 0 for voxels without samples
+    fragAlbedo = unpackUnorm4x8(packedAttributes.y);
+    const vec2 octahedral = unpackSnorm2x16(packedAttributes.x);
+    vec3 voxelNormal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+    const float fold = max(-voxelNormal.z, 0.0);
+    voxelNormal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(voxelNormal.xy, vec2(0.0)));
+    fragVoxelNormal = fragAlbedo.a > 0.0 ? normalize(voxelNormal) : normal;
 }
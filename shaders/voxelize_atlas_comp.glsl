@@ -0,0 +1,32 @@
+#version 450
+
+// Bins every valid atlas texel into the voxel grid, one invocation per texel.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(location = 0) uniform mat4 modelMatrix;
+layout(location = 1) uniform vec3 worldMin;
+layout(location = 2) uniform vec3 worldMax;
+layout(location = 3) uniform int gridLength;
+layout(location = 4) uniform float invalidValue; // clear value of texels not covered by the mesh
+
+layout(binding = 0) uniform sampler2D atlas; // object space positions
+// 32 voxels along x per texel, bit x % 32 of texel (x / 32, y, z)
+layout(r32ui, binding = 0) uniform uimage3D occupancy;
+
+void main()
+{
+    const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, textureSize(atlas, 0))))
+        return;
+
+    const vec3 objectPos = texelFetch(atlas, texel, 0).xyz;
+    if (objectPos == vec3(invalidValue))
+        return;
+
+    // Same arithmetic as VoxelGrid::worldToGridPosition for a bounded grid, so both paths agree.
+    precise vec3 worldPos = (modelMatrix * vec4(objectPos, 1.0)).xyz;
+    precise vec3 normalizedPos = clamp((worldPos - worldMin) / (worldMax - worldMin), vec3(0.0), vec3(1.0));
+    const ivec3 gridPos = min(ivec3(floor(normalizedPos * float(gridLength))), ivec3(gridLength - 1));
+
+    imageAtomicOr(occupancy, ivec3(gridPos.x >> 5, gridPos.yz), 1u << (gridPos.x & 31));
+}
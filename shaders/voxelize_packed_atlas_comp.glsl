@@ -0,0 +1,23 @@
+#version 450
+
+// voxelize_atlas_comp.glsl for atlases that already hold packed grid positions (see atlas_packed_frag.glsl),
+// one invocation per texel.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform usampler2D atlas; // 10:10:10 grid positions, bit 31 set for covered texels
+// 32 voxels along x per texel, bit x % 32 of texel (x / 32, y, z)
+layout(r32ui, binding = 0) uniform uimage3D occupancy;
+
+void main()
+{
+    const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, textureSize(atlas, 0))))
+        return;
+
+    const uint packedPos = texelFetch(atlas, texel, 0).r;
+    if ((packedPos >> 31) == 0u)
+        return;
+
+    const ivec3 gridPos = ivec3(packedPos & 1023u, (packedPos >> 10) & 1023u, (packedPos >> 20) & 1023u);
+    imageAtomicOr(occupancy, ivec3(gridPos.x >> 5, gridPos.yz), 1u << (gridPos.x & 31));
+}
@@ -11,16 +11,46 @@ DISABLE_WARNINGS_PUSH()
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
 #include <imgui/imgui.h>
 DISABLE_WARNINGS_POP()
 #include <framework/shader.h>
 #include <framework/window.h>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <optional>
+#include <span>
+#include <string_view>
 #include <vector>
+#include "atlas_rasterizer.h"
+#include "atlas_readback.h"
+#include "atlas_resolution.h"
+#include "bilateral_upsampler.h"
 #include "camera.h"
+#include "g_buffer.h"
+#include "gpu_timings.h"
+#include "gpu_voxelizer.h"
+#include "greedy_mesher.h"
+#include "occupancy_pyramid.h"
+#include "reflective_shadow_map.h"
+#include "solid_fill.h"
+#include "sparse_voxel_octree.h"
+#include "stage_timings.h"
+#include "temporal_accumulator.h"
+#include "texel_cloud_cache.h"
+#include "texel_compaction.h"
+#include "triangle_voxelizer.h"
+#include "uv_unwrapper.h"
+#include "voxel_attributes.h"
+#include "voxel_cone_tracer.h"
+#include "voxel_instance.h"
+#include "voxel_ray_caster.h"
 #include "voxel_grid.cpp"
 
 // The Application class encapsulates the entire application, including setup, event handling, and rendering.
@@ -36,9 +66,19 @@ public:
         loadMeshes();
         loadShaders();
 
+        // translations, the only transform the UI changes, do not change the texel spacing on the surface
+        m_atlasResolution.analyze(m_cpuMeshes, m_modelMatrix);
+        if (m_autoAtlasLength) {
+            atlasLength = automaticAtlasLength();
+        }
+        updateUvCharts();
         setupAtlasShader();
         setupTextureShader();
         setupDebugShader();
+        setupVoxelInstancing();
+        // the screen space lighting passes draw a full screen triangle without vertex attributes
+        glCreateVertexArrays(1, &screenVAO);
+        resetTexelClouds();
     }
 
     // Main game/rendering loop
@@ -57,7 +97,6 @@ public:
     void processInput() {
         static glm::vec3 lastTranslation(0.0f);
         static glm::vec3 translation(0.0f);
-        const std::vector<int> atlasSizes = { 22, 44, 88, 176, 368, 768, 1280  };
         m_window.updateInput();
         m_camera.updateInput();
         //std::cout << m_camera.toString() << std::endl; // debug camera position and forward if needed
@@ -73,6 +112,7 @@ public:
             auto it = std::find(atlasSizes.begin(), atlasSizes.end(), atlasLength);
             if (it != atlasSizes.end() && it != atlasSizes.begin()) {
                 atlasLength = *(--it);
+                m_autoAtlasLength = false;
                 resetAtlasTexture();
                 recalculateVoxelGrid();
             }
@@ -82,6 +122,7 @@ public:
             auto it = std::find(atlasSizes.begin(), atlasSizes.end(), atlasLength);
             if (it != atlasSizes.end() && (it + 1) != atlasSizes.end()) {
                 atlasLength = *(++it);
+                m_autoAtlasLength = false;
                 resetAtlasTexture();
                 recalculateVoxelGrid();
             }
@@ -89,21 +130,175 @@ public:
 
         ImGui::SameLine();
         ImGui::Text("%d", atlasLength);
+        if (ImGui::Checkbox("Automatic atlas length", &m_autoAtlasLength) && m_autoAtlasLength && selectAtlasLength()) {
+            recalculateVoxelGrid();
+        }
+        {
+            const float voxelScale = m_voxelGrid.worldLength / float(m_finestGridLength);
+            const int requiredLength = m_atlasResolution.requiredLength(voxelScale);
+            ImGui::Text("Surface with texels within a voxel: %.1f%% (length %d needed)",
+                100.0 * m_atlasResolution.spacingMetFraction(atlasLength, voxelScale), requiredLength);
+            if (m_autoAtlasLength && requiredLength > atlasSizes.back()) {
+                ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "Atlas length capped at %d, texels lie further apart than a voxel", atlasSizes.back());
+            }
+        }
 
         ImGui::Text("Voxel Grid Length");
         ImGui::SameLine();
-        if (ImGui::Button("/2")) {
-            m_voxelGrid.gridLength /= 2;
-            recalculateVoxelGrid();
+        if (ImGui::Button("/2") && m_voxelGrid.gridLength > 1) {
+            selectGridLength(m_voxelGrid.gridLength / 2);
         }
         ImGui::SameLine();
-        if (ImGui::Button("*2")) {
-            m_voxelGrid.gridLength *= 2;
-            recalculateVoxelGrid();
+        if (ImGui::Button("*2") && m_voxelGrid.gridLength < voxel_instance::maxGridLength) {
+            selectGridLength(m_voxelGrid.gridLength * 2);
         }
 
         ImGui::SameLine();
         ImGui::Text("%d", m_voxelGrid.gridLength);
+        if (ImGui::Checkbox("Morton-ordered voxel list", &m_voxelGrid.mortonOrder)) {
+            recalculateVoxelGrid();
+        }
+        if (ImGui::Combo("Voxelization engine", &m_voxelEngine, "Atlas\0Triangles (SAT)\0")) {
+            // The triangle engine writes the dense occupancy volume only
+            if (m_voxelEngine == 1) {
+                m_voxelGrid.unbounded = false;
+            }
+            recalculateVoxelGrid();
+        }
+        if (ImGui::Checkbox("Solid voxels", &m_solidVoxels)) {
+            revoxelize();
+        }
+        if (ImGui::Checkbox("Unbounded voxel grid", &m_voxelGrid.unbounded)) {
+            if (m_voxelGrid.unbounded) {
+                m_voxelEngine = 0;
+                if (m_atlasEncoding == 2) {
+                    m_atlasEncoding = 0;
+                    resetAtlasTexture();
+                }
+            }
+            recalculateVoxelGrid();
+        }
+        if (ImGui::Combo("Atlas encoding", &m_atlasEncoding, "RGB32F positions\0RGB16F positions\0R32UI packed voxels\0")) {
+            // Packed voxels are quantized to the bounds of the grid
+            if (m_atlasEncoding == 2) {
+                m_voxelGrid.unbounded = false;
+            }
+            resetAtlasTexture();
+            recalculateVoxelGrid();
+        }
+        if (ImGui::Checkbox("Read back atlas attributes", &m_readAtlasAttributes)) {
+            recalculateVoxelGrid();
+        }
+        if (ImGui::Checkbox("Conservative atlas rasterization", &m_conservativeAtlas)) {
+            recalculateVoxelGrid();
+        }
+        if (ImGui::Checkbox("Generate UV charts", &m_generateUvCharts)) {
+            // The cached texel clouds were sampled with the other UV layout
+            m_texelCloudCache.clear();
+            loadMeshes();
+            m_atlasResolution.analyze(m_cpuMeshes, m_modelMatrix);
+            if (m_autoAtlasLength) {
+                selectAtlasLength();
+            }
+            recalculateVoxelGrid();
+        }
+        if (ImGui::InputInt("Jittered atlas passes", &m_atlasJitterPasses)) {
+            m_atlasJitterPasses = std::clamp(m_atlasJitterPasses, 1, 64);
+            recalculateVoxelGrid();
+        }
+        ImGui::Text("Atlas readback: %zu bytes per texel", atlasReadbackBytesPerTexel());
+        if (ImGui::Checkbox("Asynchronous atlas readback", &m_asyncReadback)) {
+            recalculateVoxelGrid();
+        }
+        if (ImGui::Checkbox("CPU atlas rasterizer", &m_cpuAtlas)) {
+            recalculateVoxelGrid();
+        }
+        if (ImGui::InputInt("Atlas cache budget (MB)", &m_atlasCacheBudgetMB)) {
+            m_atlasCacheBudgetMB = std::max(m_atlasCacheBudgetMB, 0);
+            m_texelCloudCache.setBudget(size_t(m_atlasCacheBudgetMB) << 20);
+        }
+        ImGui::Text("Atlas cache: %zu clouds, %zu KB, %zu hits, %zu misses, %zu evicted", m_texelCloudCache.size(), m_texelCloudCache.memoryBytes() / 1024,
+            m_texelCloudCache.hits(), m_texelCloudCache.misses(), m_texelCloudCache.evictions());
+        if (ImGui::Checkbox("GPU voxelization", &m_gpuVoxelization)) {
+            recalculateVoxelGrid();
+        }
+        if (m_gpuVoxelization) {
+            ImGui::SameLine();
+            if (ImGui::Button("Cross-check with CPU")) {
+                crossCheckGpuVoxels();
+            }
+        }
+        if (ImGui::Checkbox("Greedy meshed voxels", &m_greedyMeshing) && m_greedyMeshing && !voxelInstances.empty()) {
+            buildVoxelMesh();
+        }
+        ImGui::Text("Voxels: %zu (octree: %zu nodes, %zu KB)", voxelInstances.size(), m_octree.nodeCount(), m_octree.memoryBytes() / 1024);
+        ImGui::Text("Triangles: %zu instanced, %zu greedy meshed", voxelInstances.size() * 12, m_greedyMesher.quadCount() * 2);
+        if (ImGui::CollapsingHeader("Indirect lighting")) {
+            if (ImGui::Combo("Indirect light", &m_giTechnique, "Off\0Voxel cone tracing\0Near-field ray casting\0")) {
+                m_gpuTimings.clear();
+                m_temporalAccumulator.reset();
+            }
+            if (m_giTechnique == 1) {
+                if (ImGui::InputInt("Diffuse cones", &m_coneTraceSettings.coneCount)) {
+                    m_coneTraceSettings.coneCount = std::clamp(m_coneTraceSettings.coneCount, 1, VoxelConeTracer::maxConeCount);
+                }
+                ImGui::SliderFloat("Cone distance", &m_coneTraceSettings.maxDistance, 0.1f, 2.0f * m_voxelGrid.worldLength);
+                ImGui::Checkbox("Glossy cone", &m_coneTraceSettings.glossy);
+                ImGui::SliderFloat("Glossy aperture (deg)", &m_coneTraceSettings.glossyAperture, 1.0f, 45.0f);
+                if (ImGui::Combo("Radiance injection", &m_radianceInjection, "Reflective shadow map\0Voxel Lambert (unshadowed)\0")) {
+                    m_gpuTimings.clear();
+                    m_temporalAccumulator.reset();
+                }
+                ImGui::Text("Radiance volume: %d^3", m_coneTracer.volumeLength());
+            } else if (m_giTechnique == 2) {
+                ImGui::SliderInt("Rays per pixel", &m_rayCastSettings.rayCount, 1, VoxelRayCaster::maxRayCount);
+                ImGui::SliderFloat("Ray length", &m_rayCastSettings.rayLength, 0.01f, 0.5f * m_voxelGrid.worldLength);
+                ImGui::Text("Voxel bitmask: %d^3", m_rayCaster.bitmaskLength());
+            }
+            if (m_giTechnique == 2 || (m_giTechnique == 1 && m_radianceInjection == 0)) {
+                // The texels of the shadow map are injected or looked up, their number fixes the cost
+                int rsmLengthIndex = std::countr_zero(unsigned(m_rsmLength)) - 8;
+                if (ImGui::Combo("Shadow map size", &rsmLengthIndex, "256^2\0" "512^2\0" "1024^2\0" "2048^2\0")) {
+                    m_rsmLength = 256 << rsmLengthIndex;
+                }
+            }
+            ImGui::Checkbox("Temporal accumulation", &m_temporalSettings.enabled);
+            if (m_temporalSettings.enabled) {
+                int spreadIndex = std::countr_zero(unsigned(m_raySpreadFrames));
+                if (ImGui::Combo("Spread rays over", &spreadIndex, "1 frame\0" "2 frames\0" "4 frames\0" "8 frames\0" "16 frames\0")) {
+                    m_raySpreadFrames = 1 << spreadIndex;
+                }
+                ImGui::SliderInt("History length", &m_temporalSettings.historyLength, 1, 64);
+                ImGui::SliderFloat("Depth tolerance", &m_temporalSettings.depthTolerance, 0.001f, 0.2f);
+                ImGui::SliderFloat("Normal tolerance (deg)", &m_temporalSettings.normalTolerance, 1.0f, 90.0f);
+            }
+            int resolutionIndex = std::countr_zero(unsigned(m_giResolutionFactor));
+            if (ImGui::Combo("GI resolution", &resolutionIndex, "Full\0Half\0Quarter\0")) {
+                m_giResolutionFactor = 1 << resolutionIndex;
+                m_gpuTimings.clear();
+                m_temporalAccumulator.reset();
+            }
+            if (m_giTechnique != 0) {
+                const int samples = m_giTechnique == 1 ? m_coneTraceSettings.coneCount : m_rayCastSettings.rayCount;
+                ImGui::Text("%s per pixel and frame: %.2f", m_giTechnique == 1 ? "Diffuse cones" : "Rays", double(samples) / double(std::min(sampleInterleave().frameCount, samples)));
+            }
+            ImGui::SliderFloat("Indirect strength", &m_indirectStrength, 0.0f, 4.0f);
+            if (m_giTechnique == 1) {
+                ImGui::SliderFloat("Glossy strength", &m_glossyStrength, 0.0f, 1.0f);
+            }
+            ImGui::Combo("GI view", &m_giView, "Direct + indirect\0Indirect only\0Direct only\0");
+            for (const GpuTimings::Entry& entry : m_gpuTimings.entries()) {
+                ImGui::Text("%s: %.3f ms (GPU)", entry.name.c_str(), entry.milliseconds);
+            }
+        }
+        if (ImGui::CollapsingHeader("Stage timings")) {
+            for (const StageTimings::Entry& entry : m_stageTimings.entries()) {
+                ImGui::Text("%s: %.3f ms", entry.name.c_str(), entry.milliseconds);
+            }
+            if (m_asyncReadback) {
+                ImGui::Text("Readback latency: %.3f ms (%d frames)", m_readbackLatencyMs, m_readbackFramesWaited);
+            }
+        }
 
         ImGui::Text("Translation");
 
@@ -121,13 +316,14 @@ public:
 
             // Display current value
             ImGui::SameLine();
-            ImGui::Text("%.1f", translation[i]);
+            ImGui::Text("%.1f", double(translation[i]));
         }
 
         // Check if translation has changed since last frame
         if (translation != lastTranslation) {
             m_modelMatrix = glm::translate(glm::mat4(1.0f), translation);
-            recalculateVoxelGrid();
+            ++m_sceneVersion;
+            revoxelize();
         }
         lastTranslation = translation;
 
@@ -155,59 +351,60 @@ public:
         const glm::mat3 normalModelMatrix = glm::inverseTranspose(glm::mat3(m_modelMatrix));
 
         // Voxel stuff
-        std::vector<glm::vec3> texData(atlasLength * atlasLength);
-
-        for (GPUMesh& mesh : m_meshes) {
-            // Bind the shader program that will be used for rendering. This tells OpenGL to use the shader's vertex and fragment shaders for drawing commands
-            if (validTexels.empty()) {
-                std::cout << "Rendering world positions to atlas texture." << std::endl;
-                renderAtlas(mesh, normalModelMatrix);
-
-                // bind the atlas texture
-                glBindTexture(GL_TEXTURE_2D, atlasTexture);
-                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_FLOAT, texData.data());
-
-                std::cout << "Searching for valid texels." << std::endl;
-                // Iterate through the texture data to find valid texels.
-                for (int y = 0; y < atlasLength; ++y) {
-                    for (int x = 0; x < atlasLength; ++x) {
-                        glm::vec3 worldPos = texData[y * atlasLength + x];
-                        // INVALID_COLOR used to mark invalid texels
-                        if (worldPos != glm::vec3(INVALID_COLOR)) {
-                            validTexels.push_back(worldPos);
-                        }
-                    }
+        if (m_gpuVoxelization) {
+            // The voxels never leave the GPU, the atlas is voxelized by compute shaders
+            if (m_gpuVoxelsDirty) {
+                voxelizeOnGpu();
+            }
+        } else {
+            // The atlas is rendered in object space once per mesh and atlas size, the model matrix is applied when binning.
+            // The triangle engine voxelizes the meshes directly and needs no atlas.
+            if (m_voxelEngine == 0 && m_cpuAtlas) {
+                // Rasterized on the CPU, the texel clouds are ready in the same frame
+                while (m_nextAtlasMesh < m_meshes.size()) {
+                    rasterizeTexelCloud(m_nextAtlasMesh++);
                 }
             }
+            // With asynchronous readback the texel clouds arrive a frame or two after their atlas was rendered,
+            // rendering continues in the meantime.
+            while (m_voxelEngine == 0 && m_nextAtlasMesh < m_meshes.size() && (!m_asyncReadback || m_atlasReadback.hasFreeBuffer())) {
+                renderNextAtlasPass();
+            }
+            if (m_voxelEngine == 0 && m_asyncReadback) {
+                collectTexelClouds();
+            }
 
             // setup model matrices
-            if (modelMatrices.empty()) {
-                std::cout << "Populating model matrices with voxel positions" << std::endl;
-                for (const auto& worldPos : validTexels) {
-                    glm::ivec3 gridPos = m_voxelGrid.worldToGridPosition(worldPos);
-
-                    if (!m_voxelGrid.isGridPositionOccupied(gridPos)) {
-                        glm::mat4 modelMatrix = glm::mat4(1.0f);
-                        glm::vec3 adjustedWorldPos = m_voxelGrid.gridToWorldPosition(gridPos);
-                        modelMatrix = glm::translate(modelMatrix, adjustedWorldPos);
-                        modelMatrix = glm::scale(modelMatrix, glm::vec3(m_voxelGrid.voxelScale)); // scale to fit grid
-                        modelMatrices.push_back(modelMatrix); // add model matrix for this cube to the vector
-                        m_voxelGrid.occupiedPositions.push_back(gridPos); // mark position as occupied
-                    }
-                }
+            if ((m_voxelEngine == 1 || m_missingTexelClouds == 0) && (voxelInstances.empty() || rebinVoxels)) {
+                buildVoxels();
             }
 
             // prepare voxel instancing
-            if (!modelMatrices.empty() && !voxelsReady) {
-                std::cout << "Setting up instanced rendering with model matrices" << std::endl;
-                setupVoxelInstancing();
+            if (!voxelInstances.empty() && !voxelsReady) {
+                std::cout << "Uploading voxel instances" << std::endl;
+                const auto timer = m_stageTimings.measure("Instance upload");
+                uploadVoxelInstances();
             }
+        }
 
-            if (m_renderMode == 0) {
-                renderMesh(mesh, mvpMatrix, normalModelMatrix);
+        if (m_renderMode == 0) {
+            if (m_giTechnique != 0 && giVoxelsReady()) {
+                renderIndirectLitScene(mvpMatrix, normalModelMatrix);
+            } else {
+                // the history would be stale by the time indirect light is rendered again
+                m_temporalAccumulator.reset();
+                for (GPUMesh& mesh : m_meshes) {
+                    renderMesh(mesh, mvpMatrix, normalModelMatrix);
+                }
             }
+        }
 
-            if (voxelsReady && m_renderMode == 1) {
+        if (m_renderMode == 1) {
+            if (m_gpuVoxelization) {
+                renderGpuVoxels();
+            } else if (m_greedyMeshing && voxelMeshReady) {
+                renderVoxelMesh();
+            } else if (voxelsReady) {
                 renderVoxels();
             }
         }
@@ -250,6 +447,180 @@ public:
         mesh.draw(m_defaultShader);
     }
 
+    // Whether the voxels of the current grid can be lit for cone tracing: the instances are uploaded, or on the GPU.
+    bool giVoxelsReady() const {
+        return m_gpuVoxelization ? !m_gpuVoxelsDirty : voxelsReady && !voxelInstances.empty();
+    }
+
+    // The voxel instances the voxel renderers draw, with their attributes if the CPU voxel build has them.
+    VoxelInstanceBuffers voxelInstanceBuffers() const {
+        VoxelInstanceBuffers instances;
+        instances.voxelScale = m_voxelGrid.voxelScale;
+        if (m_gpuVoxelization) {
+            instances.positionBuffer = m_gpuVoxelizer.instanceBuffer();
+            instances.drawCommandBuffer = m_gpuVoxelizer.indirectBuffer();
+            instances.count = m_gpuVoxelizer.instanceCapacity();
+            instances.gridOrigin = m_voxelGrid.worldMin;
+        } else {
+            instances.positionBuffer = instanceVBO;
+            instances.attributeBuffer = instanceAttributeVBO;
+            instances.count = voxelInstances.size();
+            instances.gridOrigin = m_voxelGrid.worldMin + glm::vec3(instanceOrigin) * m_voxelGrid.voxelScale;
+        }
+        return instances;
+    }
+
+    // Draws the meshes with a shader that writes their surface attributes, such as the screen G-buffer's or the
+    // reflective shadow map's.
+    void renderMeshSurfaces(const Shader& shader, const glm::mat4& mvpMatrix, const glm::mat3& normalModelMatrix) {
+        shader.bind();
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(mvpMatrix));
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(m_modelMatrix));
+        glUniformMatrix3fv(2, 1, GL_FALSE, glm::value_ptr(normalModelMatrix));
+        glUniform1i(5, m_useMaterial);
+        for (GPUMesh& mesh : m_meshes) {
+            // the albedo of the atlas G-buffer, so that screen and voxel surfaces agree
+            if (Texture* kdTexture = mesh.kdTexture()) {
+                kdTexture->bind(GL_TEXTURE0);
+                glUniform1i(3, 0);
+            }
+            glUniform1i(4, mesh.hasTextureCoords());
+            mesh.draw(shader);
+        }
+    }
+
+    // Which of their rays or cones the GI passes trace this frame: with temporal accumulation they are spread over
+    // several frames, the history averages them.
+    SampleInterleave sampleInterleave() const {
+        return SampleInterleave { m_frameIndex, m_temporalSettings.enabled ? m_raySpreadFrames : 1 };
+    }
+
+    // Renders the meshes as the point light sees them into the reflective shadow map, which looks at the sphere
+    // around the grid bounds.
+    void renderReflectiveShadowMap(const glm::mat3& normalModelMatrix, const glm::vec3& lightColor) {
+        const glm::vec3 gridCenter = m_voxelGrid.worldMin + 0.5f * m_voxelGrid.worldLength;
+        m_rsm.resize(m_rsmLength);
+        m_rsm.setLight(m_lightPos, gridCenter, 0.5f * std::sqrt(3.0f) * m_voxelGrid.worldLength);
+        m_rsm.bindAndClear();
+        m_rsmShader.bind();
+        glUniform3fv(6, 1, glm::value_ptr(m_lightPos));
+        glUniform3fv(7, 1, glm::value_ptr(lightColor));
+        renderMeshSurfaces(m_rsmShader, m_rsm.viewProjection() * m_modelMatrix, normalModelMatrix);
+    }
+
+    // Deferred shading with voxel based indirect light: the meshes are rendered to the screen G-buffer, the voxels
+    // are lit every frame, either into the cone tracer's radiance volume or through the reflective shadow map the
+    // near-field rays look up, and the indirect light of every pixel is composited with the direct light into the
+    // window. At half or quarter GI resolution the GI passes run on a downsampled copy of the G-buffer and their
+    // output is brought back to the window size by a joint bilateral upsample.
+    void renderIndirectLitScene(const glm::mat4& mvpMatrix, const glm::mat3& normalModelMatrix) {
+        const glm::ivec2 windowSize = m_window.getWindowSize();
+        const glm::vec3 lightColor { 1.0f };
+        m_gBuffer.resize(windowSize.x, windowSize.y);
+        {
+            const auto timer = m_gpuTimings.measure("G-buffer");
+            m_gBuffer.bindAndClear();
+            renderMeshSurfaces(m_gBufferShader, mvpMatrix, normalModelMatrix);
+        }
+        const GBuffer* giBuffer = &m_gBuffer;
+        if (m_giResolutionFactor > 1) {
+            const auto timer = m_gpuTimings.measure("G-buffer downsample");
+            m_upsampler.downsample(m_gBuffer, m_giResolutionFactor, m_camera.cameraPos());
+            giBuffer = &m_upsampler.lowResGBuffer();
+        }
+
+        GLuint diffuseTexture = 0;
+        GLuint glossyTexture = 0;
+        if (m_giTechnique == 1) {
+            if (m_radianceInjection == 0) {
+                const auto timer = m_gpuTimings.measure("Reflective shadow map");
+                renderReflectiveShadowMap(normalModelMatrix, lightColor);
+            }
+            {
+                // the volume covers the bounds of the grid, unbounded grids are lit there only
+                const auto timer = m_gpuTimings.measure("Radiance injection");
+                m_coneTracer.begin(std::min(m_voxelGrid.gridLength, VoxelConeTracer::maxVolumeLength), m_voxelGrid.worldMin, m_voxelGrid.worldLength);
+                if (m_radianceInjection == 0) {
+                    m_coneTracer.injectOccupancy(voxelInstanceBuffers());
+                    m_coneTracer.injectReflectiveShadowMap(m_rsm);
+                } else {
+                    m_coneTracer.injectInstances(voxelInstanceBuffers(), m_lightPos, lightColor);
+                }
+            }
+            {
+                const auto timer = m_gpuTimings.measure("Radiance mipmaps");
+                m_coneTracer.filter();
+            }
+            {
+                const auto timer = m_gpuTimings.measure("Cone tracing");
+                m_coneTracer.trace(*giBuffer, m_camera.cameraPos(), m_coneTraceSettings, sampleInterleave());
+            }
+            diffuseTexture = m_coneTracer.diffuseTexture();
+            glossyTexture = m_coneTraceSettings.glossy ? m_coneTracer.glossyTexture() : 0;
+        } else {
+            {
+                const auto timer = m_gpuTimings.measure("Reflective shadow map");
+                renderReflectiveShadowMap(normalModelMatrix, lightColor);
+            }
+            {
+                const auto timer = m_gpuTimings.measure("Voxel bitmask");
+                m_rayCaster.begin(m_voxelGrid.gridLength, m_voxelGrid.worldMin, m_voxelGrid.voxelScale);
+                m_rayCaster.voxelize(voxelInstanceBuffers());
+            }
+            {
+                const auto timer = m_gpuTimings.measure("Bitmask mipmaps");
+                m_rayCaster.buildMipmaps();
+            }
+            {
+                const auto timer = m_gpuTimings.measure("Ray casting");
+                m_rayCaster.trace(*giBuffer, m_rsm, m_rayCastSettings, sampleInterleave());
+            }
+            diffuseTexture = m_rayCaster.indirectTexture();
+        }
+
+        // G-buffer positions are in world space, the model matrix is already applied
+        const glm::mat4 viewProjection = m_projectionMatrix * m_camera.viewMatrix();
+        // reprojection only follows the camera, history lit by other voxels, another transform or light is dropped
+        if (m_sceneVersion != m_historySceneVersion || m_lightPos != m_historyLightPos) {
+            m_temporalAccumulator.reset();
+            m_historySceneVersion = m_sceneVersion;
+            m_historyLightPos = m_lightPos;
+        }
+        if (m_temporalSettings.enabled) {
+            const auto timer = m_gpuTimings.measure("Temporal accumulation");
+            m_temporalAccumulator.accumulate(*giBuffer, diffuseTexture, viewProjection, m_previousViewProjection, m_temporalSettings);
+            diffuseTexture = m_temporalAccumulator.outputTexture();
+        } else {
+            m_temporalAccumulator.reset();
+        }
+        m_previousViewProjection = viewProjection;
+        ++m_frameIndex;
+        if (m_giResolutionFactor > 1) {
+            const auto timer = m_gpuTimings.measure("Bilateral upsample");
+            diffuseTexture = m_upsampler.upsample(m_gBuffer, diffuseTexture, 0);
+            if (glossyTexture)
+                glossyTexture = m_upsampler.upsample(m_gBuffer, glossyTexture, 1);
+        }
+
+        const auto timer = m_gpuTimings.measure("GI composite");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, windowSize.x, windowSize.y);
+        m_giCompositeShader.bind();
+        glUniform3fv(0, 1, glm::value_ptr(m_lightPos));
+        glUniform1i(1, m_giView);
+        glUniform1f(2, m_indirectStrength);
+        glUniform1f(3, glossyTexture ? m_glossyStrength : 0.0f);
+        glBindTextureUnit(0, m_gBuffer.positionTexture());
+        glBindTextureUnit(1, m_gBuffer.normalTexture());
+        glBindTextureUnit(2, m_gBuffer.albedoTexture());
+        glBindTextureUnit(3, m_gBuffer.depthTexture());
+        glBindTextureUnit(4, diffuseTexture);
+        glBindTextureUnit(5, glossyTexture);
+        glBindVertexArray(screenVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    }
+
     void renderVoxels() {
         glBindVertexArray(voxelGridVAO);
         m_voxelShader.bind();
@@ -257,27 +628,124 @@ public:
         glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(m_camera.viewMatrix()));
         glUniform1i(3, m_shadingMode);
         glUniform3fv(4, 1, glm::value_ptr(m_lightPos));
-        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, modelMatrices.size());
+        const glm::vec3 gridOrigin = m_voxelGrid.worldMin + glm::vec3(instanceOrigin) * m_voxelGrid.voxelScale;
+        glUniform3fv(5, 1, glm::value_ptr(gridOrigin));
+        glUniform1f(6, m_voxelGrid.voxelScale);
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, voxelInstances.size());
+
+        glBindVertexArray(0);
+    }
+
+    // Draws the greedy meshed surface of the voxels instead of one cube per voxel.
+    void renderVoxelMesh() {
+        glBindVertexArray(voxelMeshVAO);
+        m_voxelMeshShader.bind();
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix));
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(m_camera.viewMatrix()));
+        glUniform1i(3, m_shadingMode);
+        glUniform3fv(4, 1, glm::value_ptr(m_lightPos));
+        glUniform3fv(5, 1, glm::value_ptr(m_voxelGrid.worldMin));
+        glUniform1f(6, m_voxelGrid.voxelScale);
+        glDrawElements(GL_TRIANGLES, GLsizei(m_greedyMesher.indices().size()), GL_UNSIGNED_INT, nullptr);
 
         glBindVertexArray(0);
     }
 
-    void renderAtlas(GPUMesh& mesh, glm::mat4 normalModelMatrix) {
+    // Draws the voxels produced by the GPU voxelizer, the instance count is read from the indirect buffer on the GPU.
+    void renderGpuVoxels() {
+        glBindVertexArray(gpuVoxelVAO);
+        m_gpuVoxelShader.bind();
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix));
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(m_camera.viewMatrix()));
+        glUniform1i(3, m_shadingMode);
+        glUniform3fv(4, 1, glm::value_ptr(m_lightPos));
+        glUniform3fv(5, 1, glm::value_ptr(m_voxelGrid.worldMin)); // GPU voxels are packed relative to grid position 0
+        glUniform1f(6, m_voxelGrid.voxelScale);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_gpuVoxelizer.instanceBuffer());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_gpuVoxelizer.indirectBuffer());
+        glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    // Sampling of the given atlas pass, see AtlasSampling.
+    AtlasSampling atlasSampling(int pass) const {
+        return AtlasSampling { pass, m_conservativeAtlas };
+    }
+
+    void renderAtlas(size_t meshIndex, int pass = 0) {
         // Do all atlas rendering here
+        GPUMesh& mesh = m_meshes[meshIndex];
         glBindFramebuffer(GL_FRAMEBUFFER, atlasFBO);
         glViewport(0, 0, atlasLength, atlasLength);
-        glClearColor(INVALID_COLOR, INVALID_COLOR, INVALID_COLOR, INVALID_COLOR);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // INVALID_COLOR (or a clear valid bit) marks the positions no triangle covers, the attributes of those
+        // texels are never read
+        const glm::vec4 invalidPosition { atlasInvalidValue() };
+        const glm::uvec4 invalidVoxel { 0 };
+        const glm::vec4 noAttribute { 0.0f };
+        if (m_atlasEncoding == 2) {
+            glClearBufferuiv(GL_COLOR, 0, glm::value_ptr(invalidVoxel));
+        } else {
+            glClearBufferfv(GL_COLOR, 0, glm::value_ptr(invalidPosition));
+        }
+        glClearBufferfv(GL_COLOR, 1, glm::value_ptr(noAttribute));
+        glClearBufferfv(GL_COLOR, 2, glm::value_ptr(noAttribute));
+
+        // atlas_sample_frag.glsl evaluates the CPU rasterizer's attribute planes instead of the interpolators
+        const std::vector<AtlasAttributePlanes> planes = AtlasRasterizer::attributePlanes(m_cpuMeshes[meshIndex], atlasLength, pass);
+        glNamedBufferData(atlasPlaneBuffer, GLsizeiptr(planes.size() * sizeof(AtlasAttributePlanes)), planes.data(), GL_STREAM_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, atlasPlaneBuffer);
+
+        const auto draw = [&](Shader& shader, bool conservative) {
+            shader.bind();
+            // The atlas stores object space positions, world positions are an affine function of them (see buildVoxels)
+            const glm::mat4 identity { 1.0f };
+            glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix * m_viewMatrix));
+            glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(identity));
+            glUniformMatrix3fv(2, 1, GL_FALSE, glm::value_ptr(glm::mat3(identity)));
+            // jittered passes move the triangles by the same clip space offset as the CPU rasterizer
+            glUniform2fv(10, 1, glm::value_ptr(AtlasRasterizer::jitterClipOffset(pass, atlasLength)));
+            if (conservative) {
+                glUniform1i(11, atlasLength);
+            }
+            // albedo comes from the mesh's diffuse texture or material, like rasterizeTexelCloud
+            if (Texture* kdTexture = mesh.kdTexture()) {
+                kdTexture->bind(GL_TEXTURE0);
+                glUniform1i(3, 0);
+                glUniform2fv(12, 1, glm::value_ptr(atlasAlbedoSampleOffset(pass)));
+                glUniform2fv(13, 1, glm::value_ptr(atlasAlbedoTexelScale(*m_cpuMeshes[meshIndex].material.kdTexture)));
+            }
+            glUniform1i(4, mesh.hasTextureCoords());
+            glUniform1i(5, m_useMaterial);
+            if (m_atlasEncoding == 2) {
+                // packed voxel atlases quantize to the grid that is voxelized in world space right away, the GPU
+                // voxelizer works on the shown grid length and the CPU path on the finest level of the pyramid
+                glUniform3fv(6, 1, glm::value_ptr(m_voxelGrid.worldMin));
+                glUniform3fv(7, 1, glm::value_ptr(m_voxelGrid.worldMax));
+                glUniform1i(8, m_gpuVoxelization ? m_voxelGrid.gridLength : m_finestGridLength);
+                glUniformMatrix4fv(9, 1, GL_FALSE, glm::value_ptr(m_modelMatrix));
+            }
+            mesh.draw(shader);
+        };
 
-        m_atlasShader.bind();
-        // Pass the Model-View-Projection matrix to the vertex shader
-        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix * m_viewMatrix * m_modelMatrix));
-        // The object's transform. Multiplying a vertex by the model matrix transforms the vector into world space.
-        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(m_modelMatrix));
-        glUniformMatrix3fv(2, 1, GL_FALSE, glm::value_ptr(normalModelMatrix));
-        glUniform1i(4, GL_FALSE);
-        glUniform1i(5, m_useMaterial);
-        mesh.draw(m_atlasShader);
+        Shader& centerShader = m_atlasEncoding == 2 ? m_atlasPackedShader : m_atlasShader;
+        if (!m_conservativeAtlas) {
+            draw(centerShader, false);
+        } else {
+            // Like AtlasRasterizer, texels whose center a triangle covers keep that center sample: the center pass
+            // marks them in the stencil buffer and the conservative pass only fills the texels it left unmarked
+            const GLint unmarked = 0;
+            glClearBufferiv(GL_STENCIL, 0, &unmarked);
+            glEnable(GL_STENCIL_TEST);
+            glStencilFunc(GL_ALWAYS, 1, 0xff);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+            draw(centerShader, false);
+            glStencilFunc(GL_EQUAL, 0, 0xff);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            draw(m_atlasEncoding == 2 ? m_atlasConservativePackedShader : m_atlasConservativeShader, true);
+            glDisable(GL_STENCIL_TEST);
+        }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // reset viewport
@@ -288,7 +756,8 @@ public:
         // Texture shader stuff
         m_textureShader.bind();
         glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, atlasTexture);
+        // an integer texture cannot be sampled as colors, packed voxel atlases show their albedo instead
+        glBindTexture(GL_TEXTURE_2D, m_atlasEncoding == 2 ? atlasAlbedoTexture : atlasTexture);
         glUniform1i(3, 0);
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
@@ -305,14 +774,583 @@ public:
         glBindVertexArray(0);
     }
 
+    // Renders the next atlas pass of the meshes whose texel clouds are missing, or takes the whole texel cloud of
+    // the next mesh from the atlas cache.
+    void renderNextAtlasPass() {
+        const size_t meshIndex = m_nextAtlasMesh;
+        const int pass = m_nextAtlasPass++;
+        if (m_nextAtlasPass == m_atlasJitterPasses) {
+            ++m_nextAtlasMesh;
+            m_nextAtlasPass = 0;
+        }
+        if (pass == 0 && loadCachedTexelCloud(meshIndex)) {
+            // the cached cloud holds the texels of every pass
+            m_nextAtlasMesh = meshIndex + 1;
+            m_nextAtlasPass = 0;
+            return;
+        }
+        renderTexelCloud(meshIndex, pass);
+    }
+
+    // Renders the object space positions of a mesh to the atlas and starts reading them back. With asynchronous
+    // readback the texels are collected by collectTexelClouds, otherwise this waits for the GPU.
+    void renderTexelCloud(size_t meshIndex, int pass) {
+        std::cout << "Rendering object space positions to atlas texture." << std::endl;
+        {
+            const auto timer = m_stageTimings.measure("Atlas render");
+            renderAtlas(meshIndex, pass);
+        }
+
+        if (m_asyncReadback) {
+            // requests complete in order, the passes of a mesh arrive one after the other
+            const auto timer = m_stageTimings.measure("Atlas readback request");
+            m_atlasReadback.request(atlasAttachments(), atlasLength, int(meshIndex) * m_atlasJitterPasses + pass);
+            return;
+        }
+
+        std::vector<std::byte> data;
+        {
+            // glGetTextureImage stalls until the atlas has been rendered
+            const auto timer = m_stageTimings.measure("Atlas readback (blocking)");
+            data = readAtlas();
+        }
+        storeTexelCloud(meshIndex, pass, data, atlasLength);
+    }
+
+    // Reads the attachments of atlasAttachments() back one after the other, waiting for the GPU.
+    std::vector<std::byte> readAtlas() const {
+        const size_t numTexels = size_t(atlasLength) * atlasLength;
+        std::vector<std::byte> data(numTexels * atlasReadbackBytesPerTexel());
+        std::byte* out = data.data();
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        for (const AtlasReadback::Attachment& attachment : atlasAttachments()) {
+            const size_t size = numTexels * attachment.bytesPerTexel;
+            glGetTextureImage(attachment.texture, 0, attachment.format, attachment.type, GLsizei(size), out);
+            out += size;
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        return data;
+    }
+
+    // The attachments of the atlas G-buffer that are read back, in the order compactAtlas takes them. RGB16F
+    // positions are stored as RGBA16F, RGB16F does not have to be color-renderable, and read back without alpha.
+    std::vector<AtlasReadback::Attachment> atlasAttachments() const {
+        std::vector<AtlasReadback::Attachment> attachments;
+        if (m_atlasEncoding == 0) {
+            attachments.push_back({ atlasTexture, GL_RGB, GL_FLOAT, sizeof(glm::vec3) });
+        } else if (m_atlasEncoding == 1) {
+            attachments.push_back({ atlasTexture, GL_RGB, GL_HALF_FLOAT, 3 * sizeof(uint16_t) });
+        } else {
+            attachments.push_back({ atlasTexture, GL_RED_INTEGER, GL_UNSIGNED_INT, sizeof(uint32_t) });
+        }
+        if (m_readAtlasAttributes) {
+            attachments.push_back({ atlasNormalTexture, GL_RG, GL_SHORT, sizeof(uint32_t) });
+            attachments.push_back({ atlasAlbedoTexture, GL_RGBA, GL_UNSIGNED_BYTE, sizeof(uint32_t) });
+        }
+        return attachments;
+    }
+
+    size_t atlasReadbackBytesPerTexel() const {
+        size_t bytes = 0;
+        for (const AtlasReadback::Attachment& attachment : atlasAttachments()) {
+            bytes += attachment.bytesPerTexel;
+        }
+        return bytes;
+    }
+
+    // Clear value of the positions no triangle covers. Half float atlases are cleared with INVALID_COLOR rounded
+    // to a half float, so the texels compare equal to it bit for bit.
+    float atlasInvalidValue() const {
+        return m_atlasEncoding == 1 ? glm::unpackHalf1x16(glm::packHalf1x16(INVALID_COLOR)) : INVALID_COLOR;
+    }
+
+    // Where the albedo of an atlas texel is sampled, relative to the texel's corner: at the jittered sample position
+    // (texture coordinates and atlas texels line up).
+    static glm::vec2 atlasAlbedoSampleOffset(int pass) {
+        return glm::vec2(0.5f) + AtlasRasterizer::jitterOffset(pass);
+    }
+
+    // Diffuse texture texels per atlas texel, the nearest texel of a sample position p is ivec2(p * scale).
+    glm::vec2 atlasAlbedoTexelScale(const Image& kdTexture) const {
+        return glm::vec2(float(kdTexture.width), float(kdTexture.height)) / float(atlasLength);
+    }
+
+    // Rasterizes the object space positions of a mesh into the atlas on the CPU, without any GPU work.
+    void rasterizeTexelCloud(size_t meshIndex) {
+        if (loadCachedTexelCloud(meshIndex)) {
+            return;
+        }
+        const Mesh& mesh = m_cpuMeshes[meshIndex];
+        for (int pass = 0; pass < m_atlasJitterPasses; ++pass) {
+            {
+                const auto timer = m_stageTimings.measure("Atlas rasterization (CPU)");
+                m_atlasRasterizer.rasterize(mesh, atlasLength, INVALID_COLOR, atlasSampling(pass));
+            }
+
+            // The G-buffer attachments the atlas shader writes next to the positions
+            const std::vector<glm::vec3>& normals = m_atlasRasterizer.normals();
+            std::vector<uint32_t> packedNormals(normals.size()), albedos(normals.size());
+            {
+                const auto timer = m_stageTimings.measure("Atlas attributes (CPU)");
+                const uint32_t materialAlbedo = voxel_attributes::packAlbedo(glm::vec4(m_useMaterial ? mesh.material.kd : glm::vec3(1.0f), 1.0f));
+                const Image* kdTexture = mesh.material.kdTexture.get();
+                const glm::vec2 sampleOffset = atlasAlbedoSampleOffset(pass);
+                const glm::vec2 texelScale = kdTexture ? atlasAlbedoTexelScale(*kdTexture) : glm::vec2(0.0f);
+                for (size_t i = 0; i < normals.size(); ++i) {
+                    packedNormals[i] = voxel_attributes::packNormal(normals[i]);
+                    albedos[i] = materialAlbedo;
+                    if (kdTexture) {
+                        // the sample position is the texture coordinate, nearest texel of the diffuse texture
+                        const int u = int((float(i % atlasLength) + sampleOffset.x) * texelScale.x);
+                        const int v = int((float(i / atlasLength) + sampleOffset.y) * texelScale.y);
+                        const uint8_t* pixel = &kdTexture->pixels[(size_t(v) * kdTexture->width + u) * kdTexture->channels];
+                        const glm::vec3 color = kdTexture->channels >= 3 ? glm::vec3(pixel[0], pixel[1], pixel[2]) : glm::vec3(pixel[0]);
+                        albedos[i] = voxel_attributes::packAlbedo(glm::vec4(color / 255.0f, 1.0f));
+                    }
+                }
+            }
+            storeTexelCloud(meshIndex, pass, m_atlasRasterizer.positions(), packedNormals, albedos);
+        }
+    }
+
+    // Consumes every atlas readback that has completed, without waiting for the ones still in flight.
+    void collectTexelClouds() {
+        const auto timer = m_stageTimings.measure("Atlas readback poll");
+        while (m_atlasReadback.poll([this](const AtlasReadback::Result& result) {
+            m_readbackLatencyMs = result.latencyMs;
+            m_readbackFramesWaited = result.framesWaited;
+            storeTexelCloud(size_t(result.tag / m_atlasJitterPasses), result.tag % m_atlasJitterPasses, result.data, result.atlasLength);
+        })) { }
+    }
+
+    // Keeps the valid texels of a read back atlas G-buffer as (a jittered pass of) the texel cloud of a mesh.
+    void storeTexelCloud(size_t meshIndex, int pass, std::span<const std::byte> atlasData, int length) {
+        {
+            const auto timer = m_stageTimings.measure("Texel compaction");
+            std::cout << "Searching for valid texels." << std::endl;
+            compactAtlas(atlasData, length, pass == 0 ? m_texelClouds[meshIndex] : m_passTexels);
+            if (pass > 0) {
+                m_texelClouds[meshIndex].append(m_passTexels);
+            }
+        }
+        finishTexelCloudPass(meshIndex, pass);
+    }
+
+    // Keeps the valid texels of a CPU rasterized atlas as (a jittered pass of) the texel cloud of a mesh.
+    void storeTexelCloud(size_t meshIndex, int pass, std::span<const glm::vec3> positions, std::span<const uint32_t> normals, std::span<const uint32_t> albedos) {
+        {
+            const auto timer = m_stageTimings.measure("Texel compaction");
+            std::cout << "Searching for valid texels." << std::endl;
+            // INVALID_COLOR used to mark invalid texels, the compaction reuses the texel cloud's memory
+            TexelCloud& texels = pass == 0 ? m_texelClouds[meshIndex] : m_passTexels;
+            m_texelCompactor.compact(positions, INVALID_COLOR, texels.positions);
+            m_texelCompactor.compactAttribute(normals, texels.normals);
+            m_texelCompactor.compactAttribute(albedos, texels.albedos);
+            texels.gridPositions.clear();
+            if (pass > 0) {
+                m_texelClouds[meshIndex].append(m_passTexels);
+            }
+        }
+        finishTexelCloudPass(meshIndex, pass);
+    }
+
+    // The texel cloud of a mesh is complete (and cached) once its last jittered pass is stored.
+    void finishTexelCloudPass(size_t meshIndex, int pass) {
+        if (pass + 1 < m_atlasJitterPasses) {
+            return;
+        }
+        --m_missingTexelClouds;
+        m_texelCloudCache.insert(texelCloudKey(meshIndex), m_texelClouds[meshIndex]);
+    }
+
+    // Decodes the valid texels of an atlas read back with the attachments of atlasAttachments() into texels,
+    // reusing its memory. The positions are compacted in the encoding they were read back in.
+    void compactAtlas(std::span<const std::byte> data, int length, TexelCloud& texels) {
+        const size_t numTexels = size_t(length) * length;
+        const std::byte* attributes = data.data() + numTexels * atlasAttachments().front().bytesPerTexel;
+        if (m_atlasEncoding == 0) {
+            m_texelCompactor.compact(std::span(reinterpret_cast<const glm::vec3*>(data.data()), numTexels), INVALID_COLOR, texels.positions);
+            texels.gridPositions.clear();
+        } else if (m_atlasEncoding == 1) {
+            m_texelCompactor.compactHalf(std::span(reinterpret_cast<const uint16_t*>(data.data()), 3 * numTexels), atlasInvalidValue(), texels.positions);
+            texels.gridPositions.clear();
+        } else {
+            m_texelCompactor.compactPacked(std::span(reinterpret_cast<const uint32_t*>(data.data()), numTexels), texels.gridPositions);
+            texels.positions.clear();
+        }
+        if (m_readAtlasAttributes) {
+            m_texelCompactor.compactAttribute(std::span(reinterpret_cast<const uint32_t*>(attributes), numTexels), texels.normals);
+            m_texelCompactor.compactAttribute(std::span(reinterpret_cast<const uint32_t*>(attributes) + numTexels, numTexels), texels.albedos);
+        } else {
+            texels.normals.clear();
+            texels.albedos.clear();
+        }
+    }
+
+    // Atlas configuration the texel cloud of a mesh is rendered with. The CPU rasterizer always produces object
+    // space positions and attributes.
+    TexelCloudCache::Key texelCloudKey(size_t meshIndex) const {
+        TexelCloudCache::Key key { meshIndex, atlasLength };
+        key.cpuRasterized = m_cpuAtlas && m_conservativeAtlas;
+        key.conservative = m_conservativeAtlas;
+        key.jitterPasses = m_atlasJitterPasses;
+        if (!m_cpuAtlas) {
+            key.encoding = m_atlasEncoding;
+            key.attributes = m_readAtlasAttributes;
+        }
+        if (key.encoding == 2) {
+            key.gridLength = m_finestGridLength;
+            key.modelMatrix = m_modelMatrix;
+        }
+        return key;
+    }
+
+    // Takes the texel cloud of a mesh from the cache if this atlas configuration was rendered before, which skips
+    // the atlas render, readback and compaction.
+    bool loadCachedTexelCloud(size_t meshIndex) {
+        const auto timer = m_stageTimings.measure("Atlas cache lookup");
+        const TexelCloud* texels = m_texelCloudCache.find(texelCloudKey(meshIndex));
+        if (!texels) {
+            return false;
+        }
+        m_texelClouds[meshIndex] = *texels;
+        --m_missingTexelClouds;
+        return true;
+    }
+
+    // Renders the atlas of every mesh and voxelizes it with compute shaders, including the indirect draw command.
+    void voxelizeOnGpu() {
+        const auto timer = m_stageTimings.measure("GPU voxelization submit");
+        const size_t maxInstances = m_meshes.size() * size_t(m_atlasJitterPasses) * atlasLength * atlasLength;
+        m_gpuVoxelizer.begin(m_voxelGrid.gridLength, m_voxelGrid.worldMin, m_voxelGrid.worldMax, maxInstances);
+        for (size_t meshIndex = 0; meshIndex < m_meshes.size(); ++meshIndex) {
+            // jittered passes add their voxels to the same occupancy image
+            for (int pass = 0; pass < m_atlasJitterPasses; ++pass) {
+                renderAtlas(meshIndex, pass);
+                if (m_atlasEncoding == 2) {
+                    m_gpuVoxelizer.voxelizePackedAtlas(atlasTexture, atlasLength);
+                } else {
+                    m_gpuVoxelizer.voxelizeAtlas(atlasTexture, atlasLength, m_modelMatrix, atlasInvalidValue());
+                }
+            }
+        }
+        m_gpuVoxelizer.compact();
+        m_gpuVoxelsDirty = false;
+        ++m_sceneVersion;
+    }
+
+    // Reads the GPU voxels back and compares them with a CPU voxelization of the same atlases (blocking, for debugging).
+    // Returns true if both agree and the indirect draw covers every occupied voxel.
+    bool crossCheckGpuVoxels() {
+        voxelizeOnGpu();
+        const OccupancyVolume gpuOccupancy = m_gpuVoxelizer.readOccupancy();
+        const size_t instanceCount = m_gpuVoxelizer.readInstanceCount();
+
+        // The GPU voxelizer clamps to the grid bounds
+        VoxelGrid reference = m_voxelGrid;
+        reference.unbounded = false;
+        reference.clearGrid();
+        TexelCloud texels;
+        for (size_t meshIndex = 0; meshIndex < m_meshes.size(); ++meshIndex) {
+            for (int pass = 0; pass < m_atlasJitterPasses; ++pass) {
+                renderAtlas(meshIndex, pass);
+                compactAtlas(readAtlas(), atlasLength, texels);
+                binTexelCloud(texels, reference);
+            }
+        }
+
+        const size_t differences = gpuOccupancy.countDifferences(reference.occupancy);
+        std::cout << "GPU voxelization: " << gpuOccupancy.count() << " voxels, " << instanceCount << " instances; CPU voxelization: "
+                  << reference.occupancy.count() << " voxels; " << differences << " voxels differ" << std::endl;
+        return differences == 0 && instanceCount == gpuOccupancy.count();
+    }
+
+    // Discards the texel clouds (and readbacks still in flight) so the atlas is rendered again for every mesh.
+    void resetTexelClouds() {
+        m_atlasReadback.cancelAll();
+        m_texelClouds.assign(m_meshes.size(), {});
+        m_nextAtlasMesh = 0;
+        m_nextAtlasPass = 0;
+        m_missingTexelClouds = m_meshes.size();
+    }
+
+    // Transforms the cached texel clouds to world space and bins them into the voxel grid.
+    void buildVoxels() {
+        const auto start = std::chrono::steady_clock::now();
+        std::cout << "Populating model matrices with voxel positions" << std::endl;
+        rebinVoxels = false;
+        // bounded grids are voxelized at the finest level of the pyramid, the shown level is selected from it below
+        const int gridLength = m_voxelGrid.gridLength;
+        if (!m_voxelGrid.unbounded && m_finestGridLength != gridLength) {
+            m_voxelGrid.gridLength = m_finestGridLength;
+            m_voxelGrid.clearGrid();
+        }
+        if (m_voxelEngine == 1) {
+            const auto timer = m_stageTimings.measure("Triangle voxelization");
+            for (const Mesh& mesh : m_cpuMeshes) {
+                m_triangleVoxelizer.voxelize(mesh, m_modelMatrix, m_voxelGrid.worldMin, m_voxelGrid.worldMax, m_voxelGrid.occupancy);
+            }
+        } else {
+            const auto timer = m_stageTimings.measure("Voxel binning");
+            for (const TexelCloud& texels : m_texelClouds) {
+                binTexelCloud(texels, m_voxelGrid);
+            }
+        }
+
+        // fill the interior of closed surfaces, only the dense volume of bounded grids has an outside to start from
+        if (m_solidVoxels && !m_voxelGrid.unbounded) {
+            const auto timer = m_stageTimings.measure("Solid fill");
+            m_solidFiller.fill(m_voxelGrid.occupancy);
+        }
+
+        // every coarser grid length by OR-ing 2x2x2 voxels, so "/2" and "*2" do not voxelize again
+        if (!m_voxelGrid.unbounded) {
+            {
+                const auto timer = m_stageTimings.measure("Occupancy pyramid");
+                m_occupancyPyramid.build(m_voxelGrid.occupancy);
+            }
+            m_voxelGrid.gridLength = gridLength;
+            const int level = m_occupancyPyramid.findLevel(gridLength);
+            if (level > 0) {
+                m_voxelGrid.occupancy = m_occupancyPyramid.level(level);
+            }
+            buildVoxelAttributes(std::max(level, 0));
+        } else {
+            m_finestAttributes.clear();
+            m_voxelAttributes.clear();
+        }
+
+        // When only the translation changed, compare against the previous voxels: if none changed the
+        // instances on the GPU are still valid and do not have to be rebuilt and uploaded. The texels moved
+        // inside their voxels though, so the averaged attributes can differ.
+        if (m_previousOccupancy && !m_voxelGrid.unbounded) {
+            const size_t changed = m_voxelGrid.occupancy.countDifferences(*m_previousOccupancy);
+            m_previousOccupancy.reset();
+            if (changed == 0 && !voxelInstances.empty()) {
+                updateInstanceAttributes();
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                m_stageTimings.record("Voxel build", elapsed.count());
+                return;
+            }
+        }
+        m_previousOccupancy.reset();
+        generateInstances();
+
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        m_stageTimings.record("Voxel build", elapsed.count());
+    }
+
+    // Marks the voxels of a texel cloud: object space positions are transformed to world space and quantized,
+    // packed voxel atlases already hold the grid positions.
+    void binTexelCloud(const TexelCloud& texels, VoxelGrid& grid) const {
+        for (const glm::vec3& objectPos : texels.positions) {
+            glm::vec3 worldPos = glm::vec3(m_modelMatrix * glm::vec4(objectPos, 1.0f));
+            glm::ivec3 gridPos = grid.worldToGridPosition(worldPos);
+            grid.markGridPositionOccupied(gridPos); // mark position as occupied
+        }
+        for (uint32_t gridPos : texels.gridPositions) {
+            grid.markGridPositionOccupied(voxel_instance::unpack(gridPos));
+        }
+    }
+
+    // Averages the atlas normals and albedos per voxel: the texels are binned once more into the finest level,
+    // whose sums are then added up into the shown level. Only the atlas engine has texel attributes.
+    void buildVoxelAttributes(int level) {
+        const auto timer = m_stageTimings.measure("Voxel attributes");
+        const OccupancyVolume& finest = m_occupancyPyramid.level(0);
+        m_finestAttributes.reset(finest);
+        if (m_voxelEngine == 0) {
+            VoxelGrid finestGrid;
+            finestGrid.gridLength = finest.gridLength();
+            finestGrid.worldMin = m_voxelGrid.worldMin;
+            finestGrid.worldMax = m_voxelGrid.worldMax;
+            const glm::mat3 normalModelMatrix = glm::inverseTranspose(glm::mat3(m_modelMatrix));
+            for (const TexelCloud& texels : m_texelClouds) {
+                for (size_t i = 0; i < texels.normals.size(); ++i) {
+                    glm::ivec3 gridPos;
+                    if (texels.gridPositions.empty()) {
+                        const glm::vec3 worldPos = glm::vec3(m_modelMatrix * glm::vec4(texels.positions[i], 1.0f));
+                        gridPos = finestGrid.worldToGridPosition(worldPos);
+                    } else {
+                        gridPos = voxel_instance::unpack(texels.gridPositions[i]);
+                    }
+                    const glm::vec3 normal = normalModelMatrix * voxel_attributes::unpackNormal(texels.normals[i]);
+                    m_finestAttributes.add(gridPos, glm::normalize(normal), glm::vec3(voxel_attributes::unpackAlbedo(texels.albedos[i])));
+                }
+            }
+        }
+        selectVoxelAttributes(level);
+    }
+
+    // Attributes of the shown grid, from the sums of the finest level.
+    void selectVoxelAttributes(int level) {
+        m_voxelAttributes.reset(m_voxelGrid.occupancy);
+        m_voxelAttributes.addFiner(m_finestAttributes, level);
+    }
+
+    // Turns the voxels of the grid into instances, the greedy mesh and the octree.
+    void generateInstances() {
+        voxelInstances.clear();
+        voxelInstanceAttributes.clear();
+        voxelsReady = false;
+
+        // one cube per occupied voxel, in row or Morton order
+        {
+            const auto timer = m_stageTimings.measure("Instance generation");
+            const std::vector<glm::ivec3> positions = m_voxelGrid.occupiedPositions();
+            // unbounded grids can extend below 0, pack positions relative to the smallest one
+            instanceOrigin = glm::ivec3(0);
+            if (m_voxelGrid.unbounded) {
+                instanceOrigin = positions.empty() ? glm::ivec3(0) : positions.front();
+                for (const glm::ivec3& gridPos : positions)
+                    instanceOrigin = glm::min(instanceOrigin, gridPos);
+            }
+            size_t outOfRange = 0;
+            for (const glm::ivec3& gridPos : positions) {
+                if (voxel_instance::fits(gridPos - instanceOrigin)) {
+                    voxelInstances.push_back(voxel_instance::pack(gridPos - instanceOrigin));
+                    voxelInstanceAttributes.emplace_back(m_voxelAttributes.packedNormal(gridPos), m_voxelAttributes.packedAlbedo(gridPos));
+                } else {
+                    ++outOfRange;
+                }
+            }
+            if (outOfRange > 0) {
+                std::cout << outOfRange << " voxels are more than " << voxel_instance::maxCoordinate << " voxels away from the others and are not drawn" << std::endl;
+            }
+        }
+
+        if (m_greedyMeshing) {
+            buildVoxelMesh();
+        }
+
+        // sparse copy of the same voxels for point, box and ray queries, only over the bounded region; the dense
+        // occupancy stays the storage of the grid
+        {
+            const auto timer = m_stageTimings.measure("Octree build");
+            if (m_voxelGrid.unbounded)
+                m_octree.clear();
+            else
+                m_octree.build(m_voxelGrid.occupancy);
+        }
+    }
+
+    // Recomputes the attributes of the current instances and uploads the range of them that changed, the
+    // instances themselves stay as they are.
+    void updateInstanceAttributes() {
+        const auto timer = m_stageTimings.measure("Instance attribute update");
+        size_t first = voxelInstanceAttributes.size(), last = 0;
+        for (size_t i = 0; i < voxelInstances.size(); ++i) {
+            const glm::ivec3 gridPos = voxel_instance::unpack(voxelInstances[i]) + instanceOrigin;
+            const glm::uvec2 attributes { m_voxelAttributes.packedNormal(gridPos), m_voxelAttributes.packedAlbedo(gridPos) };
+            if (attributes != voxelInstanceAttributes[i]) {
+                voxelInstanceAttributes[i] = attributes;
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+        // instances that were not uploaded yet are uploaded with their new attributes
+        if (first <= last && voxelsReady) {
+            glNamedBufferSubData(instanceAttributeVBO, GLintptr(first * sizeof(glm::uvec2)), GLsizeiptr((last - first + 1) * sizeof(glm::uvec2)),
+                &voxelInstanceAttributes[first]);
+            ++m_sceneVersion;
+        }
+    }
+
+    // Switches to another grid length. Lengths the occupancy pyramid holds are a level select, any other length
+    // is voxelized from scratch and becomes the finest level of the next pyramid.
+    void selectGridLength(int gridLength) {
+        const int level = m_occupancyPyramid.findLevel(gridLength);
+        m_voxelGrid.gridLength = gridLength;
+        if (level < 0 || m_voxelGrid.unbounded || m_gpuVoxelization || rebinVoxels) {
+            m_finestGridLength = gridLength;
+            if (m_autoAtlasLength) {
+                selectAtlasLength();
+            }
+            recalculateVoxelGrid();
+            return;
+        }
+
+        {
+            const auto timer = m_stageTimings.measure("Level select");
+            m_voxelGrid.calculateVoxelScale();
+            m_voxelGrid.occupancy = m_occupancyPyramid.level(level);
+        }
+        {
+            const auto timer = m_stageTimings.measure("Voxel attributes");
+            selectVoxelAttributes(level);
+        }
+        m_previousOccupancy.reset();
+        voxelMeshReady = false;
+        generateInstances();
+    }
+
+    // Meshes the surface of the voxels and uploads it. Unbounded grids are drawn as instanced cubes instead.
+    void buildVoxelMesh() {
+        voxelMeshReady = false;
+        if (m_voxelGrid.unbounded) {
+            m_greedyMesher.clear();
+            return;
+        }
+        {
+            const auto timer = m_stageTimings.measure("Greedy meshing");
+            m_greedyMesher.build(m_voxelGrid.occupancy);
+        }
+
+        const auto timer = m_stageTimings.measure("Voxel mesh upload");
+        const std::vector<GreedyMesher::Vertex>& vertices = m_greedyMesher.vertices();
+        const std::vector<uint32_t>& indices = m_greedyMesher.indices();
+        glNamedBufferData(voxelMeshVBO, vertices.size() * sizeof(GreedyMesher::Vertex), vertices.data(), GL_DYNAMIC_DRAW);
+        glNamedBufferData(voxelMeshEBO, indices.size() * sizeof(uint32_t), indices.data(), GL_DYNAMIC_DRAW);
+        voxelMeshReady = true;
+    }
+
+    // Smallest atlas length of atlasSizes whose texel centers are at most one voxel of the finest grid apart on
+    // every triangle (see AtlasResolution), the largest one if none is fine enough.
+    int automaticAtlasLength() const {
+        return m_atlasResolution.selectLength(atlasSizes, m_voxelGrid.worldLength / float(m_finestGridLength));
+    }
+
+    // Switches to automaticAtlasLength, returns true if the atlas length changed. The caller recalculates the voxel grid.
+    bool selectAtlasLength() {
+        const int length = automaticAtlasLength();
+        const float voxelScale = m_voxelGrid.worldLength / float(m_finestGridLength);
+        std::cout << "Atlas length " << length << " for a " << m_finestGridLength << "^3 grid (" << m_atlasResolution.requiredLength(voxelScale)
+                  << " needed), texels within a voxel on " << 100.0 * m_atlasResolution.spacingMetFraction(length, voxelScale) << "% of the surface"
+                  << std::endl;
+        if (length == atlasLength) {
+            return false;
+        }
+        atlasLength = length;
+        resetAtlasTexture();
+        return true;
+    }
+
     void recalculateVoxelGrid() {
+        m_occupancyPyramid.clear();
         m_voxelGrid.clearGrid();
         m_voxelGrid.calculateVoxelScale();
-        validTexels.clear();
-        modelMatrices.clear();
+        resetTexelClouds();
+        m_gpuVoxelsDirty = true;
+        voxelInstances.clear();
+        voxelMeshReady = false;
+        m_previousOccupancy.reset();
         voxelsReady = false;
     }
 
+    // Re-voxelizes after the model matrix changed. The cached object space texel clouds stay valid,
+    // so the atlas is neither rendered nor read back again. Packed voxel atlases are in world space and are
+    // taken from the atlas cache or rendered again.
+    void revoxelize() {
+        if (!m_voxelGrid.unbounded)
+            m_previousOccupancy = m_voxelGrid.occupancy;
+        if (m_atlasEncoding == 2 && !m_cpuAtlas)
+            resetTexelClouds();
+        m_occupancyPyramid.clear();
+        m_voxelGrid.clearGrid();
+        rebinVoxels = true;
+        m_gpuVoxelsDirty = true;
+    }
+
     // In here you can handle key presses
     // key - Integer that corresponds to numbers in https://www.glfw.org/docs/latest/group__keys.html
     // mods - Any modifier keys pressed, like shift or control
@@ -355,23 +1393,70 @@ private:
     Window m_window;
     Camera m_camera;
     VoxelGrid m_voxelGrid;
+    SparseVoxelOctree m_octree;
+    OccupancyPyramid m_occupancyPyramid; // coarser grid lengths of the voxelized grid
+    int m_finestGridLength { m_voxelGrid.gridLength }; // grid length bounded grids are voxelized at, level 0 of the pyramid
+    AtlasReadback m_atlasReadback; // created after the window, which owns the OpenGL context
+    GpuVoxelizer m_gpuVoxelizer;
+    StageTimings m_stageTimings;
+    TexelCompactor m_texelCompactor;
+    TexelCloudCache m_texelCloudCache;
+    AtlasResolution m_atlasResolution; // texel spacing of the meshes' UV mappings
+    AtlasRasterizer m_atlasRasterizer;
+    UvUnwrapper m_uvUnwrapper;
+    TriangleVoxelizer m_triangleVoxelizer;
+    SolidFiller m_solidFiller;
+    GBuffer m_gBuffer;
+    VoxelConeTracer m_coneTracer;
+    ReflectiveShadowMap m_rsm;
+    VoxelRayCaster m_rayCaster;
+    TemporalAccumulator m_temporalAccumulator;
+    BilateralUpsampler m_upsampler;
+    GpuTimings m_gpuTimings;
 
     // Shader for default rendering and for depth rendering
     Shader m_defaultShader;
     Shader m_shadowShader;
     Shader m_atlasShader;
+    Shader m_atlasPackedShader;
+    Shader m_atlasConservativeShader;
+    Shader m_atlasConservativePackedShader;
     Shader m_textureShader;
     Shader m_lineShader;
     Shader m_voxelShader;
+    Shader m_gpuVoxelShader;
+    Shader m_voxelMeshShader;
+    Shader m_gBufferShader;
+    Shader m_giCompositeShader;
+    Shader m_rsmShader;
 
     std::vector<GPUMesh> m_meshes;
+    std::vector<Mesh> m_cpuMeshes;
     Texture m_texture;
     // State
     int m_renderMode{ 0 }; // 0 = render models, 1 = render voxels
     int m_shadingMode{ 0 }; // 0 = diffuse, 1 = world position
+    int m_voxelEngine{ 0 }; // 0 = atlas, 1 = triangle/box overlap (SAT)
+    bool m_solidVoxels{ false }; // fill the interior of the voxelized surface
     bool m_showAtlas{ false }; // whether or not to show world pos atlas
     bool m_showDebug{ false }; // whether or not to show debug voxel grid boundaries
     bool m_useMaterial{ true };
+    int m_giTechnique{ 0 }; // 0 = off, 1 = voxel cone tracing, 2 = near-field voxel ray casting; render mode 0 only
+    ConeTraceSettings m_coneTraceSettings;
+    RayCastSettings m_rayCastSettings;
+    int m_radianceInjection{ 0 }; // cone tracing: 0 = reflective shadow map, 1 = unshadowed Lambert per voxel
+    int m_rsmLength{ 512 }; // 256 to 2048, a power of two
+    TemporalSettings m_temporalSettings;
+    int m_raySpreadFrames{ 4 }; // 1 to 16, a power of two; with temporal accumulation only
+    int m_giResolutionFactor{ 1 }; // 1, 2 or 4: the GI passes run at the window size divided by it
+    uint32_t m_frameIndex{ 0 };
+    glm::mat4 m_previousViewProjection{ 1.0f };
+    uint32_t m_sceneVersion{ 0 }; // bumped when the voxels are rebuilt or the model transform changes
+    uint32_t m_historySceneVersion{ 0 }; // scene version and light position the temporal history was lit with
+    glm::vec3 m_historyLightPos{ 0.0f };
+    float m_indirectStrength{ 1.0f };
+    float m_glossyStrength{ 0.25f };
+    int m_giView{ 0 }; // 0 = direct + indirect, 1 = indirect only, 2 = direct only
 
     // Projection and view matrices for you to fill in and use
     glm::mat4 m_projectionMatrix = glm::perspective(glm::radians(80.0f), 1.0f, 0.1f, 30.0f);
@@ -380,19 +1465,53 @@ private:
     glm::vec3 m_lightPos{ 0.0f, 10.0f, 10.0f };
 
     // Atlas variables
-    GLuint atlasFBO, atlasTexture;
+    GLuint atlasFBO, atlasTexture, atlasNormalTexture, atlasAlbedoTexture;
+    GLuint atlasPlaneBuffer; // attribute planes of the mesh being rendered, see AtlasRasterizer::attributePlanes
+    GLuint atlasStencilBuffer; // texels the center pass of a conservative atlas covered
     int atlasLength = 176; // paper uses 176x176 minimum
+    const std::vector<int> atlasSizes = { 22, 44, 88, 176, 368, 768, 1280 }; // atlas lengths offered by the UI
+    bool m_autoAtlasLength = true; // pick the atlas length from the UV mapping whenever the finest grid length changes
     const float INVALID_COLOR = 0.4f;
 
     // Texture variables
     GLuint quadVAO, quadVBO;
+    GLuint screenVAO; // no attributes, for full screen triangles
 
     // Voxel variables
-    std::vector<glm::vec3> validTexels; // stores valid world positions read from atlas texture
-    std::vector<glm::mat4> modelMatrices;
-    unsigned int instanceVBO;
+    std::vector<TexelCloud> m_texelClouds; // per mesh, valid object space positions and their attributes read from the atlas G-buffer
+    size_t m_nextAtlasMesh = 0; // next mesh whose atlas has to be rendered and read back
+    int m_nextAtlasPass = 0; // next jittered pass of m_nextAtlasMesh
+    TexelCloud m_passTexels; // texels of a jittered pass after the first, before they are appended to the mesh's texel cloud
+    size_t m_missingTexelClouds = 0; // texel clouds that have not been read back yet
+    bool m_asyncReadback = true; // read the atlas back through pixel pack buffers instead of glGetTexImage
+    bool m_cpuAtlas = false; // rasterize the atlas with AtlasRasterizer instead of rendering and reading it back
+    int m_atlasEncoding = 0; // position attachment: 0 = RGB32F, 1 = RGB16F, 2 = R32UI packed voxels of the finest grid (bounded grids only)
+    bool m_readAtlasAttributes = true; // read the normal and albedo attachments back along with the positions
+    bool m_conservativeAtlas = false; // rasterize the atlas conservatively, every texel a triangle overlaps holds a point of it
+    bool m_generateUvCharts = false; // unwrap every mesh with UvUnwrapper, not only the ones whose UVs the atlas cannot use
+    int m_uvChartsAtlasLength = 0; // atlas length the meshes were unwrapped for, 0 if no mesh was
+    int m_atlasJitterPasses = 1; // atlas passes per mesh, sampled at AtlasRasterizer::jitterOffset; the texels of all passes are kept
+    int m_atlasCacheBudgetMB = 256; // memory budget of m_texelCloudCache
+    double m_readbackLatencyMs = 0.0;
+    int m_readbackFramesWaited = 0;
+    std::optional<OccupancyVolume> m_previousOccupancy; // voxels before the last translation change
+    std::vector<uint32_t> voxelInstances; // packed grid positions relative to instanceOrigin, see voxel_instance.h
+    std::vector<glm::uvec2> voxelInstanceAttributes; // per instance packed normal and albedo, see voxel_attributes.h
+    VoxelAttributes m_finestAttributes; // per voxel attribute sums of the finest pyramid level
+    VoxelAttributes m_voxelAttributes; // of the shown grid
+    glm::ivec3 instanceOrigin { 0 };
+    bool rebinVoxels = false; // re-bin the cached texel clouds, set when only the model matrix changed
+    unsigned int instanceVBO, instanceAttributeVBO;
+    size_t instanceCapacity = 0; // number of instances the instance buffer can hold
     unsigned int voxelGridVAO, voxelGridVBO, voxelGridEBO;
     bool voxelsReady = false;
+    bool m_gpuVoxelization = false; // voxelize with compute shaders and draw indirectly, voxels stay on the GPU
+    bool m_gpuVoxelsDirty = true;
+    GLuint gpuVoxelVAO; // cube without the per instance matrix, positions come from the GPU voxelizer
+    GreedyMesher m_greedyMesher;
+    bool m_greedyMeshing = false; // draw the greedy meshed voxel surface instead of instanced cubes
+    bool voxelMeshReady = false;
+    GLuint voxelMeshVAO, voxelMeshVBO, voxelMeshEBO;
 
     // debug variables
     GLuint lineVAO, lineVBO;
@@ -417,7 +1536,31 @@ private:
 
     void loadMeshes() {
         // Load the 3D model into GPU memory.
-        m_meshes = GPUMesh::loadMeshGPU("resources/bunny.obj");
+        // The CPU copies are kept for the CPU atlas rasterizer.
+        m_cpuMeshes = loadMesh("resources/bunny.obj");
+        m_meshes.clear();
+        m_uvChartsAtlasLength = 0;
+        for (Mesh& mesh : m_cpuMeshes) {
+            if (m_generateUvCharts || UvUnwrapper::needsUnwrap(mesh)) {
+                m_uvUnwrapper.unwrap(mesh, atlasLength);
+                m_uvChartsAtlasLength = atlasLength;
+                // The texture does not follow the new layout
+                mesh.material.kdTexture.reset();
+                std::cout << "Generated " << m_uvUnwrapper.chartCount() << " UV charts, " << 100.0 * m_uvUnwrapper.utilization() << "% of the atlas covered"
+                          << std::endl;
+            }
+            m_meshes.emplace_back(mesh);
+        }
+    }
+
+    // The charts are padded in texels of the atlas, so generated UV charts are unwrapped again when the atlas length
+    // changes. The texel cloud cache is keyed by atlas length, and unwrapping at a length always gives the same layout.
+    void updateUvCharts() {
+        if (m_uvChartsAtlasLength == 0 || m_uvChartsAtlasLength == atlasLength) {
+            return;
+        }
+        loadMeshes();
+        m_atlasResolution.analyze(m_cpuMeshes, m_modelMatrix);
     }
 
     void loadShaders() {
@@ -432,10 +1575,39 @@ private:
             shadowBuilder.addStage(GL_VERTEX_SHADER, "shaders/shadow_vert.glsl");
             m_shadowShader = shadowBuilder.build();
 
-            ShaderBuilder atlasBuilder;
-            atlasBuilder.addStage(GL_VERTEX_SHADER, "shaders/atlas_vert.glsl");
-            atlasBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/atlas_frag.glsl");
-            m_atlasShader = atlasBuilder.build();
+            // The atlas fragment shaders take their surface point from atlasSample, which is linked in from a
+            // second fragment shader: the attribute planes at texel centers, or clamped to the triangle when
+            // conservative. The normal and albedo attachments are written by atlas_attributes_frag.glsl.
+            const auto buildAtlasShader = [](const char* fragmentShader, bool conservative) {
+                ShaderBuilder atlasBuilder;
+                atlasBuilder.addStage(GL_VERTEX_SHADER, "shaders/atlas_vert.glsl");
+                if (conservative) {
+                    atlasBuilder.addStage(GL_GEOMETRY_SHADER, "shaders/atlas_conservative_geom.glsl");
+                }
+                atlasBuilder.addStage(GL_FRAGMENT_SHADER, fragmentShader);
+                atlasBuilder.addStage(GL_FRAGMENT_SHADER, conservative ? "shaders/atlas_conservative_frag.glsl" : "shaders/atlas_sample_frag.glsl");
+                atlasBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/atlas_attributes_frag.glsl");
+                return atlasBuilder.build();
+            };
+            m_atlasShader = buildAtlasShader("shaders/atlas_frag.glsl", false);
+            m_atlasPackedShader = buildAtlasShader("shaders/atlas_packed_frag.glsl", false);
+            m_atlasConservativeShader = buildAtlasShader("shaders/atlas_frag.glsl", true);
+            m_atlasConservativePackedShader = buildAtlasShader("shaders/atlas_packed_frag.glsl", true);
+
+            ShaderBuilder gBufferBuilder;
+            gBufferBuilder.addStage(GL_VERTEX_SHADER, "shaders/shader_vert.glsl");
+            gBufferBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/gbuffer_frag.glsl");
+            m_gBufferShader = gBufferBuilder.build();
+
+            ShaderBuilder giCompositeBuilder;
+            giCompositeBuilder.addStage(GL_VERTEX_SHADER, "shaders/screen_vert.glsl");
+            giCompositeBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/gi_composite_frag.glsl");
+            m_giCompositeShader = giCompositeBuilder.build();
+
+            ShaderBuilder rsmBuilder;
+            rsmBuilder.addStage(GL_VERTEX_SHADER, "shaders/shader_vert.glsl");
+            rsmBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/rsm_frag.glsl");
+            m_rsmShader = rsmBuilder.build();
 
             ShaderBuilder textureBuilder;
             textureBuilder.addStage(GL_VERTEX_SHADER, "shaders/texture_vert.glsl");
@@ -452,6 +1624,16 @@ private:
             voxelBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/voxel_frag.glsl");
             m_voxelShader = voxelBuilder.build();
 
+            ShaderBuilder gpuVoxelBuilder;
+            gpuVoxelBuilder.addStage(GL_VERTEX_SHADER, "shaders/voxel_gpu_vert.glsl");
+            gpuVoxelBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/voxel_frag.glsl");
+            m_gpuVoxelShader = gpuVoxelBuilder.build();
+
+            ShaderBuilder voxelMeshBuilder;
+            voxelMeshBuilder.addStage(GL_VERTEX_SHADER, "shaders/voxel_mesh_vert.glsl");
+            voxelMeshBuilder.addStage(GL_FRAGMENT_SHADER, "shaders/voxel_frag.glsl");
+            m_voxelMeshShader = voxelMeshBuilder.build();
+
             // Any new shaders can be added below in similar fashion.
             // ==> Don't forget to reconfigure CMake when you do!
             //     Visual Studio: PROJECT => Generate Cache for ComputerGraphics
@@ -460,7 +1642,7 @@ private:
 
             // Note: Shaders must be compiled and linked successfully. Handle exceptions accordingly.
         }
-        catch (ShaderLoadingException e) {
+        catch (const ShaderLoadingException& e) {
             std::cerr << e.what() << std::endl;
         }
     }
@@ -472,19 +1654,50 @@ private:
 
         glCreateTextures(GL_TEXTURE_2D, 1, &atlasTexture);
         glBindTexture(GL_TEXTURE_2D, atlasTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, atlasLength, atlasLength, 0, GL_RGB, GL_FLOAT, nullptr);
+        // positions in the format of the atlas encoding, see atlasAttachments
+        if (m_atlasEncoding == 0) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, atlasLength, atlasLength, 0, GL_RGB, GL_FLOAT, nullptr);
+        } else if (m_atlasEncoding == 1) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, atlasLength, atlasLength, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, atlasLength, atlasLength, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        }
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glBindTexture(GL_TEXTURE_2D, 0);
 
+        // The rest of the G-buffer in compact formats, 4 bytes per texel each: octahedral normals and albedo
+        glCreateTextures(GL_TEXTURE_2D, 1, &atlasNormalTexture);
+        glTextureStorage2D(atlasNormalTexture, 1, GL_RG16_SNORM, atlasLength, atlasLength);
+        glCreateTextures(GL_TEXTURE_2D, 1, &atlasAlbedoTexture);
+        glTextureStorage2D(atlasAlbedoTexture, 1, GL_RGBA8, atlasLength, atlasLength);
+        for (GLuint texture : { atlasNormalTexture, atlasAlbedoTexture }) {
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlasTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, atlasNormalTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, atlasAlbedoTexture, 0);
+        const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+        glDrawBuffers(3, drawBuffers);
+        glCreateRenderbuffers(1, &atlasStencilBuffer);
+        glNamedRenderbufferStorage(atlasStencilBuffer, GL_STENCIL_INDEX8, atlasLength, atlasLength);
+        glNamedFramebufferRenderbuffer(atlasFBO, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, atlasStencilBuffer);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        glCreateBuffers(1, &atlasPlaneBuffer);
     }
 
     void resetAtlasTexture() {
+        updateUvCharts();
         if (atlasTexture) {
             glDeleteTextures(1, &atlasTexture);
+            glDeleteTextures(1, &atlasNormalTexture);
+            glDeleteTextures(1, &atlasAlbedoTexture);
             glDeleteFramebuffers(1, &atlasFBO);
+            glDeleteRenderbuffers(1, &atlasStencilBuffer);
+            glDeleteBuffers(1, &atlasPlaneBuffer);
             setupAtlasShader();
         }
     }
@@ -557,8 +1770,7 @@ private:
     }
 
     void setupVoxelInstancing() {
-        // Render voxels once this is ready to be rendered
-        // Using instanced cubes to draw them all in one go and speed up rendering
+        // Using instanced cubes to draw all voxels in one go and speed up rendering
         // vertices for each cube representing a voxel in the voxel grid
         float vertices[] = {
             // Front face
@@ -631,29 +1843,190 @@ private:
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, voxelGridEBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-        // Instance Buffer Object for model matrices
+        // Instance Buffer Object for packed grid positions, filled by uploadVoxelInstances
         glCreateBuffers(1, &instanceVBO);
         glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-        glBufferData(GL_ARRAY_BUFFER, modelMatrices.size() * sizeof(glm::mat4), modelMatrices.data(), GL_STATIC_DRAW);
 
-        // set attribute pointes for instance matrix (4 vec4s, since mat4 is just 4 vec4s)
-        size_t vec4Size = sizeof(glm::vec4);
-        for (int i = 0; i < 4; i++) {
-            glEnableVertexAttribArray(3 + i); // locations 3-6
-            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(i * vec4Size));
-            glVertexAttribDivisor(3 + i, 1); // only updates per instance
-        }
+        // one 4 byte integer per instance, the shader unpacks it (the I variant keeps it an integer)
+        glEnableVertexAttribArray(3);
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+        glVertexAttribDivisor(3, 1); // only updates per instance
+
+        // Second instance buffer with the packed normal and albedo of every voxel, filled by uploadVoxelInstances
+        glCreateBuffers(1, &instanceAttributeVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceAttributeVBO);
+        glEnableVertexAttribArray(4);
+        glVertexAttribIPointer(4, 2, GL_UNSIGNED_INT, sizeof(glm::uvec2), (void*)0);
+        glVertexAttribDivisor(4, 1);
 
         glBindVertexArray(0);
 
+        // Same cube for the GPU voxelizer's indirect draws, which read their instances from a shader storage buffer
+        glCreateVertexArrays(1, &gpuVoxelVAO);
+        glVertexArrayVertexBuffer(gpuVoxelVAO, 0, voxelGridVBO, 0, 6 * sizeof(float));
+        glVertexArrayElementBuffer(gpuVoxelVAO, voxelGridEBO);
+        for (GLuint attribute = 0; attribute < 2; attribute++) {
+            glEnableVertexArrayAttrib(gpuVoxelVAO, attribute);
+            glVertexArrayAttribFormat(gpuVoxelVAO, attribute, 3, GL_FLOAT, GL_FALSE, attribute * 3 * sizeof(float));
+            glVertexArrayAttribBinding(gpuVoxelVAO, attribute, 0);
+        }
+
+        // Greedy meshed surface, same vertex layout as the cube, filled by buildVoxelMesh
+        glCreateBuffers(1, &voxelMeshVBO);
+        glCreateBuffers(1, &voxelMeshEBO);
+        glCreateVertexArrays(1, &voxelMeshVAO);
+        glVertexArrayVertexBuffer(voxelMeshVAO, 0, voxelMeshVBO, 0, sizeof(GreedyMesher::Vertex));
+        glVertexArrayElementBuffer(voxelMeshVAO, voxelMeshEBO);
+        for (GLuint attribute = 0; attribute < 2; attribute++) {
+            glEnableVertexArrayAttrib(voxelMeshVAO, attribute);
+            glVertexArrayAttribFormat(voxelMeshVAO, attribute, 3, GL_FLOAT, GL_FALSE, attribute * sizeof(glm::vec3));
+            glVertexArrayAttribBinding(voxelMeshVAO, attribute, 0);
+        }
+    }
+
+    void uploadVoxelInstances() {
+        // Render voxels once this is ready to be rendered
+        // The instance buffer is only reallocated when it grows, otherwise its contents are overwritten in place
+        if (voxelInstances.size() > instanceCapacity) {
+            instanceCapacity = voxelInstances.size();
+            glNamedBufferData(instanceVBO, instanceCapacity * sizeof(uint32_t), voxelInstances.data(), GL_DYNAMIC_DRAW);
+            glNamedBufferData(instanceAttributeVBO, instanceCapacity * sizeof(glm::uvec2), voxelInstanceAttributes.data(), GL_DYNAMIC_DRAW);
+        } else {
+            glNamedBufferSubData(instanceVBO, 0, voxelInstances.size() * sizeof(uint32_t), voxelInstances.data());
+            glNamedBufferSubData(instanceAttributeVBO, 0, voxelInstanceAttributes.size() * sizeof(glm::uvec2), voxelInstanceAttributes.data());
+        }
+
         voxelsReady = true;
+        ++m_sceneVersion;
         std::cout << "Voxels ready to be rendered!" << std::endl;
     }
 };
 
-int main()
+// Voxelizes the scene without a window or OpenGL context: the atlas is rasterized on the CPU, or the triangles
+// are voxelized directly.
+static int headlessVoxelize(int atlasLength, int gridLength, bool triangleEngine, bool conservative, int jitterPasses, bool generateUvCharts)
+{
+    const float invalidValue = 0.4f;
+    std::vector<Mesh> meshes = loadMesh("resources/bunny.obj");
+
+    AtlasRasterizer rasterizer;
+    TexelCompactor compactor;
+    TriangleVoxelizer triangleVoxelizer;
+    StageTimings timings;
+    UvUnwrapper unwrapper;
+    // The charts are padded in texels of the atlas. An automatic length is picked from charts for a 1024 atlas, then
+    // the meshes are unwrapped again for it.
+    const auto unwrapMeshes = [&](int length) {
+        bool unwrapped = false;
+        for (Mesh& mesh : meshes) {
+            if (!triangleEngine && (generateUvCharts || UvUnwrapper::needsUnwrap(mesh))) {
+                const auto timer = timings.measure("UV unwrapping");
+                unwrapper.unwrap(mesh, length);
+                unwrapped = true;
+                std::cout << "Generated " << unwrapper.chartCount() << " UV charts, " << 100.0 * unwrapper.utilization() << "% of the atlas covered" << std::endl;
+            }
+        }
+        return unwrapped;
+    };
+    const bool unwrapped = unwrapMeshes(atlasLength > 0 ? atlasLength : 1024);
+    VoxelGrid voxelGrid;
+    voxelGrid.gridLength = gridLength;
+    voxelGrid.calculateVoxelScale();
+    voxelGrid.clearGrid();
+    if (atlasLength <= 0 && !triangleEngine) {
+        // "auto": the smallest length that keeps the texels at most one voxel apart, not limited to the UI lengths
+        AtlasResolution resolution;
+        resolution.analyze(meshes, glm::mat4(1.0f));
+        atlasLength = resolution.requiredLength(voxelGrid.voxelScale);
+        std::cout << "Automatic atlas length " << atlasLength << ", texels within a voxel on "
+                  << 100.0 * resolution.spacingMetFraction(atlasLength, voxelGrid.voxelScale) << "% of the surface" << std::endl;
+        if (unwrapped) {
+            meshes = loadMesh("resources/bunny.obj");
+            unwrapMeshes(atlasLength);
+        }
+    }
+
+    std::vector<glm::vec3> texels;
+    for (const Mesh& mesh : meshes) {
+        if (triangleEngine) {
+            const auto timer = timings.measure("Triangle voxelization");
+            triangleVoxelizer.voxelize(mesh, glm::mat4(1.0f), voxelGrid.worldMin, voxelGrid.worldMax, voxelGrid.occupancy);
+            continue;
+        }
+        for (int pass = 0; pass < jitterPasses; ++pass) {
+            {
+                const auto timer = timings.measure("Atlas rasterization (CPU)");
+                rasterizer.rasterize(mesh, atlasLength, invalidValue, AtlasSampling { pass, conservative });
+            }
+            {
+                const auto timer = timings.measure("Texel compaction");
+                compactor.compact(rasterizer.positions(), invalidValue, texels);
+            }
+            const auto timer = timings.measure("Voxel binning");
+            for (const glm::vec3& objectPos : texels) {
+                voxelGrid.markGridPositionOccupied(voxelGrid.worldToGridPosition(objectPos));
+            }
+        }
+    }
+
+    std::cout << "Voxelized " << meshes.size() << " meshes into " << voxelGrid.occupancy.count() << " voxels ("
+              << (triangleEngine ? "triangle engine" : "atlas " + std::to_string(atlasLength) + (conservative ? " conservative" : "")
+                         + " x" + std::to_string(jitterPasses) + " passes")
+              << ", grid " << gridLength << ", "
+              << rasterizer.numThreads() << " threads)" << std::endl;
+    for (const StageTimings::Entry& entry : timings.entries()) {
+        std::cout << "  " << entry.name << ": " << entry.milliseconds << " ms" << std::endl;
+    }
+    return 0;
+}
+
+// Parses a command line argument that has to be a positive integer, returns false for anything else.
+static bool parsePositive(std::string_view argument, int& value)
+{
+    int parsed = 0;
+    const auto [end, error] = std::from_chars(argument.data(), argument.data() + argument.size(), parsed);
+    if (error != std::errc() || end != argument.data() + argument.size() || parsed <= 0)
+        return false;
+    value = parsed;
+    return true;
+}
+
+int main(int argc, char** argv)
 {
+    // No window is opened, so this runs on machines without a GPU
+    if (argc > 1 && std::string_view(argv[1]) == "--headless-voxelize") {
+        // "auto" picks the atlas length from the UV mapping, 0 stands for it below
+        int atlasLength = 176;
+        int gridLength = 64;
+        int jitterPasses = 1;
+        const std::string_view engine = argc > 4 ? argv[4] : "atlas";
+        const std::string_view charts = argc > 6 ? argv[6] : "";
+        bool valid = engine == "atlas" || engine == "conservative" || engine == "sat";
+        valid = valid && (charts.empty() || charts == "charts");
+        if (argc > 2 && std::string_view(argv[2]) == "auto")
+            atlasLength = 0;
+        else if (argc > 2)
+            valid = valid && parsePositive(argv[2], atlasLength);
+        valid = valid && (argc <= 3 || parsePositive(argv[3], gridLength));
+        valid = valid && (argc <= 5 || parsePositive(argv[5], jitterPasses));
+        if (!valid || argc > 7) {
+            std::cerr << "Usage: " << argv[0] << " --headless-voxelize [atlasLength|auto] [gridLength] [atlas|conservative|sat] [jitterPasses] [charts]" << std::endl
+                      << "atlasLength, gridLength and jitterPasses are positive integers" << std::endl;
+            return 1;
+        }
+        // "sat" voxelizes the triangles, "conservative" rasterizes the atlas conservatively
+        const bool triangleEngine = engine == "sat";
+        const bool conservative = engine == "conservative";
+        // "charts" replaces the UVs by generated charts, meshes whose UVs the atlas cannot use always get them
+        const bool generateUvCharts = charts == "charts";
+        return headlessVoxelize(atlasLength, gridLength, triangleEngine, conservative, jitterPasses, generateUvCharts);
+    }
+
     Application app;
+    // Headless check of the GPU voxelization against the CPU path, also runs on Mesa's software renderer
+    if (argc > 1 && std::string_view(argv[1]) == "--check-gpu-voxelization") {
+        return app.crossCheckGpuVoxels() ? 0 : 1;
+    }
     app.update();
 
     return 0;
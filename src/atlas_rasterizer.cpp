@@ -0,0 +1,441 @@
+#include "atlas_rasterizer.h"
+#include "parallel.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+constexpr int64_t subpixelOne = int64_t(1) << AtlasRasterizer::subpixelBits;
+constexpr int64_t subpixelHalf = subpixelOne / 2;
+// Snapped coordinates are kept within +-2^29 subpixels so the 64-bit edge functions cannot overflow.
+constexpr float maxSubpixelCoordinate = float(1 << 29);
+constexpr size_t setupWidth = 8;
+
+// Snapped window positions and bounds of setupWidth triangles, structure of arrays.
+struct SetupBatch {
+    int32_t x[3][setupWidth];
+    int32_t y[3][setupWidth];
+    int32_t minX[setupWidth], minY[setupWidth], maxX[setupWidth], maxY[setupWidth];
+    double area[setupWidth]; // twice the signed area in subpixels^2
+    bool valid[setupWidth];
+};
+
+// Window coordinate of a texture coordinate, the same float operations as gl_Position = texCoord * 2 - 1 - clipOffset
+// followed by the viewport transform, which the driver does with a fused multiply-add.
+float toWindow(float texCoord, float clipOffset, float halfLength)
+{
+    return std::fma(texCoord * 2.0f - 1.0f - clipOffset, halfLength, halfLength);
+}
+
+// Attribute planes of a triangle over its unsnapped window positions, which is what the interpolators see. Computed in
+// double and rounded once; triangles without area in floats get constant planes.
+void computePlanes(const Mesh& mesh, const glm::uvec3& indices, const glm::vec2& clipOffset, float halfLength,
+    glm::vec2 window[3], glm::vec3 values[2], glm::vec3 dadx[2], glm::vec3 dady[2])
+{
+    for (int v = 0; v < 3; ++v) {
+        const glm::vec2 uv = mesh.vertices[indices[v]].texCoord;
+        window[v] = glm::vec2(toWindow(uv.x, clipOffset.x, halfLength), toWindow(uv.y, clipOffset.y, halfLength));
+    }
+    const glm::dvec2 e1 = glm::dvec2(window[1] - window[0]);
+    const glm::dvec2 e2 = glm::dvec2(window[2] - window[0]);
+    const double det = e1.x * e2.y - e1.y * e2.x;
+    for (int attribute = 0; attribute < 2; ++attribute) {
+        glm::dvec3 vertexValues[3];
+        for (int v = 0; v < 3; ++v) {
+            const Vertex& vertex = mesh.vertices[indices[v]];
+            vertexValues[v] = glm::dvec3(attribute == 0 ? vertex.position : vertex.normal);
+        }
+        const glm::dvec3 d1 = vertexValues[1] - vertexValues[0];
+        const glm::dvec3 d2 = vertexValues[2] - vertexValues[0];
+        values[attribute] = glm::vec3(vertexValues[0]);
+        dadx[attribute] = det == 0.0 ? glm::vec3(0.0f) : glm::vec3((d1 * e2.y - d2 * e1.y) / det);
+        dady[attribute] = det == 0.0 ? glm::vec3(0.0f) : glm::vec3((d2 * e1.x - d1 * e2.x) / det);
+    }
+}
+
+// Radical inverse of index in base, the coordinates of the Halton sequence.
+float radicalInverse(int index, int base)
+{
+    float result = 0.0f, digitWeight = 1.0f / float(base);
+    for (; index > 0; index /= base, digitWeight /= float(base))
+        result += float(index % base) * digitWeight;
+    return result;
+}
+
+// Point of triangle abc closest to p (Ericson, Real-Time Collision Detection 5.1.5). Mirrored by closestBarycentrics in
+// shaders/atlas_conservative_frag.glsl.
+glm::vec2 closestPoint(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c)
+{
+    const glm::vec2 ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+    const glm::vec2 bp = p - b;
+    const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+    const glm::vec2 cp = p - c;
+    const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    // Inside the triangle, only reached where snapping moved an edge past p.
+    const float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// First texel whose center lies at or after a subpixel coordinate, and last one at or before it.
+int32_t firstTexel(int32_t subpixel)
+{
+    return (subpixel - int32_t(subpixelHalf) + int32_t(subpixelOne) - 1) >> AtlasRasterizer::subpixelBits;
+}
+int32_t lastTexel(int32_t subpixel)
+{
+    return (subpixel - int32_t(subpixelHalf)) >> AtlasRasterizer::subpixelBits;
+}
+
+void setupScalar(const Mesh& mesh, size_t first, size_t count, const glm::vec2& clipOffset, float halfLength, SetupBatch& batch)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const glm::uvec3& triangle = mesh.triangles[first + i];
+        bool inRange = true;
+        for (int v = 0; v < 3; ++v) {
+            const glm::vec2 uv = mesh.vertices[triangle[v]].texCoord;
+            const float x = std::nearbyint(toWindow(uv.x, clipOffset.x, halfLength) * float(subpixelOne));
+            const float y = std::nearbyint(toWindow(uv.y, clipOffset.y, halfLength) * float(subpixelOne));
+            inRange &= std::abs(x) < maxSubpixelCoordinate && std::abs(y) < maxSubpixelCoordinate;
+            batch.x[v][i] = inRange ? int32_t(x) : 0;
+            batch.y[v][i] = inRange ? int32_t(y) : 0;
+        }
+        const int32_t minX = std::min({ batch.x[0][i], batch.x[1][i], batch.x[2][i] });
+        const int32_t minY = std::min({ batch.y[0][i], batch.y[1][i], batch.y[2][i] });
+        const int32_t maxX = std::max({ batch.x[0][i], batch.x[1][i], batch.x[2][i] });
+        const int32_t maxY = std::max({ batch.y[0][i], batch.y[1][i], batch.y[2][i] });
+        batch.minX[i] = firstTexel(minX);
+        batch.minY[i] = firstTexel(minY);
+        batch.maxX[i] = lastTexel(maxX);
+        batch.maxY[i] = lastTexel(maxY);
+        batch.area[i] = double(batch.x[1][i] - batch.x[0][i]) * double(batch.y[2][i] - batch.y[0][i])
+            - double(batch.y[1][i] - batch.y[0][i]) * double(batch.x[2][i] - batch.x[0][i]);
+        batch.valid[i] = inRange;
+    }
+}
+
+#if defined(__AVX2__)
+// setupScalar for 8 triangles at once.
+void setup8(const Mesh& mesh, size_t first, const glm::vec2& clipOffset, float halfLength, SetupBatch& batch)
+{
+    alignas(32) float u[3][setupWidth], v[3][setupWidth];
+    for (size_t i = 0; i < setupWidth; ++i) {
+        const glm::uvec3& triangle = mesh.triangles[first + i];
+        for (int k = 0; k < 3; ++k) {
+            u[k][i] = mesh.vertices[triangle[k]].texCoord.x;
+            v[k][i] = mesh.vertices[triangle[k]].texCoord.y;
+        }
+    }
+
+    const __m256 two = _mm256_set1_ps(2.0f), one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(halfLength), scale = _mm256_set1_ps(float(subpixelOne));
+    const __m256 limit = _mm256_set1_ps(maxSubpixelCoordinate);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    // Rounds like toWindow.
+    const auto snap = [&](const float* texCoords, float offset, __m256& inRange) {
+        const __m256 clip = _mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_load_ps(texCoords), two), one), _mm256_set1_ps(offset));
+        const __m256 window = _mm256_mul_ps(_mm256_fmadd_ps(clip, half, half), scale);
+        const __m256 rounded = _mm256_round_ps(window, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        inRange = _mm256_and_ps(inRange, _mm256_cmp_ps(_mm256_and_ps(rounded, absMask), limit, _CMP_LT_OQ));
+        return _mm256_cvtps_epi32(rounded);
+    };
+
+    __m256 inRange = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    __m256i x[3], y[3];
+    for (int k = 0; k < 3; ++k) {
+        x[k] = snap(u[k], clipOffset.x, inRange);
+        y[k] = snap(v[k], clipOffset.y, inRange);
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    for (int k = 0; k < 3; ++k) {
+        x[k] = _mm256_blendv_epi8(zero, x[k], _mm256_castps_si256(inRange));
+        y[k] = _mm256_blendv_epi8(zero, y[k], _mm256_castps_si256(inRange));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(batch.x[k]), x[k]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(batch.y[k]), y[k]);
+    }
+
+    // Texel bounds, see firstTexel and lastTexel.
+    const __m256i firstBias = _mm256_set1_epi32(int32_t(subpixelOne - 1 - subpixelHalf));
+    const __m256i lastBias = _mm256_set1_epi32(int32_t(-subpixelHalf));
+    const __m256i minX = _mm256_min_epi32(x[0], _mm256_min_epi32(x[1], x[2]));
+    const __m256i minY = _mm256_min_epi32(y[0], _mm256_min_epi32(y[1], y[2]));
+    const __m256i maxX = _mm256_max_epi32(x[0], _mm256_max_epi32(x[1], x[2]));
+    const __m256i maxY = _mm256_max_epi32(y[0], _mm256_max_epi32(y[1], y[2]));
+    constexpr int bits = AtlasRasterizer::subpixelBits;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(batch.minX), _mm256_srai_epi32(_mm256_add_epi32(minX, firstBias), bits));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(batch.minY), _mm256_srai_epi32(_mm256_add_epi32(minY, firstBias), bits));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(batch.maxX), _mm256_srai_epi32(_mm256_add_epi32(maxX, lastBias), bits));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(batch.maxY), _mm256_srai_epi32(_mm256_add_epi32(maxY, lastBias), bits));
+
+    // Edge products need up to 2 * 30 bits, doubles hold them exactly.
+    const __m256i dx1 = _mm256_sub_epi32(x[1], x[0]), dy1 = _mm256_sub_epi32(y[1], y[0]);
+    const __m256i dx2 = _mm256_sub_epi32(x[2], x[0]), dy2 = _mm256_sub_epi32(y[2], y[0]);
+    for (int h = 0; h < 2; ++h) {
+        const auto lane = [h](__m256i value) {
+            return _mm256_cvtepi32_pd(h == 0 ? _mm256_castsi256_si128(value) : _mm256_extracti128_si256(value, 1));
+        };
+        const __m256d area = _mm256_sub_pd(_mm256_mul_pd(lane(dx1), lane(dy2)), _mm256_mul_pd(lane(dy1), lane(dx2)));
+        _mm256_storeu_pd(&batch.area[h * 4], area);
+    }
+
+    const int inRangeMask = _mm256_movemask_ps(inRange);
+    for (size_t i = 0; i < setupWidth; ++i)
+        batch.valid[i] = (inRangeMask >> i) & 1;
+}
+#endif
+}
+
+AtlasRasterizer::AtlasRasterizer(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+glm::vec2 AtlasRasterizer::jitterOffset(int pass)
+{
+    if (pass == 0)
+        return glm::vec2(0.0f);
+    return glm::vec2(radicalInverse(pass, 2), radicalInverse(pass, 3)) - 0.5f;
+}
+
+glm::vec2 AtlasRasterizer::jitterClipOffset(int pass, int atlasLength)
+{
+    return jitterOffset(pass) * (2.0f / float(atlasLength));
+}
+
+std::vector<AtlasAttributePlanes> AtlasRasterizer::attributePlanes(const Mesh& mesh, int atlasLength, int jitterPass)
+{
+    const glm::vec2 clipOffset = jitterClipOffset(jitterPass, atlasLength);
+    const float halfLength = 0.5f * float(atlasLength);
+    std::vector<AtlasAttributePlanes> planes(mesh.triangles.size());
+    for (size_t i = 0; i < planes.size(); ++i) {
+        glm::vec2 window[3];
+        glm::vec3 values[2], dadx[2], dady[2];
+        computePlanes(mesh, mesh.triangles[i], clipOffset, halfLength, window, values, dadx, dady);
+        AtlasAttributePlanes& plane = planes[i];
+        plane.origin = glm::vec4(window[0], 0.0f, 0.0f);
+        for (int attribute = 0; attribute < 2; ++attribute) {
+            plane.value[attribute] = glm::vec4(values[attribute], 0.0f);
+            plane.ddx[attribute] = glm::vec4(dadx[attribute], 0.0f);
+            plane.ddy[attribute] = glm::vec4(dady[attribute], 0.0f);
+        }
+    }
+    return planes;
+}
+
+void AtlasRasterizer::rasterize(const Mesh& mesh, int atlasLength, float clearValue, const AtlasSampling& sampling)
+{
+    m_atlasLength = atlasLength;
+    m_tilesPerRow = (atlasLength + tileLength - 1) / tileLength;
+    const size_t numTexels = size_t(atlasLength) * size_t(atlasLength);
+    m_positions.assign(numTexels, glm::vec3(clearValue));
+    m_normals.assign(numTexels, glm::vec3(clearValue));
+
+    setupTriangles(mesh, jitterClipOffset(sampling.jitterPass, atlasLength), sampling.conservative);
+    binTriangles();
+
+    const size_t numTiles = size_t(m_tilesPerRow) * size_t(m_tilesPerRow);
+    parallel::forEachChunk(numTiles, unsigned(std::min<size_t>(m_numThreads, numTiles)), [&](unsigned, size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile)
+            rasterizeTile(int(tile % size_t(m_tilesPerRow)), int(tile / size_t(m_tilesPerRow)), sampling.conservative);
+    });
+}
+
+void AtlasRasterizer::setupTriangles(const Mesh& mesh, const glm::vec2& clipOffset, bool conservative)
+{
+    const float halfLength = 0.5f * float(m_atlasLength);
+    const size_t numTriangles = mesh.triangles.size();
+    const unsigned numChunks = unsigned(std::clamp<size_t>(numTriangles / 1024, 1, m_numThreads));
+    std::vector<std::vector<Triangle>> chunkTriangles(numChunks);
+
+    parallel::forEachChunk(numTriangles, numChunks, [&](unsigned chunk, size_t begin, size_t end) {
+        std::vector<Triangle>& triangles = chunkTriangles[chunk];
+        SetupBatch batch;
+        for (size_t first = begin; first < end; first += setupWidth) {
+            const size_t count = std::min(setupWidth, end - first);
+#if defined(__AVX2__)
+            if (count == setupWidth)
+                setup8(mesh, first, clipOffset, halfLength, batch);
+            else
+#endif
+                setupScalar(mesh, first, count, clipOffset, halfLength, batch);
+
+            for (size_t i = 0; i < count; ++i) {
+                // Zero area triangles produce no fragments, neither do triangles between texel centers.
+                if (!batch.valid[i] || batch.area[i] == 0.0)
+                    continue;
+                Triangle triangle;
+                if (conservative) {
+                    // Texel x spans subpixels [x, x + 1] << subpixelBits, every texel touching the bounds is a candidate.
+                    const int32_t minX = std::min({ batch.x[0][i], batch.x[1][i], batch.x[2][i] });
+                    const int32_t minY = std::min({ batch.y[0][i], batch.y[1][i], batch.y[2][i] });
+                    const int32_t maxX = std::max({ batch.x[0][i], batch.x[1][i], batch.x[2][i] });
+                    const int32_t maxY = std::max({ batch.y[0][i], batch.y[1][i], batch.y[2][i] });
+                    batch.minX[i] = ((minX + int32_t(subpixelOne) - 1) >> subpixelBits) - 1;
+                    batch.minY[i] = ((minY + int32_t(subpixelOne) - 1) >> subpixelBits) - 1;
+                    batch.maxX[i] = maxX >> subpixelBits;
+                    batch.maxY[i] = maxY >> subpixelBits;
+                }
+                triangle.minX = std::max(batch.minX[i], 0);
+                triangle.minY = std::max(batch.minY[i], 0);
+                triangle.maxX = std::min(batch.maxX[i], m_atlasLength - 1);
+                triangle.maxY = std::min(batch.maxY[i], m_atlasLength - 1);
+                if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+                    continue;
+
+                // Make the triangle counter-clockwise, texture space has no front or back faces.
+                int order[3] = { 0, 1, 2 };
+                if (batch.area[i] < 0.0)
+                    std::swap(order[1], order[2]);
+                int64_t x[3], y[3];
+                for (int v = 0; v < 3; ++v) {
+                    x[v] = batch.x[order[v]][i];
+                    y[v] = batch.y[order[v]][i];
+                }
+
+                // Edge k runs from vertex k to vertex k + 1, texels on its left are inside. Texel centers exactly on an
+                // edge belong to the triangle if it is a left edge (running down) or a horizontal edge below the triangle
+                // (running towards +x). With y pointing up this is the usual top-left rule of a y-down window.
+                for (int k = 0; k < 3; ++k) {
+                    const int next = (k + 1) % 3;
+                    const int64_t a = y[k] - y[next];
+                    const int64_t b = x[next] - x[k];
+                    const bool bottomLeft = a > 0 || (a == 0 && b > 0);
+                    // E at the center of texel (0, 0), inside where E > 0.
+                    const int64_t c = a * (subpixelHalf - x[k]) + b * (subpixelHalf - y[k]);
+                    triangle.edgeA[k] = a * subpixelOne;
+                    triangle.edgeB[k] = b * subpixelOne;
+                    triangle.edgeC[k] = c + (bottomLeft ? 1 : 0);
+                    // The texel square overlaps the edge's half plane if its corner furthest inside does, E >= 0 there.
+                    triangle.conservativeBias[k] = conservative ? (std::abs(a) + std::abs(b)) * subpixelHalf + 1 - (bottomLeft ? 1 : 0) : 0;
+                }
+
+                computePlanes(mesh, mesh.triangles[first + i], clipOffset, halfLength, triangle.window, triangle.attributes, triangle.dadx, triangle.dady);
+                triangles.push_back(triangle);
+            }
+        }
+    });
+
+    m_triangles.clear();
+    for (const std::vector<Triangle>& triangles : chunkTriangles)
+        m_triangles.insert(m_triangles.end(), triangles.begin(), triangles.end());
+}
+
+void AtlasRasterizer::binTriangles()
+{
+    const size_t numTiles = size_t(m_tilesPerRow) * size_t(m_tilesPerRow);
+    const unsigned numChunks = unsigned(std::clamp<size_t>(m_triangles.size() / 1024, 1, m_numThreads));
+    m_bins.resize(numChunks);
+    parallel::forEachChunk(m_triangles.size(), numChunks, [&](unsigned chunk, size_t begin, size_t end) {
+        std::vector<std::vector<uint32_t>>& bins = m_bins[chunk];
+        bins.resize(numTiles);
+        for (std::vector<uint32_t>& bin : bins)
+            bin.clear();
+        for (size_t i = begin; i < end; ++i) {
+            const Triangle& triangle = m_triangles[i];
+            for (int tileY = triangle.minY / tileLength; tileY <= triangle.maxY / tileLength; ++tileY) {
+                for (int tileX = triangle.minX / tileLength; tileX <= triangle.maxX / tileLength; ++tileX)
+                    bins[size_t(tileY) * size_t(m_tilesPerRow) + size_t(tileX)].push_back(uint32_t(i));
+            }
+        }
+    });
+}
+
+void AtlasRasterizer::rasterizeTile(int tileX, int tileY, bool conservative)
+{
+    const size_t tile = size_t(tileY) * size_t(m_tilesPerRow) + size_t(tileX);
+    const int tileMinX = tileX * tileLength, tileMinY = tileY * tileLength;
+    const int tileMaxX = std::min(tileMinX + tileLength, m_atlasLength) - 1;
+    const int tileMaxY = std::min(tileMinY + tileLength, m_atlasLength) - 1;
+
+    const auto shade = [&](const Triangle& triangle, int x, int y, const glm::vec2& sample) {
+        const size_t texel = size_t(y) * size_t(m_atlasLength) + size_t(x);
+        const float dx = sample.x - triangle.window[0].x;
+        const float dy = sample.y - triangle.window[0].y;
+        m_positions[texel] = triangle.attributes[0] + triangle.dadx[0] * dx + triangle.dady[0] * dy;
+        m_normals[texel] = triangle.attributes[1] + triangle.dadx[1] * dx + triangle.dady[1] * dy;
+    };
+
+    // Calls f(triangle, x, y) for the texels of the tile where the edge functions plus bias are positive. Chunks hold
+    // consecutive triangles, so walking them in order draws in primitive order and later triangles overwrite earlier ones.
+    const auto forEachCovered = [&](bool useBias, const auto& f) {
+        for (const std::vector<std::vector<uint32_t>>& bins : m_bins) {
+            for (uint32_t index : bins[tile]) {
+                const Triangle& triangle = m_triangles[index];
+                const int minX = std::max(triangle.minX, tileMinX), maxX = std::min(triangle.maxX, tileMaxX);
+                const int minY = std::max(triangle.minY, tileMinY), maxY = std::min(triangle.maxY, tileMaxY);
+                if (minX > maxX || minY > maxY)
+                    continue;
+
+                int64_t rowEdge[3];
+                for (int k = 0; k < 3; ++k)
+                    rowEdge[k] = triangle.edgeA[k] * minX + triangle.edgeB[k] * minY + triangle.edgeC[k] + (useBias ? triangle.conservativeBias[k] : 0);
+
+                for (int y = minY; y <= maxY; ++y) {
+                    int x = minX;
+#if defined(__AVX2__)
+                    // 4 texels per step, the edge functions need 64 bits.
+                    __m256i edge[3], step[3];
+                    for (int k = 0; k < 3; ++k) {
+                        const int64_t a = triangle.edgeA[k];
+                        edge[k] = _mm256_add_epi64(_mm256_set1_epi64x(rowEdge[k]), _mm256_setr_epi64x(0, a, 2 * a, 3 * a));
+                        step[k] = _mm256_set1_epi64x(4 * a);
+                    }
+                    const __m256i zero = _mm256_setzero_si256();
+                    for (; x + 3 <= maxX; x += 4) {
+                        const __m256i inside = _mm256_and_si256(_mm256_cmpgt_epi64(edge[0], zero),
+                            _mm256_and_si256(_mm256_cmpgt_epi64(edge[1], zero), _mm256_cmpgt_epi64(edge[2], zero)));
+                        for (int mask = _mm256_movemask_pd(_mm256_castsi256_pd(inside)); mask; mask &= mask - 1)
+                            f(triangle, x + std::countr_zero(unsigned(mask)), y);
+                        for (int k = 0; k < 3; ++k)
+                            edge[k] = _mm256_add_epi64(edge[k], step[k]);
+                    }
+#endif
+                    for (; x <= maxX; ++x) {
+                        const int64_t offset = int64_t(x - minX);
+                        bool inside = true;
+                        for (int k = 0; k < 3; ++k)
+                            inside &= rowEdge[k] + triangle.edgeA[k] * offset > 0;
+                        if (inside)
+                            f(triangle, x, y);
+                    }
+                    for (int k = 0; k < 3; ++k)
+                        rowEdge[k] += triangle.edgeB[k];
+                }
+            }
+        }
+    };
+
+    // Texels whose center a triangle covers take that triangle's center sample, in both modes.
+    std::array<uint32_t, tileLength> centerCovered {}; // bit x - tileMinX of row y - tileMinY
+    forEachCovered(false, [&](const Triangle& triangle, int x, int y) {
+        shade(triangle, x, y, glm::vec2(float(x) + 0.5f, float(y) + 0.5f));
+        centerCovered[size_t(y - tileMinY)] |= 1u << (x - tileMinX);
+    });
+    if (!conservative)
+        return;
+    // Conservative coverage only fills the texels no center sample reached, with the point of the triangle closest
+    // to the center, so the conservative texels are a superset of the center sampled ones.
+    forEachCovered(true, [&](const Triangle& triangle, int x, int y) {
+        if (!(centerCovered[size_t(y - tileMinY)] & (1u << (x - tileMinX))))
+            shade(triangle, x, y, closestPoint(glm::vec2(float(x) + 0.5f, float(y) + 0.5f), triangle.window[0], triangle.window[1], triangle.window[2]));
+    });
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <framework/mesh.h>
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Which texels of the atlas a triangle covers. The default samples texel centers, like OpenGL.
+struct AtlasSampling {
+    int jitterPass { 0 }; // samples at AtlasRasterizer::jitterOffset(jitterPass) from the texel centers
+    bool conservative { false }; // every texel the triangle overlaps
+
+    bool operator==(const AtlasSampling&) const = default;
+};
+
+// Attribute planes of one triangle in window coordinates, laid out (std430) like AttributePlanes in
+// shaders/atlas_sample_frag.glsl. The attributes at window position p are value + ddx * (p.x - origin.x) + ddy *
+// (p.y - origin.y), evaluated with separate multiplies and adds.
+struct AtlasAttributePlanes {
+    glm::vec4 origin; // xy: unsnapped window position of the triangle's first vertex
+    glm::vec4 value[2]; // position and normal at the origin
+    glm::vec4 ddx[2];
+    glm::vec4 ddy[2];
+};
+
+// CPU replacement for the atlas pass (renderAtlas with atlas_vert.glsl / atlas_frag.glsl), so meshes can be
+// voxelized without an OpenGL context.
+//
+// Triangles are rasterized at their texture coordinates like the GPU does: vertices are snapped to 8 bits of
+// subpixel precision, texels are sampled at their centers with integer edge functions and GL's fill rule,
+// and attributes are interpolated with plane equations. Where triangles overlap the later one wins, as with
+// GL's primitive order. Interpolation order is up to the driver, so the GPU atlas does not use the interpolators:
+// atlas_sample_frag.glsl evaluates the planes of attributePlanes() at gl_FragCoord with the same float operations
+// as rasterize() (this file is built without FMA contraction), and the two atlases match bit for bit. The exception
+// are triangles that reach outside the [0, 1] texture square, GL clips them and snaps the clipped vertices again.
+//
+// An atlas misses the voxels that fall between its samples, and sliver triangles can fall between texel centers
+// altogether. AtlasSampling offers two ways to find more of them without a larger atlas. Jittered passes sample
+// the texels at a different point each; the caller keeps the texels of all passes, so N passes sample the surface
+// like an atlas sqrt(N) times longer. Conservative rasterization keeps every center sample and additionally fills
+// the texels no triangle covers at the center but some triangle overlaps, with the point of that triangle closest
+// to the texel center. That recovers slivers and chart borders, so its voxels are a superset of the center sampled
+// ones, but it adds nothing where the texels are already covered: holes from texels that lie further apart than a
+// voxel need jittered passes or a longer atlas. The GPU tests conservative coverage in floats
+// (atlas_conservative_frag.glsl), so texels the triangle only touches at a corner or edge can differ.
+//
+// Triangle setup runs 8 triangles at a time (AVX2). Triangles are binned into 16x16 texel tiles by contiguous
+// chunks of triangles in parallel, then tiles are rasterized in parallel, each walking its bins in triangle order.
+class AtlasRasterizer {
+public:
+    static constexpr int tileLength = 16;
+    static constexpr int subpixelBits = 8;
+
+    // numThreads = 0 uses all hardware threads.
+    explicit AtlasRasterizer(unsigned numThreads = 0);
+
+    // Rasterizes mesh into an atlasLength^2 atlas of object space positions and normals. Texels that no triangle
+    // covers are set to clearValue in all components, like glClear with INVALID_COLOR.
+    void rasterize(const Mesh& mesh, int atlasLength, float clearValue, const AtlasSampling& sampling = {});
+
+    // Sample position of a jittered pass relative to the texel center, in texels: the center for pass 0, then the
+    // points of the (2, 3) Halton sequence.
+    static glm::vec2 jitterOffset(int pass);
+    // jitterOffset as a clip space translation, which atlas_vert.glsl subtracts from gl_Position.
+    static glm::vec2 jitterClipOffset(int pass, int atlasLength);
+    // Attribute planes of every triangle of mesh in the atlas of a jittered pass, in triangle order (indexed by
+    // gl_PrimitiveID), for the storage buffer of atlas_sample_frag.glsl.
+    static std::vector<AtlasAttributePlanes> attributePlanes(const Mesh& mesh, int atlasLength, int jitterPass);
+
+    int atlasLength() const { return m_atlasLength; }
+    // Row-major from the bottom row up, the layout glGetTexImage returns.
+    const std::vector<glm::vec3>& positions() const { return m_positions; }
+    const std::vector<glm::vec3>& normals() const { return m_normals; }
+    // Triangles left after dropping the ones without snapped area or outside the atlas.
+    size_t rasterizedTriangleCount() const { return m_triangles.size(); }
+
+    unsigned numThreads() const { return m_numThreads; }
+
+private:
+    // Per triangle state after setup, edge functions and attribute planes are in pixel coordinates.
+    struct Triangle {
+        int64_t edgeA[3]; // E(x, y) = A x + B y + C over subpixel coordinates, inside where E > 0
+        int64_t edgeB[3];
+        int64_t edgeC[3];
+        int64_t conservativeBias[3]; // added to E for conservative coverage, E alone decides whether the center is inside
+        int minX, minY, maxX, maxY; // texel bounds, inclusive
+        glm::vec2 window[3]; // unsnapped window positions, window[0] is the origin of the attribute planes
+        glm::vec3 attributes[2]; // position and normal at vertex 0
+        glm::vec3 dadx[2];
+        glm::vec3 dady[2];
+    };
+
+private:
+    void setupTriangles(const Mesh& mesh, const glm::vec2& clipOffset, bool conservative);
+    void binTriangles();
+    void rasterizeTile(int tileX, int tileY, bool conservative);
+
+private:
+    unsigned m_numThreads;
+    int m_atlasLength { 0 };
+    int m_tilesPerRow { 0 };
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_normals;
+    std::vector<Triangle> m_triangles;
+    // Triangle indices per (chunk of triangles, tile). Walking the chunks in order visits a tile's triangles in order.
+    std::vector<std::vector<std::vector<uint32_t>>> m_bins;
+};
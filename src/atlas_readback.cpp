@@ -0,0 +1,113 @@
+#include "atlas_readback.h"
+
+AtlasReadback::AtlasReadback(int numBuffers)
+    : m_slots(size_t(numBuffers))
+{
+    for (Slot& slot : m_slots)
+        glCreateBuffers(1, &slot.buffer);
+}
+
+AtlasReadback::~AtlasReadback()
+{
+    cancelAll();
+    for (Slot& slot : m_slots)
+        glDeleteBuffers(1, &slot.buffer);
+}
+
+bool AtlasReadback::request(GLuint texture, int atlasLength, GLenum format, GLenum type, size_t bytesPerTexel, int tag)
+{
+    const Attachment attachment { texture, format, type, bytesPerTexel };
+    return request(std::span(&attachment, 1), atlasLength, tag);
+}
+
+bool AtlasReadback::request(std::span<const Attachment> attachments, int atlasLength, int tag)
+{
+    if (!hasFreeBuffer())
+        return false;
+
+    Slot& slot = m_slots[(m_oldest + m_pending) % m_slots.size()];
+    slot.size = 0;
+    for (const Attachment& attachment : attachments)
+        slot.size += size_t(atlasLength) * size_t(atlasLength) * attachment.bytesPerTexel;
+    if (slot.size > slot.capacity) {
+        // GL_STREAM_READ: written once by the GPU, read once by the CPU
+        slot.capacity = slot.size;
+        glNamedBufferData(slot.buffer, GLsizeiptr(slot.capacity), nullptr, GL_STREAM_READ);
+    }
+
+    // With a pixel pack buffer bound the pixels pointer is an offset into that buffer and the call returns immediately.
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    size_t offset = 0;
+    for (const Attachment& attachment : attachments) {
+        const size_t size = size_t(atlasLength) * size_t(atlasLength) * attachment.bytesPerTexel;
+        glGetTextureImage(attachment.texture, 0, attachment.format, attachment.type, GLsizei(size), reinterpret_cast<void*>(offset));
+        offset += size;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Make sure the fence reaches the GPU, otherwise polling it with a zero timeout could never succeed.
+    glFlush();
+    slot.tag = tag;
+    slot.atlasLength = atlasLength;
+    slot.framesWaited = 0;
+    slot.requested = std::chrono::steady_clock::now();
+    ++m_pending;
+    return true;
+}
+
+bool AtlasReadback::poll(const std::function<void(const Result&)>& consume)
+{
+    if (m_pending == 0)
+        return false;
+
+    Slot& slot = m_slots[m_oldest];
+    const GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        ++slot.framesWaited;
+        return false;
+    }
+
+    const std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - slot.requested;
+    const void* mapped = status != GL_WAIT_FAILED ? glMapNamedBufferRange(slot.buffer, 0, GLsizeiptr(slot.size), GL_MAP_READ_BIT) : nullptr;
+    std::vector<std::byte> copy;
+    if (!mapped) {
+        // Reading the buffer waits for the copy into it to complete, so the request is still consumed, only later.
+        copy.resize(slot.size);
+        glGetNamedBufferSubData(slot.buffer, 0, GLsizeiptr(slot.size), copy.data());
+    }
+    const Result result {
+        .tag = slot.tag,
+        .atlasLength = slot.atlasLength,
+        .data = mapped ? std::span(static_cast<const std::byte*>(mapped), slot.size) : std::span<const std::byte>(copy),
+        .latencyMs = latency.count(),
+        .framesWaited = slot.framesWaited
+    };
+    consume(result);
+    if (mapped)
+        glUnmapNamedBuffer(slot.buffer);
+
+    release(slot);
+    m_oldest = (m_oldest + 1) % m_slots.size();
+    --m_pending;
+    return true;
+}
+
+void AtlasReadback::cancelAll()
+{
+    for (; m_pending > 0; --m_pending) {
+        release(m_slots[m_oldest]);
+        m_oldest = (m_oldest + 1) % m_slots.size();
+    }
+    m_oldest = 0;
+}
+
+void AtlasReadback::release(Slot& slot)
+{
+    if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+}
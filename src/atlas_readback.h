@@ -0,0 +1,73 @@
+#pragma once
+#include <framework/opengl_includes.h>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+
+// Asynchronous texture readback through a ring of pixel pack buffers.
+//
+// request() only queues the copy from the texture into a free pixel pack buffer and inserts a fence, so
+// the CPU does not wait for the GPU to finish rendering. poll() checks the fence of the oldest request
+// without blocking and hands its data to the caller once the copy has completed, which is typically
+// one or two frames later. Requests complete in the order they were made. If the fence cannot be waited on or
+// the buffer cannot be mapped, the data is read from the buffer with a blocking call instead, so every request
+// is consumed exactly once.
+//
+// A request can read several textures of the same size, such as the attachments of the atlas G-buffer, into
+// one buffer behind a single fence. Their data follows each other in the order they were given.
+class AtlasReadback {
+public:
+    struct Attachment {
+        GLuint texture;
+        GLenum format;
+        GLenum type;
+        size_t bytesPerTexel;
+    };
+
+    struct Result {
+        int tag; // value passed to request(), identifies what was read back
+        int atlasLength;
+        std::span<const std::byte> data; // tightly packed rows of every attachment, only valid during the callback
+        double latencyMs; // time between request() and the moment the data was found ready
+        int framesWaited; // number of poll() calls that found the request still in flight
+    };
+
+    explicit AtlasReadback(int numBuffers = 3);
+    AtlasReadback(const AtlasReadback&) = delete;
+    ~AtlasReadback();
+
+    AtlasReadback& operator=(const AtlasReadback&) = delete;
+
+    // Queues a readback of mip level 0 of a square texture. Returns false if all buffers are in flight.
+    bool request(GLuint texture, int atlasLength, GLenum format, GLenum type, size_t bytesPerTexel, int tag);
+    bool request(std::span<const Attachment> attachments, int atlasLength, int tag);
+    // Consumes the oldest request if its fence has been signaled (or waiting on it failed), returns true if consume
+    // was called.
+    bool poll(const std::function<void(const Result&)>& consume);
+    // Drops all requests in flight, for example after the atlas was resized.
+    void cancelAll();
+
+    bool hasFreeBuffer() const { return m_pending < m_slots.size(); }
+    size_t pendingCount() const { return m_pending; }
+
+private:
+    struct Slot {
+        GLuint buffer { 0 };
+        size_t capacity { 0 };
+        size_t size { 0 };
+        GLsync fence { nullptr };
+        int tag { 0 };
+        int atlasLength { 0 };
+        int framesWaited { 0 };
+        std::chrono::steady_clock::time_point requested;
+    };
+
+    void release(Slot& slot);
+
+private:
+    std::vector<Slot> m_slots;
+    size_t m_oldest { 0 }; // ring index of the oldest request in flight
+    size_t m_pending { 0 };
+};
@@ -0,0 +1,109 @@
+#include "atlas_resolution.h"
+#include "parallel.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/geometric.hpp>
+#include <glm/mat2x2.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Per chunk of triangles, merged after the parallel pass.
+struct ChunkResult {
+    std::vector<std::pair<float, double>> triangles; // (diagonal, world area)
+    size_t unmappedTriangles { 0 };
+    double unmappedArea { 0.0 };
+};
+}
+
+AtlasResolution::AtlasResolution(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+void AtlasResolution::analyze(std::span<const Mesh> meshes, const glm::mat4& modelMatrix)
+{
+    std::vector<std::pair<float, double>> triangles;
+    m_unmappedTriangles = 0;
+    m_unmappedArea = 0.0;
+    for (const Mesh& mesh : meshes) {
+        const size_t numTriangles = mesh.triangles.size();
+        const unsigned numChunks = unsigned(std::clamp<size_t>(numTriangles / 1024, 1, m_numThreads));
+        std::vector<ChunkResult> chunks(numChunks);
+        parallel::forEachChunk(numTriangles, numChunks, [&](unsigned chunk, size_t begin, size_t end) {
+            ChunkResult& result = chunks[chunk];
+            for (size_t i = begin; i < end; ++i) {
+                const Vertex& v0 = mesh.vertices[mesh.triangles[i][0]];
+                const Vertex& v1 = mesh.vertices[mesh.triangles[i][1]];
+                const Vertex& v2 = mesh.vertices[mesh.triangles[i][2]];
+                const glm::vec3 p0 = glm::vec3(modelMatrix * glm::vec4(v0.position, 1.0f));
+                const glm::vec3 e1 = glm::vec3(modelMatrix * glm::vec4(v1.position, 1.0f)) - p0;
+                const glm::vec3 e2 = glm::vec3(modelMatrix * glm::vec4(v2.position, 1.0f)) - p0;
+                const double area = 0.5 * double(glm::length(glm::cross(e1, e2)));
+                if (area == 0.0)
+                    continue;
+
+                // Jacobian J = [e1 e2] * inverse([t1 t2]), its columns are the world space steps of one UV unit.
+                const glm::mat2 uvEdges(v1.texCoord - v0.texCoord, v2.texCoord - v0.texCoord);
+                const float uvDeterminant = glm::determinant(uvEdges);
+                if (std::abs(uvDeterminant) <= 1e-12f) {
+                    ++result.unmappedTriangles;
+                    result.unmappedArea += area;
+                    continue;
+                }
+                const glm::mat2 toEdges = glm::inverse(uvEdges);
+                const glm::vec3 du = e1 * toEdges[0][0] + e2 * toEdges[0][1];
+                const glm::vec3 dv = e1 * toEdges[1][0] + e2 * toEdges[1][1];
+                const float diagonal = std::max(glm::length(du + dv), glm::length(du - dv));
+                result.triangles.emplace_back(diagonal, area);
+            }
+        });
+        for (const ChunkResult& chunk : chunks) {
+            triangles.insert(triangles.end(), chunk.triangles.begin(), chunk.triangles.end());
+            m_unmappedTriangles += chunk.unmappedTriangles;
+            m_unmappedArea += chunk.unmappedArea;
+        }
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    m_diagonals.resize(triangles.size());
+    m_areaPrefix.assign(triangles.size() + 1, 0.0);
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        m_diagonals[i] = triangles[i].first;
+        m_areaPrefix[i + 1] = m_areaPrefix[i] + triangles[i].second;
+    }
+    m_totalArea = m_areaPrefix.back() + m_unmappedArea;
+}
+
+double AtlasResolution::spacingMetFraction(int atlasLength, float voxelScale) const
+{
+    if (m_totalArea == 0.0)
+        return 1.0;
+    // The diagonal shrinks with 1 / atlasLength.
+    const float maxDiagonal = float(atlasLength) * voxelScale;
+    const size_t covered = size_t(std::upper_bound(m_diagonals.begin(), m_diagonals.end(), maxDiagonal) - m_diagonals.begin());
+    return m_areaPrefix[covered] / m_totalArea;
+}
+
+int AtlasResolution::requiredLength(float voxelScale) const
+{
+    if (m_diagonals.empty())
+        return 1;
+    int length = std::max(int(std::ceil(m_diagonals.back() / voxelScale)), 1);
+    // Same comparison as spacingMetFraction, so the required length meets the spacing on every mapped triangle.
+    while (float(length) * voxelScale < m_diagonals.back())
+        ++length;
+    return length;
+}
+
+int AtlasResolution::selectLength(std::span<const int> candidateLengths, float voxelScale) const
+{
+    const int required = requiredLength(voxelScale);
+    for (int length : candidateLengths) {
+        if (length >= required)
+            return length;
+    }
+    return candidateLengths.back();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <framework/mesh.h>
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/mat4x4.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Chooses the atlas length from the UV mapping instead of a guess.
+//
+// The atlas samples a triangle at the texel centers, a lattice with a spacing of 1 / atlasLength in UV space.
+// The UV to world Jacobian of the triangle maps it to a lattice on the surface whose texel cells are
+// parallelograms. If the longer diagonal of those cells is at most the voxel size, every disk on the surface
+// with a diameter of one voxel contains a texel center, so every voxel the surface passes through with such a
+// patch gets a texel. The world-to-UV area ratio alone would miss stretched mappings. Meeting the spacing does
+// not mean the atlas covers every voxel: voxels the surface only crosses with a smaller patch, at an edge or
+// corner, are not covered by any sampling rate. At the length selected for a 128^3 grid the bunny's atlas still
+// misses 8% of the voxels a dense 4096^2 atlas finds (benchmarkAtlasResolution).
+//
+// analyze() stores the diagonal of every triangle at atlas length 1, sorted, with prefix sums over the world
+// areas. Coverage and length queries for another voxel size are then a binary search, so the length can be chosen
+// again whenever the grid length changes.
+class AtlasResolution {
+public:
+    // numThreads = 0 uses all hardware threads.
+    explicit AtlasResolution(unsigned numThreads = 0);
+
+    // Measures the triangles of meshes transformed by modelMatrix. Triangles without area in world space are
+    // skipped, those without area in UV space cannot be sampled at any atlas length.
+    void analyze(std::span<const Mesh> meshes, const glm::mat4& modelMatrix);
+
+    // Fraction of the surface area whose texel diagonal at atlasLength is at most voxelScale. Not a voxel coverage,
+    // see above.
+    double spacingMetFraction(int atlasLength, float voxelScale) const;
+    // Smallest atlas length at which every mapped triangle meets voxelScale, rounded up.
+    int requiredLength(float voxelScale) const;
+    // Smallest of the ascending candidateLengths that reaches requiredLength, the largest one if none does.
+    int selectLength(std::span<const int> candidateLengths, float voxelScale) const;
+
+    size_t triangleCount() const { return m_diagonals.size() + m_unmappedTriangles; }
+    size_t unmappedTriangleCount() const { return m_unmappedTriangles; }
+    // Fraction of the surface area on triangles without UV area.
+    double unmappedAreaFraction() const { return m_totalArea > 0.0 ? m_unmappedArea / m_totalArea : 0.0; }
+    unsigned numThreads() const { return m_numThreads; }
+
+private:
+    unsigned m_numThreads;
+    std::vector<float> m_diagonals; // world space texel diagonal at atlas length 1 per mapped triangle, ascending
+    std::vector<double> m_areaPrefix; // world area of the triangles before each entry of m_diagonals, and the total
+    size_t m_unmappedTriangles { 0 };
+    double m_unmappedArea { 0.0 };
+    double m_totalArea { 0.0 };
+};
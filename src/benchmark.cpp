@@ -0,0 +1,757 @@
+// Headless micro-benchmarks for the CPU side of the voxelization pipeline.
+// Run from the build directory: ./voxel-gi-benchmark
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "atlas_rasterizer.h"
+#include "atlas_resolution.h"
+#include "greedy_mesher.h"
+#include "hashed_occupancy.h"
+#include "morton.h"
+#include "occupancy_pyramid.h"
+#include "solid_fill.h"
+#include "sparse_voxel_octree.h"
+#include "texel_compaction.h"
+#include "triangle_voxelizer.h"
+#include "uv_unwrapper.h"
+#include "voxel_instance.h"
+#include "voxel_grid.cpp"
+
+// Atlas side lengths offered by the application UI.
+static const std::vector<int> atlasSizes = { 22, 44, 88, 176, 368, 768, 1280 };
+
+// Times a callable and returns the elapsed time in milliseconds.
+template <typename F>
+static double timeMs(F&& f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Generates a texel cloud that looks like the output of the atlas pass: points on a closed surface
+// (a sphere of radius 0.8 inside the [-1, 1] world bounds), about 60% of the atlas texels being valid.
+static std::vector<glm::vec3> makeTexelCloud(int atlasLength)
+{
+    const size_t count = size_t(atlasLength) * size_t(atlasLength) * 6 / 10;
+    std::vector<glm::vec3> texels(count);
+    const float goldenAngle = 2.39996323f;
+    for (size_t i = 0; i < count; ++i) {
+        const float y = 1.0f - 2.0f * (float(i) + 0.5f) / float(count);
+        const float r = std::sqrt(1.0f - y * y);
+        const float phi = goldenAngle * float(i);
+        texels[i] = 0.8f * glm::vec3(r * std::cos(phi), y, r * std::sin(phi));
+    }
+    return texels;
+}
+
+// The original occupancy representation: a list of occupied cells searched linearly.
+static size_t binLinear(VoxelGrid& grid, const std::vector<glm::vec3>& texels)
+{
+    std::vector<glm::ivec3> occupiedPositions;
+    for (const glm::vec3& worldPos : texels) {
+        const glm::ivec3 gridPos = grid.worldToGridPosition(worldPos);
+        if (std::find(occupiedPositions.begin(), occupiedPositions.end(), gridPos) == occupiedPositions.end())
+            occupiedPositions.push_back(gridPos);
+    }
+    return occupiedPositions.size();
+}
+
+static size_t binDense(VoxelGrid& grid, const std::vector<glm::vec3>& texels)
+{
+    grid.clearGrid();
+    size_t added = 0;
+    for (const glm::vec3& worldPos : texels)
+        added += grid.markGridPositionOccupied(grid.worldToGridPosition(worldPos));
+    return added;
+}
+
+static void benchmarkOccupancy()
+{
+    std::printf("== Occupancy: linear vector vs dense bit volume ==\n");
+    std::printf("%8s %6s %10s %9s %14s %14s %12s\n", "atlas", "grid", "texels", "voxels", "vector [ms]", "bitfield [ms]", "iterate [ms]");
+    for (int gridLength : { 64, 128, 256 }) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+        for (int atlasLength : atlasSizes) {
+            const std::vector<glm::vec3> texels = makeTexelCloud(atlasLength);
+
+            size_t denseVoxels = 0;
+            const double denseMs = timeMs([&]() { denseVoxels = binDense(grid, texels); });
+
+            size_t iterated = 0;
+            const double iterateMs = timeMs([&]() { grid.occupancy.forEachOccupied([&](const glm::ivec3&) { ++iterated; }); });
+
+            // The linear scan is quadratic, skip configurations that would take minutes.
+            double linearMs = -1.0;
+            if (double(texels.size()) * double(denseVoxels) < 2e10) {
+                size_t linearVoxels = 0;
+                linearMs = timeMs([&]() { linearVoxels = binLinear(grid, texels); });
+                if (linearVoxels != denseVoxels || iterated != denseVoxels)
+                    std::printf("  mismatch: vector %zu, bitfield %zu, iterated %zu\n", linearVoxels, denseVoxels, iterated);
+            }
+
+            if (linearMs >= 0.0)
+                std::printf("%8d %6d %10zu %9zu %14.2f %14.2f %12.2f\n", atlasLength, gridLength, texels.size(), denseVoxels, linearMs, denseMs, iterateMs);
+            else
+                std::printf("%8d %6d %10zu %9zu %14s %14.2f %12.2f\n", atlasLength, gridLength, texels.size(), denseVoxels, "skipped", denseMs, iterateMs);
+        }
+    }
+}
+
+static void benchmarkOctree()
+{
+    std::printf("\n== Sparse voxel octree built from the 1280 atlas texel cloud ==\n");
+    std::printf("%6s %9s %7s %12s %12s %11s %13s %13s\n", "grid", "voxels", "nodes", "svo [KB]", "dense [KB]", "build [ms]", "points [ns]", "rays [us]");
+    const std::vector<glm::vec3> texels = makeTexelCloud(1280);
+    for (int gridLength : { 64, 128, 256, 512, 1024, 2048 }) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+        std::vector<glm::ivec3> positions(texels.size());
+        std::transform(texels.begin(), texels.end(), positions.begin(), [&](const glm::vec3& worldPos) { return grid.worldToGridPosition(worldPos); });
+
+        SparseVoxelOctree octree;
+        const double buildMs = timeMs([&]() { octree.build(positions, gridLength); });
+
+        // Point queries on the occupied positions and on their mirrored (mostly empty) counterparts.
+        size_t found = 0;
+        const double pointMs = timeMs([&]() {
+            for (const glm::ivec3& gridPos : positions)
+                found += size_t(octree.contains(gridPos)) + size_t(octree.contains(glm::ivec3(gridLength - 1) - glm::ivec3(gridPos.z, gridPos.x, gridPos.y)));
+        });
+        if (found < positions.size())
+            std::printf("  missing voxels: %zu of %zu found\n", found, positions.size());
+
+        // Rays from outside the sphere towards the center all have to hit the shell.
+        const int numRays = 10000;
+        size_t hits = 0;
+        const double rayMs = timeMs([&]() {
+            for (int i = 0; i < numRays; ++i) {
+                const glm::vec3 target = (texels[size_t(i) * (texels.size() / numRays)] + 1.0f) * 0.5f * float(gridLength);
+                const glm::vec3 origin = glm::vec3(-0.5f, 0.37f, 1.3f) * float(gridLength);
+                hits += octree.raycast(origin, target - origin).hit;
+            }
+        });
+        if (hits != size_t(numRays))
+            std::printf("  rays missed the shell: %zu of %d hit\n", hits, numRays);
+
+        const double denseKB = double(gridLength) * gridLength * gridLength / 8.0 / 1024.0;
+        std::printf("%6d %9zu %7zu %12.1f %12.1f %11.2f %13.1f %13.2f\n", gridLength, octree.voxelCount(), octree.nodeCount(), double(octree.memoryBytes()) / 1024.0, denseKB,
+            buildMs, pointMs * 1e6 / (2.0 * double(positions.size())), rayMs * 1e3 / numRays);
+    }
+}
+
+static void benchmarkMorton()
+{
+    std::printf("\n== Morton keys for the voxels of the 1280 atlas texel cloud ==\n");
+    const std::vector<glm::vec3> texels = makeTexelCloud(1280);
+    VoxelGrid grid;
+    grid.gridLength = 1024;
+    grid.calculateVoxelScale();
+    std::vector<glm::ivec3> positions(texels.size());
+    std::transform(texels.begin(), texels.end(), positions.begin(), [&](const glm::vec3& worldPos) { return grid.worldToGridPosition(worldPos); });
+    const double count = double(positions.size());
+
+    std::vector<uint32_t> keys10(positions.size());
+    std::vector<uint64_t> keys21(positions.size());
+    std::vector<glm::ivec3> decoded(positions.size());
+    const double encode10Ms = timeMs([&]() {
+        for (size_t i = 0; i < positions.size(); ++i)
+            keys10[i] = morton::encode10(positions[i]);
+    });
+    const double encode21Ms = timeMs([&]() {
+        for (size_t i = 0; i < positions.size(); ++i)
+            keys21[i] = morton::encode21(positions[i]);
+    });
+    const double decode10Ms = timeMs([&]() {
+        for (size_t i = 0; i < keys10.size(); ++i)
+            decoded[i] = morton::decode10(keys10[i]);
+    });
+    const bool roundTrip10 = std::equal(decoded.begin(), decoded.end(), positions.begin());
+    const double decode21Ms = timeMs([&]() {
+        for (size_t i = 0; i < keys21.size(); ++i)
+            decoded[i] = morton::decode21(keys21[i]);
+    });
+    const bool roundTrip21 = std::equal(decoded.begin(), decoded.end(), positions.begin());
+    if (!roundTrip10 || !roundTrip21)
+        std::printf("  decoded keys differ from the encoded positions\n");
+    std::printf("10-bit keys: encode %.2f ns/key, decode %.2f ns/key\n", encode10Ms * 1e6 / count, decode10Ms * 1e6 / count);
+    std::printf("21-bit keys: encode %.2f ns/key, decode %.2f ns/key\n", encode21Ms * 1e6 / count, decode21Ms * 1e6 / count);
+
+    std::vector<uint64_t> stdSorted = keys21;
+    const double stdSortMs = timeMs([&]() { std::sort(stdSorted.begin(), stdSorted.end()); });
+    std::vector<uint64_t> radixSorted = keys21;
+    const double radixSortMs = timeMs([&]() { morton::sortKeys(radixSorted, 30); });
+    if (stdSorted != radixSorted)
+        std::printf("  radix sort result differs from std::sort\n");
+    std::printf("sort %zu keys: std::sort %.2f ms, radix sort %.2f ms\n", keys21.size(), stdSortMs, radixSortMs);
+
+    // Neighbourhood queries: all voxels in a 9^3 box around a sample of voxels, on the sorted keys.
+    size_t intervalHits = 0, bruteHits = 0;
+    const double intervalMs = timeMs([&]() {
+        for (size_t i = 0; i < positions.size(); i += 1000)
+            morton::forEachInBox(radixSorted, glm::max(positions[i] - 4, 0), positions[i] + 4, [&](size_t) { ++intervalHits; });
+    });
+    for (size_t i = 0; i < positions.size(); i += 1000) {
+        const glm::ivec3 boxMin = glm::max(positions[i] - 4, 0), boxMax = positions[i] + 4;
+        bruteHits += size_t(std::count_if(radixSorted.begin(), radixSorted.end(), [&](uint64_t key) { return morton::insideBox(key, boxMin, boxMax); }));
+    }
+    if (intervalHits != bruteHits)
+        std::printf("  box iteration found %zu keys, brute force %zu\n", intervalHits, bruteHits);
+    std::printf("9^3 box queries over Morton intervals: %.2f us/query\n", intervalMs * 1e3 / double((positions.size() + 999) / 1000));
+}
+
+// Bins a texel cloud into any occupancy container with the test/set/count/forEachOccupied interface.
+template <typename Occupancy>
+static void benchmarkContainer(const char* name, Occupancy& occupancy, const std::vector<glm::ivec3>& positions)
+{
+    size_t added = 0;
+    const double insertMs = timeMs([&]() {
+        for (const glm::ivec3& gridPos : positions)
+            added += occupancy.set(gridPos);
+    });
+    size_t found = 0;
+    const double testMs = timeMs([&]() {
+        for (const glm::ivec3& gridPos : positions)
+            found += occupancy.test(gridPos);
+    });
+    size_t iterated = 0;
+    const double iterateMs = timeMs([&]() { occupancy.forEachOccupied([&](const glm::ivec3&) { ++iterated; }); });
+    if (found != positions.size() || iterated != added || occupancy.count() != added)
+        std::printf("  %s is inconsistent: %zu added, %zu found, %zu iterated\n", name, added, found, iterated);
+    std::printf("%10s %9zu %11.1f %11.2f %9.2f %12.2f\n", name, added, double(occupancy.memoryBytes()) / 1024.0, insertMs, testMs, iterateMs);
+}
+
+static void benchmarkHashedGrid()
+{
+    std::printf("\n== Dense vs hashed occupancy, 1280 atlas texel cloud ==\n");
+    const std::vector<glm::vec3> texels = makeTexelCloud(1280);
+    for (int gridLength : { 128, 256, 512 }) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+        std::vector<glm::ivec3> positions(texels.size());
+        std::transform(texels.begin(), texels.end(), positions.begin(), [&](const glm::vec3& worldPos) { return grid.worldToGridPosition(worldPos); });
+        std::printf("grid %d^3\n%10s %9s %11s %11s %9s %12s\n", gridLength, "container", "voxels", "memory [KB]", "insert [ms]", "test [ms]", "iterate [ms]");
+        OccupancyVolume dense(gridLength);
+        benchmarkContainer("dense", dense, positions);
+        HashedOccupancy hashed;
+        benchmarkContainer("hashed", hashed, positions);
+    }
+
+    // The same surface scaled far beyond the world bounds only costs the bricks it touches.
+    VoxelGrid grid;
+    grid.gridLength = 256;
+    grid.calculateVoxelScale();
+    grid.unbounded = true;
+    std::vector<glm::ivec3> positions(texels.size());
+    std::transform(texels.begin(), texels.end(), positions.begin(), [&](const glm::vec3& worldPos) { return grid.worldToGridPosition(worldPos * 8.0f + 5.0f); });
+    std::printf("unbounded, surface spanning 16x the world bounds\n");
+    HashedOccupancy hashed;
+    benchmarkContainer("hashed", hashed, positions);
+}
+
+// Atlas readback as the application sees it: atlasLength^2 packed RGB texels, the ones not covered by the mesh
+// set to the clear value. Coverage comes in runs like the charts of a real atlas.
+static std::vector<glm::vec3> makeAtlasTexels(int atlasLength, float invalidValue)
+{
+    std::vector<glm::vec3> texels(size_t(atlasLength) * size_t(atlasLength), glm::vec3(invalidValue));
+    const std::vector<glm::vec3> cloud = makeTexelCloud(atlasLength);
+    size_t next = 0;
+    for (size_t i = 0; i < texels.size() && next < cloud.size(); ++i) {
+        if ((i / 7) % 5 != 0 && (i * 2654435761u) % 16 != 0)
+            texels[i] = cloud[next++];
+    }
+    return texels;
+}
+
+static void benchmarkCompaction()
+{
+    const float invalidValue = 0.4f;
+    std::printf("\n== Valid texel compaction ==\n");
+    std::printf("%8s %10s %10s %12s %12s %12s %9s\n", "atlas", "texels", "valid", "scalar [ms]", "simd 1t [ms]", "simd nt [ms]", "threads");
+    std::vector<int> sizes = atlasSizes;
+    sizes.insert(sizes.end(), { 2048, 4096 });
+    for (int atlasLength : sizes) {
+        const std::vector<glm::vec3> texels = makeAtlasTexels(atlasLength, invalidValue);
+
+        // The original loop in Application::renderTexelCloud
+        std::vector<glm::vec3> scalar;
+        const double scalarMs = timeMs([&]() {
+            for (const glm::vec3& objectPos : texels) {
+                if (objectPos != glm::vec3(invalidValue))
+                    scalar.push_back(objectPos);
+            }
+        });
+
+        TexelCompactor singleThreaded(1);
+        std::vector<glm::vec3> single;
+        singleThreaded.compact(texels, invalidValue, single); // warm up the output and mask buffers
+        const double singleMs = timeMs([&]() { singleThreaded.compact(texels, invalidValue, single); });
+
+        TexelCompactor multiThreaded;
+        std::vector<glm::vec3> multi;
+        multiThreaded.compact(texels, invalidValue, multi);
+        const double multiMs = timeMs([&]() { multiThreaded.compact(texels, invalidValue, multi); });
+
+        if (single != scalar || multi != scalar)
+            std::printf("  compaction result differs from the scalar loop\n");
+        std::printf("%8d %10zu %10zu %12.3f %12.3f %12.3f %9u\n", atlasLength, texels.size(), scalar.size(), scalarMs, singleMs, multiMs, multiThreaded.numThreads());
+    }
+}
+
+static void benchmarkMeshing()
+{
+    std::printf("\n== Instanced cubes vs greedy surface mesh ==\n");
+    std::printf("%6s %8s %9s %14s %14s %14s %10s\n", "grid", "shape", "voxels", "cube tris", "visible tris", "greedy tris", "mesh [ms]");
+    for (int gridLength : { 64, 128, 256 }) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+        binDense(grid, makeTexelCloud(1280));
+        OccupancyVolume shell = grid.occupancy;
+
+        // A solid ball, what a filled voxelization of a closed mesh looks like.
+        OccupancyVolume solid(gridLength);
+        const glm::vec3 center(0.5f * float(gridLength));
+        for (int z = 0; z < gridLength; ++z)
+            for (int y = 0; y < gridLength; ++y)
+                for (int x = 0; x < gridLength; ++x)
+                    if (glm::distance(glm::vec3(x, y, z) + 0.5f, center) < 0.4f * float(gridLength))
+                        solid.set(glm::ivec3(x, y, z));
+
+        for (const auto& [name, occupancy] : { std::pair { "shell", &shell }, std::pair { "solid", &solid } }) {
+            GreedyMesher mesher;
+            const double meshMs = timeMs([&]() { mesher.build(*occupancy); });
+            const size_t voxels = occupancy->count();
+            std::printf("%6d %8s %9zu %14zu %14zu %14zu %10.2f\n", gridLength, name, voxels, voxels * 12, mesher.visibleFaceCount() * 2, mesher.quadCount() * 2, meshMs);
+        }
+    }
+}
+
+// A closed sphere of radius 0.8, unwrapped over the whole atlas.
+static Mesh makeUvSphere()
+{
+    Mesh sphere;
+    const int rings = 96, segments = 192;
+    for (int ring = 0; ring <= rings; ++ring) {
+        for (int segment = 0; segment <= segments; ++segment) {
+            const glm::vec2 texCoord(float(segment) / segments, float(ring) / rings);
+            const float theta = texCoord.y * glm::pi<float>(), phi = texCoord.x * glm::two_pi<float>();
+            const glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            sphere.vertices.push_back({ 0.8f * normal, normal, texCoord });
+        }
+    }
+    for (int ring = 0; ring < rings; ++ring) {
+        for (int segment = 0; segment < segments; ++segment) {
+            const uint32_t first = uint32_t(ring * (segments + 1) + segment), below = first + segments + 1;
+            sphere.triangles.push_back({ first, below, first + 1 });
+            sphere.triangles.push_back({ first + 1, below, below + 1 });
+        }
+    }
+    return sphere;
+}
+
+// The demo's mesh when run from the build directory, otherwise the UV sphere.
+static Mesh loadAtlasMesh()
+{
+    if (std::filesystem::exists("resources/bunny.obj"))
+        return mergeMeshes(loadMesh("resources/bunny.obj"));
+    return makeUvSphere();
+}
+
+static void benchmarkAtlasRasterizer()
+{
+    const float invalidValue = 0.4f;
+    const Mesh mesh = loadAtlasMesh();
+    std::vector<unsigned> threadCounts;
+    for (unsigned numThreads = 1; numThreads < std::thread::hardware_concurrency(); numThreads *= 2)
+        threadCounts.push_back(numThreads);
+    threadCounts.push_back(std::max(std::thread::hardware_concurrency(), 1u));
+
+    std::printf("\n== CPU atlas rasterizer, %zu triangles ==\n", mesh.triangles.size());
+    std::printf("%8s %10s", "atlas", "covered");
+    for (unsigned numThreads : threadCounts)
+        std::printf(" %8u t [ms]", numThreads);
+    std::printf("\n");
+    for (int atlasLength : atlasSizes) {
+        std::printf("%8d", atlasLength);
+        for (size_t i = 0; i < threadCounts.size(); ++i) {
+            AtlasRasterizer rasterizer(threadCounts[i]);
+            rasterizer.rasterize(mesh, atlasLength, invalidValue); // warm up the atlas and bin buffers
+            const double ms = timeMs([&]() { rasterizer.rasterize(mesh, atlasLength, invalidValue); });
+            if (i == 0) {
+                const size_t covered = size_t(std::count_if(rasterizer.positions().begin(), rasterizer.positions().end(),
+                    [&](const glm::vec3& texel) { return texel != glm::vec3(invalidValue); }));
+                std::printf(" %10zu", covered);
+            }
+            std::printf(" %13.3f", ms);
+        }
+        std::printf("\n");
+    }
+}
+
+// The atlas engine against the triangle (SAT) engine on the same mesh, identity model matrix.
+static void benchmarkVoxelizationEngines()
+{
+    const float invalidValue = 0.4f;
+    const Mesh mesh = loadAtlasMesh();
+    AtlasRasterizer rasterizer;
+    TexelCompactor compactor;
+    TriangleVoxelizer triangleVoxelizer;
+
+    std::printf("\n== Voxelization engines: atlas vs triangle/box SAT, %zu triangles ==\n", mesh.triangles.size());
+    std::printf("%6s %8s %12s %12s %12s %12s %11s %11s\n", "grid", "atlas", "atlas voxels", "SAT voxels", "atlas holes", "atlas only", "atlas [ms]", "SAT [ms]");
+    for (int gridLength : { 64, 128, 256, 512 }) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+        grid.clearGrid();
+        OccupancyVolume triangles(gridLength);
+        triangleVoxelizer.voxelize(mesh, glm::mat4(1.0f), grid.worldMin, grid.worldMax, triangles); // warm up the bins
+        triangles.clear();
+        const double triangleMs = timeMs([&]() { triangleVoxelizer.voxelize(mesh, glm::mat4(1.0f), grid.worldMin, grid.worldMax, triangles); });
+
+        for (int atlasLength : { 176, 768, 1280 }) {
+            grid.clearGrid();
+            std::vector<glm::vec3> texels;
+            const double atlasMs = timeMs([&]() {
+                rasterizer.rasterize(mesh, atlasLength, invalidValue);
+                compactor.compact(rasterizer.positions(), invalidValue, texels);
+                for (const glm::vec3& objectPos : texels)
+                    grid.markGridPositionOccupied(grid.worldToGridPosition(objectPos));
+            });
+
+            // Voxels that only one engine found.
+            OccupancyVolume holes = triangles;
+            size_t atlasOnly = 0;
+            grid.occupancy.forEachOccupied([&](const glm::ivec3& gridPos) {
+                if (!holes.test(gridPos))
+                    ++atlasOnly;
+                holes.reset(gridPos);
+            });
+            std::printf("%6d %8d %12zu %12zu %12zu %12zu %11.2f %11.2f\n", gridLength, atlasLength, grid.occupancy.count(), triangles.count(),
+                holes.count(), atlasOnly, atlasMs, triangleMs);
+        }
+    }
+}
+
+static void benchmarkSolidFill()
+{
+    const Mesh sphere = makeUvSphere();
+    TriangleVoxelizer triangleVoxelizer;
+    SolidFiller singleThreaded(1), multiThreaded;
+    std::printf("\n== Solid fill of a voxelized closed sphere ==\n");
+    std::printf("%6s %12s %12s %8s %12s %12s %9s\n", "grid", "shell", "interior", "rounds", "1 t [ms]", "nt [ms]", "threads");
+    for (int gridLength : { 64, 128, 256, 512 }) {
+        OccupancyVolume shell(gridLength);
+        triangleVoxelizer.voxelize(sphere, glm::mat4(1.0f), glm::vec3(-1.0f), glm::vec3(1.0f), shell);
+
+        OccupancyVolume single = shell;
+        size_t interior = 0;
+        const double singleMs = timeMs([&]() { interior = singleThreaded.fill(single); });
+        OccupancyVolume multi = shell;
+        const double multiMs = timeMs([&]() { multiThreaded.fill(multi); });
+        if (multi.countDifferences(single) != 0)
+            std::printf("  solid fill result depends on the thread count\n");
+        std::printf("%6d %12zu %12zu %8d %12.2f %12.2f %9u\n", gridLength, shell.count(), interior, multiThreaded.rounds(), singleMs, multiMs, multiThreaded.numThreads());
+    }
+}
+
+// Coarser grid lengths from the pyramid against binning the same texels again per grid length.
+static void benchmarkOccupancyPyramid()
+{
+    const std::vector<glm::vec3> texels = makeTexelCloud(1280);
+    OccupancyPyramid singleThreaded(1), multiThreaded;
+    std::printf("\n== Occupancy pyramid (%zu texels) ==\n", texels.size());
+    std::printf("%6s %8s %12s %12s %12s %9s %12s\n", "grid", "levels", "1 t [ms]", "nt [ms]", "rebin [ms]", "threads", "differ");
+    for (int gridLength : { 128, 256, 512 }) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.clearGrid();
+        binDense(grid, texels);
+
+        const double singleMs = timeMs([&]() { singleThreaded.build(grid.occupancy); });
+        const double multiMs = timeMs([&]() { multiThreaded.build(grid.occupancy); });
+        // Every coarser level binned from the texels, as "/2" did before the pyramid.
+        double rebinMs = 0.0;
+        size_t differences = 0;
+        for (int level = 1; level < multiThreaded.numLevels(); ++level) {
+            VoxelGrid coarse;
+            coarse.gridLength = multiThreaded.level(level).gridLength();
+            coarse.clearGrid();
+            rebinMs += timeMs([&]() { binDense(coarse, texels); });
+            differences += coarse.occupancy.countDifferences(multiThreaded.level(level));
+        }
+        std::printf("%6d %8d %12.2f %12.2f %12.2f %9u %12zu\n", gridLength, multiThreaded.numLevels(), singleMs, multiMs, rebinMs, multiThreaded.numThreads(), differences);
+    }
+}
+
+// Readback size, compaction and binning per atlas encoding: RGB32F positions, RGB16F positions and grid positions
+// packed into R32UI by the atlas shader. Positions are only quantized to half floats, so RGB16F may move voxels
+// on cell borders; the packed atlas holds exactly the voxels of the RGB32F one.
+static void benchmarkAtlasEncodings()
+{
+    const int gridLength = 256;
+    const float invalidValue = 0.4f;
+    const float invalidHalf = glm::unpackHalf1x16(glm::packHalf1x16(invalidValue));
+    TexelCompactor compactor;
+    std::printf("\n== Atlas encodings, %d^3 grid ==\n", gridLength);
+    std::printf("%8s %10s %10s %12s %12s %12s %10s\n", "atlas", "encoding", "MB", "compact [ms]", "bin [ms]", "voxels", "differ");
+    for (int atlasLength : { 368, 768, 1280, 2048 }) {
+        const std::vector<glm::vec3> texels = makeAtlasTexels(atlasLength, invalidValue);
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+
+        // What the three atlas formats hold after rendering the same texels.
+        std::vector<uint16_t> halves(3 * texels.size());
+        std::vector<uint32_t> packed(texels.size(), 0);
+        for (size_t i = 0; i < texels.size(); ++i) {
+            const bool valid = texels[i] != glm::vec3(invalidValue);
+            for (int k = 0; k < 3; ++k)
+                halves[3 * i + size_t(k)] = glm::packHalf1x16(valid ? texels[i][k] : invalidHalf);
+            if (valid)
+                packed[i] = voxel_instance::pack(grid.worldToGridPosition(texels[i])) | TexelCompactor::packedValidBit;
+        }
+
+        OccupancyVolume reference;
+        const auto report = [&](const char* name, size_t bytes, double compactMs, double binMs) {
+            if (reference.gridLength() == 0)
+                reference = grid.occupancy;
+            std::printf("%8d %10s %10.2f %12.3f %12.3f %12zu %10zu\n", atlasLength, name, double(bytes) / (1 << 20), compactMs, binMs,
+                grid.occupancy.count(), grid.occupancy.countDifferences(reference));
+        };
+
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> gridPositions;
+        grid.clearGrid();
+        compactor.compact(texels, invalidValue, positions); // warm up the output and mask buffers
+        double compactMs = timeMs([&]() { compactor.compact(texels, invalidValue, positions); });
+        double binMs = timeMs([&]() { binDense(grid, positions); });
+        report("RGB32F", texels.size() * sizeof(glm::vec3), compactMs, binMs);
+
+        grid.clearGrid();
+        compactMs = timeMs([&]() { compactor.compactHalf(halves, invalidHalf, positions); });
+        binMs = timeMs([&]() { binDense(grid, positions); });
+        report("RGB16F", halves.size() * sizeof(uint16_t), compactMs, binMs);
+
+        grid.clearGrid();
+        compactMs = timeMs([&]() { compactor.compactPacked(packed, gridPositions); });
+        binMs = timeMs([&]() {
+            for (uint32_t gridPos : gridPositions)
+                grid.markGridPositionOccupied(voxel_instance::unpack(gridPos));
+        });
+        report("R32UI", packed.size() * sizeof(uint32_t), compactMs, binMs);
+    }
+}
+
+// The atlas length AtlasResolution selects per grid length, checked against the voxels of a dense atlas (4096^2)
+// and of the triangle engine. "spacing" is the fraction of the surface whose texels are at most a voxel apart. Both
+// atlases miss voxels the surface only grazes, which the triangle engine finds, even where the spacing is met.
+// Measured at the selected length and at the next smaller UI length, all atlases rasterized on the CPU.
+static void benchmarkAtlasResolution()
+{
+    const float invalidValue = 0.4f;
+    const int denseLength = 4096;
+    const Mesh mesh = loadAtlasMesh();
+    AtlasResolution resolution;
+    const double analyzeMs = timeMs([&]() { resolution.analyze(std::span(&mesh, 1), glm::mat4(1.0f)); });
+    AtlasRasterizer rasterizer;
+    TexelCompactor compactor;
+    TriangleVoxelizer triangleVoxelizer;
+
+    const auto rasterizeTexels = [&](int atlasLength) {
+        std::vector<glm::vec3> texels;
+        rasterizer.rasterize(mesh, atlasLength, invalidValue);
+        compactor.compact(rasterizer.positions(), invalidValue, texels);
+        return texels;
+    };
+    const auto binTexels = [](const std::vector<glm::vec3>& texels, int gridLength) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+        binDense(grid, texels);
+        return grid.occupancy;
+    };
+    // Voxels of reference the atlas of the given length misses.
+    const auto missedVoxels = [&](int atlasLength, const OccupancyVolume& reference) {
+        OccupancyVolume missed = reference;
+        binTexels(rasterizeTexels(atlasLength), reference.gridLength()).forEachOccupied([&](const glm::ivec3& gridPos) { missed.reset(gridPos); });
+        return missed.count();
+    };
+    const std::vector<glm::vec3> denseTexels = rasterizeTexels(denseLength);
+
+    std::printf("\n== Atlas length selection, %zu triangles analyzed in %.2f ms ==\n", resolution.triangleCount(), analyzeMs);
+    std::printf("%6s %9s %9s %10s %10s %10s %10s %10s %9s %10s %10s\n", "grid", "required", "selected", "spacing", "dense", "missed",
+        "SAT", "missed", "smaller", "spacing", "missed");
+    for (int gridLength : { 32, 64, 128, 256, 512 }) {
+        const float voxelScale = 2.0f / float(gridLength);
+        const int selected = resolution.selectLength(atlasSizes, voxelScale);
+        const auto it = std::find(atlasSizes.begin(), atlasSizes.end(), selected);
+        const int smaller = it == atlasSizes.begin() ? selected : *(it - 1);
+
+        const OccupancyVolume dense = binTexels(denseTexels, gridLength);
+        OccupancyVolume triangles(gridLength);
+        triangleVoxelizer.voxelize(mesh, glm::mat4(1.0f), glm::vec3(-1.0f), glm::vec3(1.0f), triangles);
+        std::printf("%6d %9d %9d %9.2f%% %10zu %10zu %10zu %10zu %9d %9.2f%% %10zu\n", gridLength, resolution.requiredLength(voxelScale), selected,
+            100.0 * resolution.spacingMetFraction(selected, voxelScale), dense.count(), missedVoxels(selected, dense), triangles.count(),
+            missedVoxels(selected, triangles), smaller, 100.0 * resolution.spacingMetFraction(smaller, voxelScale), missedVoxels(smaller, dense));
+    }
+}
+
+// Coverage against time of the atlas sampling modes per atlas length: texel centers, jittered passes whose texels
+// are all kept, and conservative rasterization. Missed voxels are counted against the triangle engine, which finds
+// every voxel the surface touches. Time includes rasterization, compaction and binning of all passes on the CPU.
+// Conservative atlases keep every center sample, so their voxels are checked to be a superset of the voxels of the
+// same passes sampled at the centers.
+static void benchmarkAtlasCoverage()
+{
+    const float invalidValue = 0.4f;
+    const Mesh mesh = loadAtlasMesh();
+    AtlasRasterizer rasterizer;
+    TexelCompactor compactor;
+    TriangleVoxelizer triangleVoxelizer;
+    struct Mode {
+        const char* name;
+        int passes;
+        bool conservative;
+    };
+    const Mode modes[] = { { "centers", 1, false }, { "jitter x4", 4, false }, { "jitter x16", 16, false }, { "conservative", 1, true },
+        { "cons. jitter x4", 4, true } };
+
+    std::printf("\n== Atlas coverage vs time, %zu triangles ==\n", mesh.triangles.size());
+    std::printf("%6s %8s %16s %10s %10s %10s %10s\n", "grid", "atlas", "sampling", "texels", "missed", "coverage", "time [ms]");
+    for (int gridLength : { 128, 256 }) {
+        VoxelGrid grid;
+        grid.gridLength = gridLength;
+        grid.calculateVoxelScale();
+        OccupancyVolume triangles(gridLength);
+        triangleVoxelizer.voxelize(mesh, glm::mat4(1.0f), grid.worldMin, grid.worldMax, triangles);
+
+        for (int atlasLength : { 88, 176, 368, 768 }) {
+            std::vector<std::pair<int, OccupancyVolume>> centerVoxels; // per number of passes, modes list them first
+            for (const Mode& mode : modes) {
+                std::vector<glm::vec3> texels, passTexels;
+                rasterizer.rasterize(mesh, atlasLength, invalidValue); // warm up the atlas and bin buffers
+                const double ms = timeMs([&]() {
+                    texels.clear();
+                    for (int pass = 0; pass < mode.passes; ++pass) {
+                        rasterizer.rasterize(mesh, atlasLength, invalidValue, AtlasSampling { pass, mode.conservative });
+                        compactor.compact(rasterizer.positions(), invalidValue, passTexels);
+                        texels.insert(texels.end(), passTexels.begin(), passTexels.end());
+                    }
+                    binDense(grid, texels);
+                });
+                OccupancyVolume missed = triangles;
+                grid.occupancy.forEachOccupied([&](const glm::ivec3& gridPos) { missed.reset(gridPos); });
+                std::printf("%6d %8d %16s %10zu %10zu %9.2f%% %10.2f\n", gridLength, atlasLength, mode.name, texels.size(), missed.count(),
+                    100.0 * double(triangles.count() - missed.count()) / double(triangles.count()), ms);
+                if (!mode.conservative) {
+                    centerVoxels.emplace_back(mode.passes, grid.occupancy);
+                    continue;
+                }
+                for (const auto& [passes, voxels] : centerVoxels) {
+                    if (passes != mode.passes)
+                        continue;
+                    size_t lost = 0;
+                    voxels.forEachOccupied([&](const glm::ivec3& gridPos) { lost += size_t(!grid.occupancy.test(gridPos)); });
+                    if (lost > 0)
+                        std::printf("  conservative sampling lost %zu voxels of the center samples\n", lost);
+                }
+            }
+        }
+    }
+}
+
+// Generated charts against no UVs and the mesh's own UV layout: utilization of the UV square, the atlas length AtlasResolution
+// requires, and the voxels the atlas misses against the triangle engine, all atlases rasterized on the CPU.
+static void benchmarkUvUnwrapper()
+{
+    const float invalidValue = 0.4f;
+    const Mesh original = loadAtlasMesh();
+    // What loadMesh produces for a file without texture coordinates
+    Mesh stripped = original;
+    for (Vertex& vertex : stripped.vertices)
+        vertex.texCoord = glm::vec2(0.0f);
+    // The charts are padded in texels of the atlas, one layout per atlas length.
+    const std::array<int, 3> atlasLengths { 176, 368, 768 };
+    std::vector<Mesh> unwrapped(atlasLengths.size(), stripped);
+    UvUnwrapper unwrapper;
+    double unwrapMs = 0.0;
+    for (size_t i = 0; i < atlasLengths.size(); ++i)
+        unwrapMs += timeMs([&]() { unwrapper.unwrap(unwrapped[i], atlasLengths[i]); });
+    AtlasRasterizer rasterizer;
+    TexelCompactor compactor;
+    TriangleVoxelizer triangleVoxelizer;
+    const auto uvUtilization = [](const Mesh& mesh) {
+        double area = 0.0;
+        for (const glm::uvec3& triangle : mesh.triangles) {
+            const glm::vec2 a = mesh.vertices[triangle[1]].texCoord - mesh.vertices[triangle[0]].texCoord;
+            const glm::vec2 b = mesh.vertices[triangle[2]].texCoord - mesh.vertices[triangle[0]].texCoord;
+            area += 0.5 * std::abs(double(a.x * b.y - a.y * b.x));
+        }
+        return area;
+    };
+
+    std::printf("\n== UV unwrapper, %zu triangles: %zu charts in %.2f ms per atlas length, %zu -> %zu vertices ==\n", original.triangles.size(),
+        unwrapper.chartCount(), unwrapMs / double(atlasLengths.size()), original.vertices.size(), unwrapped.back().vertices.size());
+    std::printf("%10s %12s %12s %6s %10s %8s %10s %10s\n", "layout", "utilization", "needs unwrap", "grid", "required", "atlas", "missed",
+        "coverage");
+    const std::array<const char*, 3> layoutNames { "none", "original", "charts" };
+    for (size_t layout = 0; layout < layoutNames.size(); ++layout) {
+        for (int gridLength : { 128, 256 }) {
+            VoxelGrid grid;
+            grid.gridLength = gridLength;
+            grid.calculateVoxelScale();
+            OccupancyVolume triangles(gridLength);
+            triangleVoxelizer.voxelize(original, glm::mat4(1.0f), grid.worldMin, grid.worldMax, triangles);
+            for (size_t i = 0; i < atlasLengths.size(); ++i) {
+                const Mesh& mesh = layout == 0 ? stripped : layout == 1 ? original : unwrapped[i];
+                AtlasResolution resolution;
+                resolution.analyze(std::span(&mesh, 1), glm::mat4(1.0f));
+                std::vector<glm::vec3> texels;
+                rasterizer.rasterize(mesh, atlasLengths[i], invalidValue);
+                compactor.compact(rasterizer.positions(), invalidValue, texels);
+                binDense(grid, texels);
+                OccupancyVolume missed = triangles;
+                grid.occupancy.forEachOccupied([&](const glm::ivec3& gridPos) { missed.reset(gridPos); });
+                std::printf("%10s %11.2f%% %12s %6d %10d %8d %10zu %9.2f%%\n", layoutNames[layout], 100.0 * uvUtilization(mesh),
+                    UvUnwrapper::needsUnwrap(mesh) ? "yes" : "no", gridLength, resolution.requiredLength(grid.voxelScale), atlasLengths[i],
+                    missed.count(), 100.0 * double(triangles.count() - missed.count()) / double(triangles.count()));
+            }
+        }
+    }
+}
+
+int main()
+{
+    benchmarkOccupancy();
+    benchmarkOctree();
+    benchmarkMorton();
+    benchmarkHashedGrid();
+    benchmarkCompaction();
+    benchmarkMeshing();
+    benchmarkAtlasRasterizer();
+    benchmarkVoxelizationEngines();
+    benchmarkSolidFill();
+    benchmarkOccupancyPyramid();
+    benchmarkAtlasEncodings();
+    benchmarkAtlasResolution();
+    benchmarkAtlasCoverage();
+    benchmarkUvUnwrapper();
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "bilateral_upsampler.h"
+#include "gl_compute.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/gtc/type_ptr.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+
+BilateralUpsampler::BilateralUpsampler()
+{
+    m_downsampleShader = gl_compute::buildShader("shaders/gbuffer_downsample_comp.glsl");
+    m_upsampleShader = gl_compute::buildShader("shaders/bilateral_upsample_comp.glsl");
+}
+
+BilateralUpsampler::~BilateralUpsampler()
+{
+    glDeleteTextures(GLsizei(m_outputTextures.size()), m_outputTextures.data());
+}
+
+void BilateralUpsampler::downsample(const GBuffer& gBuffer, int factor, const glm::vec3& cameraPos)
+{
+    m_factor = std::max(factor, 1);
+    m_cameraPos = cameraPos;
+    const int width = int(gl_compute::divideRoundUp(size_t(gBuffer.width()), size_t(m_factor)));
+    const int height = int(gl_compute::divideRoundUp(size_t(gBuffer.height()), size_t(m_factor)));
+    m_lowResGBuffer.resize(width, height);
+
+    m_downsampleShader.bind();
+    glUniform1i(0, m_factor);
+    glUniform3fv(1, 1, glm::value_ptr(cameraPos));
+    glBindTextureUnit(0, gBuffer.positionTexture());
+    glBindTextureUnit(1, gBuffer.normalTexture());
+    glBindImageTexture(0, m_lowResGBuffer.positionTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    glBindImageTexture(1, m_lowResGBuffer.normalTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute(gl_compute::divideRoundUp(size_t(width), 8), gl_compute::divideRoundUp(size_t(height), 8), 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+GLuint BilateralUpsampler::upsample(const GBuffer& gBuffer, GLuint lowResTexture, size_t output)
+{
+    resizeOutputs(gBuffer.width(), gBuffer.height());
+
+    m_upsampleShader.bind();
+    glUniform1i(0, m_factor);
+    glUniform3fv(1, 1, glm::value_ptr(m_cameraPos));
+    glBindTextureUnit(0, gBuffer.positionTexture());
+    glBindTextureUnit(1, gBuffer.normalTexture());
+    glBindTextureUnit(2, m_lowResGBuffer.positionTexture());
+    glBindTextureUnit(3, m_lowResGBuffer.normalTexture());
+    glBindTextureUnit(4, lowResTexture);
+    glBindImageTexture(0, m_outputTextures[output], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute(gl_compute::divideRoundUp(size_t(m_outputWidth), 8), gl_compute::divideRoundUp(size_t(m_outputHeight), 8), 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    return m_outputTextures[output];
+}
+
+void BilateralUpsampler::resizeOutputs(int width, int height)
+{
+    if (width == m_outputWidth && height == m_outputHeight)
+        return;
+    glDeleteTextures(GLsizei(m_outputTextures.size()), m_outputTextures.data());
+    m_outputWidth = width;
+    m_outputHeight = height;
+    glCreateTextures(GL_TEXTURE_2D, GLsizei(m_outputTextures.size()), m_outputTextures.data());
+    for (GLuint texture : m_outputTextures) {
+        glTextureStorage2D(texture, 1, GL_RGBA16F, width, height);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+}
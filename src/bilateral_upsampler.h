@@ -0,0 +1,53 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <framework/opengl_includes.h>
+#include <framework/shader.h>
+#include "g_buffer.h"
+#include <array>
+#include <cstddef>
+
+// Runs screen space lighting passes at a fraction of the screen resolution.
+//
+// downsample() reduces the G-buffer by an integer factor: every low resolution pixel takes the position and normal
+// of one of the full resolution pixels it covers, the closest to the camera and the farthest in a checkerboard,
+// so both sides of a depth edge keep samples. The passes run on lowResGBuffer(). upsample() then brings their
+// output back with a joint bilateral filter: every full resolution pixel blends the four low resolution pixels
+// around it by their bilinear weights times how well their distance to the camera and normal match its own,
+// falling back to the closest match when none does.
+class BilateralUpsampler {
+public:
+    static constexpr size_t outputCount = 2;
+
+    BilateralUpsampler();
+    BilateralUpsampler(const BilateralUpsampler&) = delete;
+    ~BilateralUpsampler();
+
+    BilateralUpsampler& operator=(const BilateralUpsampler&) = delete;
+
+    // Fills lowResGBuffer() with the positions and normals of the G-buffer reduced by factor in both directions.
+    void downsample(const GBuffer& gBuffer, int factor, const glm::vec3& cameraPos);
+    // Upsamples a texture the size of lowResGBuffer() to the size of the G-buffer, into one of outputCount output
+    // textures, and returns that texture.
+    GLuint upsample(const GBuffer& gBuffer, GLuint lowResTexture, size_t output);
+
+    int factor() const { return m_factor; }
+    const GBuffer& lowResGBuffer() const { return m_lowResGBuffer; }
+
+private:
+    void resizeOutputs(int width, int height);
+
+private:
+    Shader m_downsampleShader;
+    Shader m_upsampleShader;
+
+    GBuffer m_lowResGBuffer;
+    std::array<GLuint, outputCount> m_outputTextures {}; // RGBA16F at full resolution
+    int m_factor { 1 };
+    glm::vec3 m_cameraPos { 0.0f };
+    int m_outputWidth { 0 };
+    int m_outputHeight { 0 };
+};
@@ -0,0 +1,59 @@
+#include "g_buffer.h"
+#include <initializer_list>
+
+GBuffer::~GBuffer()
+{
+    release();
+}
+
+void GBuffer::resize(int width, int height)
+{
+    if (width == m_width && height == m_height && m_framebuffer)
+        return;
+    release();
+    m_width = width;
+    m_height = height;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_positionTexture);
+    glTextureStorage2D(m_positionTexture, 1, GL_RGBA32F, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_normalTexture);
+    glTextureStorage2D(m_normalTexture, 1, GL_RGBA16F, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_albedoTexture);
+    glTextureStorage2D(m_albedoTexture, 1, GL_RGBA8, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+    glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT32F, width, height);
+    for (GLuint texture : { m_positionTexture, m_normalTexture, m_albedoTexture, m_depthTexture }) {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    glCreateFramebuffers(1, &m_framebuffer);
+    glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0, m_positionTexture, 0);
+    glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT1, m_normalTexture, 0);
+    glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT2, m_albedoTexture, 0);
+    glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_ATTACHMENT, m_depthTexture, 0);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glNamedFramebufferDrawBuffers(m_framebuffer, 3, drawBuffers);
+}
+
+void GBuffer::bindAndClear()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_width, m_height);
+    const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat farDepth = 1.0f;
+    for (GLint drawBuffer = 0; drawBuffer < 3; ++drawBuffer)
+        glClearBufferfv(GL_COLOR, drawBuffer, zero);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
+
+void GBuffer::release()
+{
+    const GLuint textures[] = { m_positionTexture, m_normalTexture, m_albedoTexture, m_depthTexture };
+    glDeleteTextures(4, textures);
+    glDeleteFramebuffers(1, &m_framebuffer);
+    m_framebuffer = m_positionTexture = m_normalTexture = m_albedoTexture = m_depthTexture = 0;
+    m_width = m_height = 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <framework/opengl_includes.h>
+
+// Screen space G-buffer the screen space lighting passes read: world position (RGBA32F), world normal (RGBA16F)
+// and albedo (RGBA8) of the closest surface, with a depth attachment. Pixels no surface covers keep position.w,
+// normal and albedo at 0. All attachments are sampled with nearest filtering.
+class GBuffer {
+public:
+    GBuffer() = default;
+    GBuffer(const GBuffer&) = delete;
+    ~GBuffer();
+
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // (Re)allocates the attachments when the size changes.
+    void resize(int width, int height);
+    // Binds the framebuffer with all color attachments as draw buffers, sets the viewport and clears it.
+    void bindAndClear();
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    GLuint framebuffer() const { return m_framebuffer; }
+    GLuint positionTexture() const { return m_positionTexture; }
+    GLuint normalTexture() const { return m_normalTexture; }
+    GLuint albedoTexture() const { return m_albedoTexture; }
+    GLuint depthTexture() const { return m_depthTexture; }
+
+private:
+    void release();
+
+private:
+    int m_width { 0 };
+    int m_height { 0 };
+    GLuint m_framebuffer { 0 };
+    GLuint m_positionTexture { 0 };
+    GLuint m_normalTexture { 0 };
+    GLuint m_albedoTexture { 0 };
+    GLuint m_depthTexture { 0 };
+};
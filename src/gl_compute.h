@@ -0,0 +1,31 @@
+#pragma once
+#include <framework/opengl_includes.h>
+#include <framework/shader.h>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+
+// Helpers shared by the compute passes on the GPU: the voxelizer, the cone tracer, the ray caster and the temporal
+// and upsampling passes of their output.
+namespace gl_compute {
+
+// Work groups of divisor invocations that cover value items, also used for counts of cells and words.
+inline GLuint divideRoundUp(size_t value, size_t divisor)
+{
+    return GLuint((value + divisor - 1) / divisor);
+}
+
+// Builds the compute shader in file. A shader that fails to compile or link is reported on std::cerr and left empty,
+// like the other shaders of the application, so the rest keeps running without its pass.
+inline Shader buildShader(const std::filesystem::path& file)
+{
+    try {
+        ShaderBuilder builder;
+        builder.addStage(GL_COMPUTE_SHADER, file);
+        return builder.build();
+    } catch (const ShaderLoadingException& e) {
+        std::cerr << e.what() << std::endl;
+        return Shader();
+    }
+}
+}
@@ -0,0 +1,63 @@
+#include "gpu_timings.h"
+
+GpuTimings::Scope::Scope(GpuTimings& timings, size_t pass)
+    : m_timings(timings)
+    , m_pass(pass)
+{
+    Pass& state = m_timings.m_passes[m_pass];
+    m_timings.collect(m_pass, state.next);
+    glQueryCounter(state.queries[2 * state.next], GL_TIMESTAMP);
+}
+
+GpuTimings::Scope::~Scope()
+{
+    Pass& state = m_timings.m_passes[m_pass];
+    glQueryCounter(state.queries[2 * state.next + 1], GL_TIMESTAMP);
+    state.pending[state.next] = true;
+    state.next = (state.next + 1) % ringSize;
+}
+
+GpuTimings::~GpuTimings()
+{
+    clear();
+}
+
+GpuTimings::Scope GpuTimings::measure(const std::string& name)
+{
+    for (size_t pass = 0; pass < m_entries.size(); ++pass) {
+        if (m_entries[pass].name == name)
+            return Scope(*this, pass);
+    }
+    m_entries.push_back(Entry { name, 0.0 });
+    Pass& pass = m_passes.emplace_back();
+    glCreateQueries(GL_TIMESTAMP, GLsizei(pass.queries.size()), pass.queries.data());
+    return Scope(*this, m_passes.size() - 1);
+}
+
+void GpuTimings::clear()
+{
+    for (Pass& pass : m_passes)
+        glDeleteQueries(GLsizei(pass.queries.size()), pass.queries.data());
+    m_passes.clear();
+    m_entries.clear();
+}
+
+void GpuTimings::collect(size_t pass, size_t waitSlot)
+{
+    Pass& state = m_passes[pass];
+    // Oldest first, so the newest available result is the one that stays.
+    for (size_t i = 1; i <= ringSize; ++i) {
+        const size_t slot = (state.next + i) % ringSize;
+        if (!state.pending[slot])
+            continue;
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(state.queries[2 * slot + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && slot != waitSlot)
+            continue;
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(state.queries[2 * slot], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(state.queries[2 * slot + 1], GL_QUERY_RESULT, &end);
+        m_entries[pass].milliseconds = double(end - start) * 1e-6;
+        state.pending[slot] = false;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <framework/opengl_includes.h>
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Keeps the most recent GPU time of each named render pass, in the order the passes were first recorded.
+//
+// A pass is bracketed by two timestamp queries, so passes may nest. Every pass has a small ring of query pairs:
+// measuring a pass reads back the results of earlier frames that have become available without waiting, so
+// the times shown lag a frame or two behind. Only when a pass is measured more often than the ring is deep
+// within the GPU's latency does it wait for the oldest result.
+class GpuTimings {
+public:
+    struct Entry {
+        std::string name;
+        double milliseconds { 0.0 };
+    };
+
+    // Measures the GPU time of the commands issued until the scope object is destroyed.
+    class Scope {
+    public:
+        Scope(GpuTimings& timings, size_t pass);
+        Scope(const Scope&) = delete;
+        ~Scope();
+
+    private:
+        GpuTimings& m_timings;
+        size_t m_pass;
+    };
+
+    GpuTimings() = default;
+    GpuTimings(const GpuTimings&) = delete;
+    ~GpuTimings();
+
+    GpuTimings& operator=(const GpuTimings&) = delete;
+
+    Scope measure(const std::string& name);
+    // Forgets all passes, for when the set of passes changes. Results still in flight are dropped.
+    void clear();
+
+    const std::vector<Entry>& entries() const { return m_entries; }
+
+private:
+    static constexpr size_t ringSize = 4;
+
+    struct Pass {
+        std::array<GLuint, 2 * ringSize> queries {}; // start and end timestamp of every slot
+        std::array<bool, ringSize> pending {};
+        size_t next { 0 };
+    };
+
+    // Records the results of the finished slots of a pass, waits for the given slot if it is still pending.
+    void collect(size_t pass, size_t waitSlot);
+
+private:
+    std::vector<Entry> m_entries;
+    std::vector<Pass> m_passes;
+};
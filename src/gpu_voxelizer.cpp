@@ -0,0 +1,131 @@
+#include "gpu_voxelizer.h"
+#include "gl_compute.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/gtc/type_ptr.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace {
+constexpr GLuint cubeIndexCount = 36;
+
+// Layout expected by glDrawElementsIndirect.
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+}
+
+GpuVoxelizer::GpuVoxelizer()
+{
+    m_voxelizeShader = gl_compute::buildShader("shaders/voxelize_atlas_comp.glsl");
+    m_voxelizePackedShader = gl_compute::buildShader("shaders/voxelize_packed_atlas_comp.glsl");
+    m_compactShader = gl_compute::buildShader("shaders/compact_voxels_comp.glsl");
+
+    glCreateBuffers(1, &m_instanceBuffer);
+    glCreateBuffers(1, &m_indirectBuffer);
+    glNamedBufferStorage(m_indirectBuffer, sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+GpuVoxelizer::~GpuVoxelizer()
+{
+    glDeleteTextures(1, &m_occupancyImage);
+    glDeleteBuffers(1, &m_instanceBuffer);
+    glDeleteBuffers(1, &m_indirectBuffer);
+}
+
+void GpuVoxelizer::begin(int gridLength, const glm::vec3& worldMin, const glm::vec3& worldMax, size_t maxInstances)
+{
+    if (gridLength != m_gridLength) {
+        glDeleteTextures(1, &m_occupancyImage);
+        m_gridLength = gridLength;
+        m_wordsPerRow = (gridLength + 31) / 32;
+        glCreateTextures(GL_TEXTURE_3D, 1, &m_occupancyImage);
+        glTextureStorage3D(m_occupancyImage, 1, GL_R32UI, m_wordsPerRow, gridLength, gridLength);
+    }
+    m_worldMin = worldMin;
+    m_worldMax = worldMax;
+
+    // Every texel marks at most one voxel, so the instance buffer never has to hold more than the texel count.
+    maxInstances = std::min(maxInstances, size_t(gridLength) * gridLength * gridLength);
+    if (maxInstances > m_instanceCapacity) {
+        m_instanceCapacity = maxInstances;
+        glNamedBufferData(m_instanceBuffer, GLsizeiptr(m_instanceCapacity * sizeof(uint32_t)), nullptr, GL_DYNAMIC_COPY);
+    }
+
+    const GLuint zero = 0;
+    glClearTexImage(m_occupancyImage, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    const DrawElementsIndirectCommand command { cubeIndexCount, 0, 0, 0, 0 };
+    glNamedBufferSubData(m_indirectBuffer, 0, sizeof(command), &command);
+}
+
+void GpuVoxelizer::voxelizeAtlas(GLuint atlasTexture, int atlasLength, const glm::mat4& modelMatrix, float invalidValue)
+{
+    m_voxelizeShader.bind();
+    glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+    glUniform3fv(1, 1, glm::value_ptr(m_worldMin));
+    glUniform3fv(2, 1, glm::value_ptr(m_worldMax));
+    glUniform1i(3, m_gridLength);
+    glUniform1f(4, invalidValue);
+    glBindTextureUnit(0, atlasTexture);
+    glBindImageTexture(0, m_occupancyImage, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+
+    // Atomics from different passes are ordered, no barrier is needed between two atlases.
+    glDispatchCompute(gl_compute::divideRoundUp(size_t(atlasLength), 8), gl_compute::divideRoundUp(size_t(atlasLength), 8), 1);
+}
+
+void GpuVoxelizer::voxelizePackedAtlas(GLuint atlasTexture, int atlasLength)
+{
+    m_voxelizePackedShader.bind();
+    glBindTextureUnit(0, atlasTexture);
+    glBindImageTexture(0, m_occupancyImage, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+    glDispatchCompute(gl_compute::divideRoundUp(size_t(atlasLength), 8), gl_compute::divideRoundUp(size_t(atlasLength), 8), 1);
+}
+
+void GpuVoxelizer::compact()
+{
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    m_compactShader.bind();
+    glBindImageTexture(0, m_occupancyImage, 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI);
+    glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, m_indirectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_instanceBuffer);
+    glDispatchCompute(GLuint(m_wordsPerRow), gl_compute::divideRoundUp(size_t(m_gridLength), 8), gl_compute::divideRoundUp(size_t(m_gridLength), 8));
+
+    // The draw reads the instance count as an indirect command and the positions from a shader storage buffer.
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+OccupancyVolume GpuVoxelizer::readOccupancy() const
+{
+    std::vector<uint32_t> words(size_t(m_wordsPerRow) * m_gridLength * m_gridLength);
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glGetTextureImage(m_occupancyImage, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, GLsizei(words.size() * sizeof(uint32_t)), words.data());
+
+    // Two 32-bit words along x make up one 64-bit word of OccupancyVolume.
+    OccupancyVolume occupancy(m_gridLength);
+    std::span<uint64_t> occupancyWords = occupancy.words();
+    for (int z = 0; z < m_gridLength; ++z) {
+        for (int y = 0; y < m_gridLength; ++y) {
+            const size_t row = occupancy.rowIndex(y, z);
+            const size_t gpuRow = (size_t(z) * m_gridLength + y) * m_wordsPerRow;
+            for (int w = 0; w < m_wordsPerRow; ++w)
+                occupancyWords[row + w / 2] |= uint64_t(words[gpuRow + w]) << (32 * (w & 1));
+        }
+    }
+    return occupancy;
+}
+
+uint32_t GpuVoxelizer::readInstanceCount() const
+{
+    DrawElementsIndirectCommand command;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glGetNamedBufferSubData(m_indirectBuffer, 0, sizeof(command), &command);
+    return command.instanceCount;
+}
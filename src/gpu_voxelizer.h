@@ -0,0 +1,66 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <framework/opengl_includes.h>
+#include <framework/shader.h>
+#include <cstddef>
+#include <cstdint>
+#include "occupancy_volume.h"
+
+// Voxelizes atlas textures entirely on the GPU.
+//
+// A compute pass bins every valid atlas texel into an R32UI 3D image with imageAtomicOr (32 voxels along x
+// per texel). A second pass compacts the occupied voxels into an instance buffer, counting them with an
+// atomic counter that lives in the instance count of an indirect draw command, so the voxels can be drawn
+// with glDrawElementsIndirect without any data travelling back to the CPU.
+//
+// Only bounded grids of up to voxel_instance::maxGridLength are supported, positions outside the bounds are
+// clamped like VoxelGrid does.
+class GpuVoxelizer {
+public:
+    GpuVoxelizer();
+    GpuVoxelizer(const GpuVoxelizer&) = delete;
+    ~GpuVoxelizer();
+
+    GpuVoxelizer& operator=(const GpuVoxelizer&) = delete;
+
+    // Clears all voxels, (re)allocating the occupancy image and an instance buffer of maxInstances voxels when needed.
+    void begin(int gridLength, const glm::vec3& worldMin, const glm::vec3& worldMax, size_t maxInstances);
+    // Marks the voxels of all atlas texels that differ from invalidValue, after transforming them by modelMatrix.
+    void voxelizeAtlas(GLuint atlasTexture, int atlasLength, const glm::mat4& modelMatrix, float invalidValue);
+    // Marks the voxels of an R32UI atlas that already holds grid positions of this grid (packed as in
+    // voxel_instance.h), skipping the texels without TexelCompactor::packedValidBit.
+    void voxelizePackedAtlas(GLuint atlasTexture, int atlasLength);
+    // Fills the instance buffer and the indirect draw command from the occupancy image.
+    void compact();
+
+    // Bind as GL_DRAW_INDIRECT_BUFFER, holds a DrawElementsIndirectCommand for a 36 index cube.
+    GLuint indirectBuffer() const { return m_indirectBuffer; }
+    // Bind as shader storage buffer, holds one packed grid position per instance (see voxel_instance.h).
+    GLuint instanceBuffer() const { return m_instanceBuffer; }
+    // Number of instances the instance buffer can hold, the instance count never exceeds it.
+    size_t instanceCapacity() const { return m_instanceCapacity; }
+
+    // Debug readbacks for cross-checking against the CPU voxelization, these wait for the GPU.
+    OccupancyVolume readOccupancy() const;
+    uint32_t readInstanceCount() const;
+
+private:
+    Shader m_voxelizeShader;
+    Shader m_voxelizePackedShader;
+    Shader m_compactShader;
+
+    GLuint m_occupancyImage { 0 };
+    GLuint m_instanceBuffer { 0 };
+    GLuint m_indirectBuffer { 0 };
+
+    int m_gridLength { 0 };
+    int m_wordsPerRow { 0 }; // 32-bit words along x
+    size_t m_instanceCapacity { 0 };
+    glm::vec3 m_worldMin { 0.0f };
+    glm::vec3 m_worldMax { 0.0f };
+};
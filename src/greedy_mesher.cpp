@@ -0,0 +1,199 @@
+#include "greedy_mesher.h"
+#include "occupancy_volume.h"
+#include "parallel.h"
+#include <bit>
+#include <span>
+
+namespace {
+// A face direction: faces of voxels in slice `slice` along `axis` that look towards `sign`. Face masks are
+// planes of rows v (one bitset per row) with bit u, where u and v are the two other axes.
+struct Direction {
+    int axis; // 0 = x, 1 = y, 2 = z
+    int sign; // +1 or -1
+    int uAxis;
+    int vAxis;
+};
+
+// Rows of the face planes are stored along x where possible, so they can be read straight from the occupancy rows.
+constexpr Direction directions[6] = {
+    { 0, +1, 1, 2 }, { 0, -1, 1, 2 },
+    { 1, +1, 0, 2 }, { 1, -1, 0, 2 },
+    { 2, +1, 0, 1 }, { 2, -1, 0, 1 },
+};
+
+// Bits [begin, end) of word w.
+uint64_t rangeMask(int w, int begin, int end)
+{
+    const int lo = std::max(begin - w * 64, 0);
+    const int hi = std::min(end - w * 64, 64);
+    if (lo >= hi)
+        return 0;
+    const uint64_t below = hi == 64 ? ~uint64_t(0) : (uint64_t(1) << hi) - 1;
+    return below & ~((uint64_t(1) << lo) - 1);
+}
+
+bool allSet(const uint64_t* row, int begin, int end)
+{
+    for (int w = begin / 64; w * 64 < end; ++w) {
+        const uint64_t mask = rangeMask(w, begin, end);
+        if ((row[w] & mask) != mask)
+            return false;
+    }
+    return true;
+}
+
+void clearRange(uint64_t* row, int begin, int end)
+{
+    for (int w = begin / 64; w * 64 < end; ++w)
+        row[w] &= ~rangeMask(w, begin, end);
+}
+
+// Index of the first set bit at or after begin, or -1.
+int findSet(const uint64_t* row, int numWords, int begin)
+{
+    for (int w = begin / 64; w < numWords; ++w) {
+        const uint64_t word = row[w] & rangeMask(w, begin, numWords * 64);
+        if (word)
+            return w * 64 + std::countr_zero(word);
+    }
+    return -1;
+}
+
+// Index of the first clear bit at or after begin, or numWords * 64.
+int findClear(const uint64_t* row, int numWords, int begin)
+{
+    for (int w = begin / 64; w < numWords; ++w) {
+        const uint64_t word = ~row[w] & rangeMask(w, begin, numWords * 64);
+        if (word)
+            return w * 64 + std::countr_zero(word);
+    }
+    return numWords * 64;
+}
+
+// Fills plane with the visible faces of slice `slice` in direction dir.
+void buildFacePlane(const OccupancyVolume& occupancy, const Direction& dir, int slice, std::span<uint64_t> plane)
+{
+    const int gridLength = occupancy.gridLength();
+    const size_t numWords = size_t(occupancy.wordsPerRow());
+    const std::span<const uint64_t> words = occupancy.words();
+    const int neighbour = slice + dir.sign;
+    const bool neighbourInside = neighbour >= 0 && neighbour < gridLength;
+
+    if (dir.axis == 2 || dir.axis == 1) {
+        // Rows along x: a face is visible where the row is occupied and the neighbouring row is not.
+        for (int v = 0; v < gridLength; ++v) {
+            const size_t row = dir.axis == 2 ? occupancy.rowIndex(v, slice) : occupancy.rowIndex(slice, v);
+            const size_t neighbourRow = dir.axis == 2 ? occupancy.rowIndex(v, neighbour) : occupancy.rowIndex(neighbour, v);
+            for (size_t w = 0; w < numWords; ++w)
+                plane[size_t(v) * numWords + w] = words[row + w] & (neighbourInside ? ~words[neighbourRow + w] : ~uint64_t(0));
+        }
+        return;
+    }
+
+    // Faces along x: gather bit `slice` of every (y, z) row into rows along y.
+    std::fill(plane.begin(), plane.end(), uint64_t(0));
+    const size_t word = size_t(slice >> 6), neighbourWord = size_t(neighbour >> 6);
+    const int bit = slice & 63, neighbourBit = neighbour & 63;
+    for (int z = 0; z < gridLength; ++z) {
+        uint64_t* planeRow = &plane[size_t(z) * numWords];
+        for (int y = 0; y < gridLength; ++y) {
+            const size_t row = occupancy.rowIndex(y, z);
+            const bool occupied = (words[row + word] >> bit) & 1;
+            const bool neighbourOccupied = neighbourInside && ((words[row + neighbourWord] >> neighbourBit) & 1);
+            if (occupied && !neighbourOccupied)
+                planeRow[y >> 6] |= uint64_t(1) << (y & 63);
+        }
+    }
+}
+
+// Emits 4 vertices for a rectangle [u0, u0 + width) x [v0, v0 + height) on the face plane of a slice,
+// counter-clockwise when seen from outside the voxels.
+void emitQuad(std::vector<GreedyMesher::Vertex>& vertices, const Direction& dir, int slice, int u0, int v0, int width, int height)
+{
+    glm::vec3 normal(0.0f);
+    normal[dir.axis] = float(dir.sign);
+    const float plane = float(slice + (dir.sign > 0 ? 1 : 0));
+    const int corners[4][2] = { { u0, v0 }, { u0 + width, v0 }, { u0 + width, v0 + height }, { u0, v0 + height } };
+
+    // (u, v, axis) is right-handed for x faces (y, z, x) and z faces (x, y, z) but not for y faces (x, z, y).
+    const bool rightHanded = dir.axis != 1;
+    const bool reverse = rightHanded != (dir.sign > 0);
+    for (int i = 0; i < 4; ++i) {
+        const int* corner = corners[reverse ? 3 - i : i];
+        glm::vec3 position;
+        position[dir.axis] = plane;
+        position[dir.uAxis] = float(corner[0]);
+        position[dir.vAxis] = float(corner[1]);
+        vertices.push_back({ position, normal });
+    }
+}
+}
+
+GreedyMesher::GreedyMesher(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+void GreedyMesher::build(const OccupancyVolume& occupancy)
+{
+    clear();
+    const int gridLength = occupancy.gridLength();
+    const int numWords = occupancy.wordsPerRow();
+    if (gridLength == 0)
+        return;
+
+    // One task per (direction, slice), split into contiguous chunks so every chunk's output stays in order.
+    const size_t numTasks = 6 * size_t(gridLength);
+    const unsigned numChunks = unsigned(std::min<size_t>(m_numThreads, numTasks));
+    std::vector<std::vector<Vertex>> chunkVertices(numChunks);
+    std::vector<size_t> chunkFaces(numChunks, 0);
+    parallel::forEachChunk(numTasks, numChunks, [&](unsigned chunk, size_t begin, size_t end) {
+        std::vector<uint64_t> plane(size_t(gridLength) * size_t(numWords));
+        std::vector<Vertex>& vertices = chunkVertices[chunk];
+        for (size_t task = begin; task < end; ++task) {
+            const Direction& dir = directions[task / size_t(gridLength)];
+            const int slice = int(task % size_t(gridLength));
+            buildFacePlane(occupancy, dir, slice, plane);
+            for (uint64_t word : plane)
+                chunkFaces[chunk] += size_t(std::popcount(word));
+
+            for (int v = 0; v < gridLength; ++v) {
+                uint64_t* row = &plane[size_t(v) * size_t(numWords)];
+                for (int u0 = findSet(row, numWords, 0); u0 >= 0; u0 = findSet(row, numWords, u0)) {
+                    const int u1 = findClear(row, numWords, u0);
+                    int height = 1;
+                    while (v + height < gridLength && allSet(&plane[size_t(v + height) * size_t(numWords)], u0, u1)) {
+                        clearRange(&plane[size_t(v + height) * size_t(numWords)], u0, u1);
+                        ++height;
+                    }
+                    clearRange(row, u0, u1);
+                    emitQuad(vertices, dir, slice, u0, v, u1 - u0, height);
+                }
+            }
+        }
+    });
+
+    size_t numVertices = 0;
+    for (unsigned chunk = 0; chunk < numChunks; ++chunk) {
+        numVertices += chunkVertices[chunk].size();
+        m_visibleFaces += chunkFaces[chunk];
+    }
+    m_vertices.reserve(numVertices);
+    for (const std::vector<Vertex>& vertices : chunkVertices)
+        m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+
+    // Two triangles per quad.
+    m_indices.resize(quadCount() * 6);
+    for (uint32_t quad = 0; quad < uint32_t(quadCount()); ++quad) {
+        const uint32_t first = quad * 4;
+        const uint32_t quadIndices[6] = { first, first + 1, first + 2, first + 2, first + 3, first };
+        std::copy(std::begin(quadIndices), std::end(quadIndices), m_indices.begin() + quad * 6);
+    }
+}
+
+void GreedyMesher::clear()
+{
+    m_vertices.clear();
+    m_indices.clear();
+    m_visibleFaces = 0;
+}
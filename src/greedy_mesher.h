@@ -0,0 +1,46 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class OccupancyVolume;
+
+// Surface mesher for a voxel grid. Only faces between an occupied and an empty voxel are kept (the grid border
+// counts as empty), and the visible faces of every slice are greedily merged into rectangles: take the first
+// visible face in row order, extend it along the row as far as possible, then extend that run over the
+// following rows while they are fully visible.
+//
+// Face masks are built word-parallel from the occupancy rows. Slices are meshed in parallel and the output is
+// concatenated in slice order, so it does not depend on the number of threads.
+class GreedyMesher {
+public:
+    // Same layout as the cube vertices of the instanced voxels, positions are in grid units.
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    // numThreads = 0 uses all hardware threads.
+    explicit GreedyMesher(unsigned numThreads = 0);
+
+    // Meshes the surface of occupancy, replacing the previous mesh. Every quad has 4 vertices and 6 indices.
+    void build(const OccupancyVolume& occupancy);
+    void clear();
+
+    const std::vector<Vertex>& vertices() const { return m_vertices; }
+    const std::vector<uint32_t>& indices() const { return m_indices; }
+    size_t quadCount() const { return m_vertices.size() / 4; }
+    // Number of visible voxel faces before merging.
+    size_t visibleFaceCount() const { return m_visibleFaces; }
+
+private:
+    unsigned m_numThreads;
+    std::vector<Vertex> m_vertices;
+    std::vector<uint32_t> m_indices;
+    size_t m_visibleFaces { 0 };
+};
@@ -0,0 +1,150 @@
+#include "hashed_occupancy.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vector_relational.hpp>
+DISABLE_WARNINGS_POP()
+#include <cassert>
+
+namespace {
+constexpr size_t initialCapacity = 1024;
+constexpr int32_t keyBias = 1 << 20; // moves signed brick coordinates into the unsigned 21-bit range
+
+// Finalizer of MurmurHash3, spreads the packed coordinates over all bits.
+uint64_t hashKey(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+glm::ivec3 brickOf(const glm::ivec3& gridPos)
+{
+    return glm::ivec3(gridPos.x >> 3, gridPos.y >> 3, gridPos.z >> 3); // arithmetic shift rounds towards -inf
+}
+
+uint64_t bitOf(const glm::ivec3& gridPos)
+{
+    return uint64_t(1) << ((gridPos.x & 7) | ((gridPos.y & 7) << 3));
+}
+}
+
+HashedOccupancy::HashedOccupancy()
+{
+    clear();
+}
+
+void HashedOccupancy::clear()
+{
+    m_slotKeys.assign(initialCapacity, emptySlot);
+    m_slotBricks.assign(initialCapacity, 0);
+    m_brickKeys.clear();
+    m_bricks.clear();
+    m_lastKey = emptySlot;
+    m_lastBrick = 0;
+}
+
+bool HashedOccupancy::test(const glm::ivec3& gridPos) const
+{
+    const int64_t brick = findBrick(packKey(brickOf(gridPos)));
+    return brick >= 0 && (m_bricks[size_t(brick)][gridPos.z & 7] & bitOf(gridPos));
+}
+
+bool HashedOccupancy::set(const glm::ivec3& gridPos)
+{
+    uint64_t& word = m_bricks[findOrInsertBrick(packKey(brickOf(gridPos)))][gridPos.z & 7];
+    const uint64_t bit = bitOf(gridPos);
+    const bool wasSet = (word & bit) != 0;
+    word |= bit;
+    return !wasSet;
+}
+
+void HashedOccupancy::reset(const glm::ivec3& gridPos)
+{
+    // Bricks are not freed when they become empty, they are likely to be filled again.
+    const int64_t brick = findBrick(packKey(brickOf(gridPos)));
+    if (brick >= 0)
+        m_bricks[size_t(brick)][gridPos.z & 7] &= ~bitOf(gridPos);
+}
+
+size_t HashedOccupancy::count() const
+{
+    size_t total = 0;
+    for (const Brick& brick : m_bricks) {
+        for (uint64_t word : brick)
+            total += size_t(std::popcount(word));
+    }
+    return total;
+}
+
+size_t HashedOccupancy::memoryBytes() const
+{
+    return m_slotKeys.size() * (sizeof(uint64_t) + sizeof(uint32_t)) + m_bricks.size() * (sizeof(Brick) + sizeof(uint64_t));
+}
+
+uint64_t HashedOccupancy::packKey(const glm::ivec3& brickPos)
+{
+    assert(glm::all(glm::greaterThanEqual(brickPos, glm::ivec3(-keyBias))) && glm::all(glm::lessThan(brickPos, glm::ivec3(keyBias))));
+    return uint64_t(uint32_t(brickPos.x + keyBias) & 0x1fffff)
+        | (uint64_t(uint32_t(brickPos.y + keyBias) & 0x1fffff) << 21)
+        | (uint64_t(uint32_t(brickPos.z + keyBias) & 0x1fffff) << 42);
+}
+
+glm::ivec3 HashedOccupancy::unpackKey(uint64_t key)
+{
+    return glm::ivec3(int32_t(key & 0x1fffff) - keyBias, int32_t((key >> 21) & 0x1fffff) - keyBias, int32_t((key >> 42) & 0x1fffff) - keyBias);
+}
+
+int64_t HashedOccupancy::findBrick(uint64_t key) const
+{
+    const size_t mask = m_slotKeys.size() - 1;
+    for (size_t slot = hashKey(key) & mask;; slot = (slot + 1) & mask) {
+        if (m_slotKeys[slot] == key)
+            return m_slotBricks[slot];
+        if (m_slotKeys[slot] == emptySlot)
+            return -1;
+    }
+}
+
+size_t HashedOccupancy::findOrInsertBrick(uint64_t key)
+{
+    if (key == m_lastKey)
+        return m_lastBrick;
+
+    // Keep the load factor below 1/2 so probe sequences stay short.
+    if (2 * (m_bricks.size() + 1) > m_slotKeys.size())
+        grow();
+
+    const size_t mask = m_slotKeys.size() - 1;
+    size_t slot = hashKey(key) & mask;
+    while (m_slotKeys[slot] != key && m_slotKeys[slot] != emptySlot)
+        slot = (slot + 1) & mask;
+
+    if (m_slotKeys[slot] == emptySlot) {
+        m_slotKeys[slot] = key;
+        m_slotBricks[slot] = uint32_t(m_bricks.size());
+        m_brickKeys.push_back(key);
+        m_bricks.push_back(Brick {});
+    }
+    m_lastKey = key;
+    m_lastBrick = m_slotBricks[slot];
+    return m_slotBricks[slot];
+}
+
+void HashedOccupancy::grow()
+{
+    const size_t capacity = m_slotKeys.size() * 2;
+    m_slotKeys.assign(capacity, emptySlot);
+    m_slotBricks.assign(capacity, 0);
+    const size_t mask = capacity - 1;
+    for (size_t brick = 0; brick < m_brickKeys.size(); ++brick) {
+        size_t slot = hashKey(m_brickKeys[brick]) & mask;
+        while (m_slotKeys[slot] != emptySlot)
+            slot = (slot + 1) & mask;
+        m_slotKeys[slot] = m_brickKeys[brick];
+        m_slotBricks[slot] = uint32_t(brick);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sparse occupancy bitfield for an unbounded voxel grid. Voxels are grouped in 8^3 bricks (512 bits) that
+// are only allocated once a voxel inside them is set. Bricks are found through an open-addressing hash table
+// (linear probing) keyed by the brick coordinate packed into 64 bits (21 bits per axis, so grid coordinates
+// can range over [-coordinateLimit, coordinateLimit), coordinates outside would alias other bricks).
+//
+// Has the same test/set/count/iterate interface as OccupancyVolume so the two can be swapped.
+class HashedOccupancy {
+public:
+    static constexpr int brickLength = 8;
+    static constexpr int coordinateLimit = 1 << 23;
+    using Brick = std::array<uint64_t, 8>; // one word per z slice, bit index x + 8 * y
+
+    HashedOccupancy();
+
+    // Removes all bricks and shrinks the hash table back to its initial size.
+    void clear();
+
+    bool test(const glm::ivec3& gridPos) const;
+    // Marks a voxel as occupied, returns true if it was not occupied before.
+    bool set(const glm::ivec3& gridPos);
+    void reset(const glm::ivec3& gridPos);
+
+    // Number of occupied voxels (popcount over all bricks).
+    size_t count() const;
+    size_t brickCount() const { return m_bricks.size(); }
+    size_t memoryBytes() const;
+
+    // Calls f(glm::ivec3) for every occupied voxel, brick by brick.
+    template <typename F>
+    void forEachOccupied(F&& f) const
+    {
+        for (size_t i = 0; i < m_bricks.size(); ++i) {
+            const glm::ivec3 brickMin = unpackKey(m_brickKeys[i]) * brickLength;
+            for (int z = 0; z < brickLength; ++z) {
+                uint64_t word = m_bricks[i][size_t(z)];
+                while (word) {
+                    const int bit = std::countr_zero(word);
+                    f(brickMin + glm::ivec3(bit & 7, bit >> 3, z));
+                    word &= word - 1; // clear lowest set bit
+                }
+            }
+        }
+    }
+
+private:
+    static uint64_t packKey(const glm::ivec3& brickPos);
+    static glm::ivec3 unpackKey(uint64_t key);
+
+    // Index of the brick with the key in m_bricks, or -1 if it has not been allocated.
+    int64_t findBrick(uint64_t key) const;
+    size_t findOrInsertBrick(uint64_t key);
+    void grow();
+
+private:
+    static constexpr uint64_t emptySlot = ~uint64_t(0);
+
+    std::vector<uint64_t> m_slotKeys; // hash table, capacity is a power of two
+    std::vector<uint32_t> m_slotBricks; // brick index per slot
+    std::vector<uint64_t> m_brickKeys; // key of every allocated brick
+    std::vector<Brick> m_bricks; // dense pool of allocated bricks
+
+    // Consecutive inserts are usually in the same brick, remember the last one. Only set() uses it, so test() does
+    // not write to the occupancy and can be called from several threads at once.
+    uint64_t m_lastKey { emptySlot };
+    size_t m_lastBrick { 0 };
+};
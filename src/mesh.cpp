@@ -22,6 +22,8 @@ GPUMesh::GPUMesh(const Mesh& cpuMesh)
 
     // Figure out if this mesh has texture coordinates
     m_hasTextureCoords = static_cast<bool>(cpuMesh.material.kdTexture);
+    if (m_hasTextureCoords)
+        m_kdTexture = std::make_unique<Texture>(*cpuMesh.material.kdTexture);
 
     // Create Element(/Index) Buffer Objects and Vertex Buffer Object.
     glCreateBuffers(1, &m_ibo);
@@ -90,6 +92,11 @@ bool GPUMesh::hasTextureCoords() const
     return m_hasTextureCoords;
 }
 
+Texture* GPUMesh::kdTexture() const
+{
+    return m_kdTexture.get();
+}
+
 void GPUMesh::draw(const Shader& drawingShader)
 {
     // Bind material data uniform (we assume that the uniform buffer objectg is always called 'Material')
@@ -111,6 +118,7 @@ void GPUMesh::moveInto(GPUMesh&& other)
     m_vbo = other.m_vbo;
     m_vao = other.m_vao;
     m_uboMaterial = other.m_uboMaterial;
+    m_kdTexture = std::move(other.m_kdTexture);
 
     other.m_numIndices = 0;
     other.m_hasTextureCoords = other.m_hasTextureCoords;
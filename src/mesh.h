@@ -10,6 +10,8 @@ DISABLE_WARNINGS_POP()
 #include <exception>
 #include <filesystem>
 #include <framework/opengl_includes.h>
+#include <memory>
+#include "texture.h"
 
 struct MeshLoadingException : public std::runtime_error {
     using std::runtime_error::runtime_error;
@@ -42,6 +44,8 @@ public:
     GPUMesh& operator=(GPUMesh&&);
 
     bool hasTextureCoords() const;
+    // The diffuse texture of the material (Material::kdTexture), nullptr if the mesh has none.
+    Texture* kdTexture() const;
 
     // Bind VAO and call glDrawElements.
     void draw(const Shader& drawingShader);
@@ -59,4 +63,5 @@ private:
     GLuint m_vbo { INVALID };
     GLuint m_vao { INVALID };
     GLuint m_uboMaterial { INVALID };
+    std::unique_ptr<Texture> m_kdTexture;
 };
@@ -0,0 +1,53 @@
+#include "morton.h"
+
+// LSD radix sort with 11-bit digits, skipping passes above keyBits.
+void morton::sortKeys(std::vector<uint64_t>& keys, int keyBits)
+{
+    constexpr int digitBits = 11;
+    constexpr size_t numBuckets = size_t(1) << digitBits;
+    std::vector<uint64_t> keysTmp(keys.size());
+    std::vector<size_t> offsets(numBuckets);
+    for (int shift = 0; shift < keyBits; shift += digitBits) {
+        std::fill(offsets.begin(), offsets.end(), size_t(0));
+        for (uint64_t key : keys)
+            ++offsets[(key >> shift) & (numBuckets - 1)];
+        size_t sum = 0;
+        for (size_t& offset : offsets) {
+            const size_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+        for (uint64_t key : keys)
+            keysTmp[offsets[(key >> shift) & (numBuckets - 1)]++] = key;
+        keys.swap(keysTmp);
+    }
+}
+
+uint64_t morton::nextInBox(uint64_t key, uint64_t boxMinKey, uint64_t boxMaxKey)
+{
+    // Walk the bits from most to least significant and compare key with the min/max keys. The masks select,
+    // for the dimension of the current bit, that bit and all less significant bits of the same dimension.
+    uint64_t bigMin = boxMaxKey + 1; // no key in the box is larger than key
+    for (int bit = 62; bit >= 0; --bit) {
+        const uint64_t mask = uint64_t(1) << bit;
+        const uint64_t dimensionBits = (0x1249249249249249ull << (bit % 3)) & ((mask << 1) - 1);
+        const uint64_t lowerBits = dimensionBits & ~mask;
+        const int pattern = ((key & mask) ? 4 : 0) | ((boxMinKey & mask) ? 2 : 0) | ((boxMaxKey & mask) ? 1 : 0);
+        switch (pattern) {
+        case 1: // key 0, min 0, max 1: the answer is in the upper half or in the lower half with a smaller max
+            bigMin = (boxMinKey & ~dimensionBits) | mask;
+            boxMaxKey = (boxMaxKey & ~dimensionBits) | lowerBits;
+            break;
+        case 3: // key 0, min 1, max 1: the whole box is above key
+            return boxMinKey;
+        case 4: // key 1, min 0, max 0: the whole box is below key
+            return bigMin;
+        case 5: // key 1, min 0, max 1: continue in the upper half of the box
+            boxMinKey = (boxMinKey & ~dimensionBits) | mask;
+            break;
+        default: // 0/7: all equal; 2/6 cannot occur for a valid box
+            break;
+        }
+    }
+    return bigMin;
+}
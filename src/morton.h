@@ -0,0 +1,132 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Morton (Z-order) keys interleave the bits of the x, y and z grid coordinates (x in the lowest bit),
+// so voxels that are close in 3D are mostly close in memory when stored in key order.
+// 32-bit keys hold 10 bits per axis (grids up to 1024^3), 64-bit keys hold 21 bits per axis.
+namespace morton {
+
+inline uint32_t spread10(uint32_t v)
+{
+#if defined(__BMI2__)
+    return _pdep_u32(v, 0x09249249u);
+#else
+    v &= 0x3ffu;
+    v = (v | (v << 16)) & 0x030000ffu;
+    v = (v | (v << 8)) & 0x0300f00fu;
+    v = (v | (v << 4)) & 0x030c30c3u;
+    v = (v | (v << 2)) & 0x09249249u;
+    return v;
+#endif
+}
+
+inline uint32_t compact10(uint32_t v)
+{
+#if defined(__BMI2__)
+    return _pext_u32(v, 0x09249249u);
+#else
+    v &= 0x09249249u;
+    v = (v | (v >> 2)) & 0x030c30c3u;
+    v = (v | (v >> 4)) & 0x0300f00fu;
+    v = (v | (v >> 8)) & 0x030000ffu;
+    v = (v | (v >> 16)) & 0x3ffu;
+    return v;
+#endif
+}
+
+inline uint64_t spread21(uint64_t v)
+{
+#if defined(__BMI2__)
+    return _pdep_u64(v, 0x1249249249249249ull);
+#else
+    v &= 0x1fffffull;
+    v = (v | (v << 32)) & 0x1f00000000ffffull;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffull;
+    v = (v | (v << 8)) & 0x100f00f00f00f00full;
+    v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+    v = (v | (v << 2)) & 0x1249249249249249ull;
+    return v;
+#endif
+}
+
+inline uint64_t compact21(uint64_t v)
+{
+#if defined(__BMI2__)
+    return _pext_u64(v, 0x1249249249249249ull);
+#else
+    v &= 0x1249249249249249ull;
+    v = (v | (v >> 2)) & 0x10c30c30c30c30c3ull;
+    v = (v | (v >> 4)) & 0x100f00f00f00f00full;
+    v = (v | (v >> 8)) & 0x1f0000ff0000ffull;
+    v = (v | (v >> 16)) & 0x1f00000000ffffull;
+    v = (v | (v >> 32)) & 0x1fffffull;
+    return v;
+#endif
+}
+
+inline uint32_t encode10(const glm::ivec3& p)
+{
+    return spread10(uint32_t(p.x)) | (spread10(uint32_t(p.y)) << 1) | (spread10(uint32_t(p.z)) << 2);
+}
+
+inline glm::ivec3 decode10(uint32_t key)
+{
+    return glm::ivec3(int(compact10(key)), int(compact10(key >> 1)), int(compact10(key >> 2)));
+}
+
+inline uint64_t encode21(const glm::ivec3& p)
+{
+    return spread21(uint64_t(p.x)) | (spread21(uint64_t(p.y)) << 1) | (spread21(uint64_t(p.z)) << 2);
+}
+
+inline glm::ivec3 decode21(uint64_t key)
+{
+    return glm::ivec3(int(compact21(key)), int(compact21(key >> 1)), int(compact21(key >> 2)));
+}
+
+// Sorts keys in place with an LSD radix sort over the lowest keyBits bits.
+void sortKeys(std::vector<uint64_t>& keys, int keyBits = 63);
+
+// Smallest key larger than key that lies inside the box spanned by the keys of its min and max corners
+// (the BIGMIN operation of Tropf and Herzog). Used to skip over the parts of a Morton interval outside a box.
+uint64_t nextInBox(uint64_t key, uint64_t boxMinKey, uint64_t boxMaxKey);
+
+inline bool insideBox(uint64_t key, const glm::ivec3& boxMin, const glm::ivec3& boxMax)
+{
+    const glm::ivec3 p = decode21(key);
+    return p.x >= boxMin.x && p.y >= boxMin.y && p.z >= boxMin.z && p.x <= boxMax.x && p.y <= boxMax.y && p.z <= boxMax.z;
+}
+
+// Calls f(index) for every key in the sorted range that lies inside the inclusive box [boxMin, boxMax].
+// Runs of keys inside the box are walked linearly; keys outside the box are skipped with a binary search
+// to the next Morton interval that re-enters the box. The voxels are not stored in Morton order, so only the
+// benchmark queries boxes this way.
+template <typename F>
+void forEachInBox(std::span<const uint64_t> sortedKeys, const glm::ivec3& boxMin, const glm::ivec3& boxMax, F&& f)
+{
+    const uint64_t minKey = encode21(boxMin);
+    const uint64_t maxKey = encode21(boxMax);
+    auto it = std::lower_bound(sortedKeys.begin(), sortedKeys.end(), minKey);
+    while (it != sortedKeys.end() && *it <= maxKey) {
+        if (insideBox(*it, boxMin, boxMax)) {
+            f(size_t(it - sortedKeys.begin()));
+            ++it;
+        } else {
+            it = std::lower_bound(it, sortedKeys.end(), nextInBox(*it, minKey, maxKey));
+        }
+    }
+}
+
+}
@@ -0,0 +1,135 @@
+#include "occupancy_pyramid.h"
+#include "parallel.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/common.hpp>
+#include <glm/vector_relational.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+// Merges every pair of neighbouring bits (2i, 2i + 1) into bit i.
+uint64_t mergeBitPairs(uint64_t bits)
+{
+    bits |= bits >> 1;
+#if defined(__BMI2__)
+    return _pext_u64(bits, 0x5555555555555555ull);
+#else
+    bits &= 0x5555555555555555ull;
+    bits = (bits | (bits >> 1)) & 0x3333333333333333ull;
+    bits = (bits | (bits >> 2)) & 0x0f0f0f0f0f0f0f0full;
+    bits = (bits | (bits >> 4)) & 0x00ff00ff00ff00ffull;
+    bits = (bits | (bits >> 8)) & 0x0000ffff0000ffffull;
+    return (bits | (bits >> 16)) & 0x00000000ffffffffull;
+#endif
+}
+
+void reduce(const OccupancyVolume& fine, OccupancyVolume& coarse, unsigned numThreads)
+{
+    const int coarseLength = fine.gridLength() / 2;
+    coarse.resize(coarseLength);
+    const std::span<const uint64_t> fineWords = fine.words();
+    const std::span<uint64_t> coarseWords = coarse.words();
+    const size_t fineWordsPerRow = size_t(fine.wordsPerRow()), coarseWordsPerRow = size_t(coarse.wordsPerRow());
+
+    parallel::forEachChunk(size_t(coarseLength), unsigned(std::min<size_t>(numThreads, size_t(coarseLength))), [&](unsigned, size_t begin, size_t end) {
+        for (int z = int(begin); z < int(end); ++z) {
+            for (int y = 0; y < coarseLength; ++y) {
+                const size_t rows[4] = { fine.rowIndex(2 * y, 2 * z), fine.rowIndex(2 * y + 1, 2 * z), fine.rowIndex(2 * y, 2 * z + 1), fine.rowIndex(2 * y + 1, 2 * z + 1) };
+                const auto fineWord = [&](size_t w) {
+                    return fineWordsPerRow > w ? fineWords[rows[0] + w] | fineWords[rows[1] + w] | fineWords[rows[2] + w] | fineWords[rows[3] + w] : uint64_t(0);
+                };
+                // Two fine words cover the 64 voxels of one coarse word.
+                const size_t coarseRow = coarse.rowIndex(y, z);
+                for (size_t w = 0; w < coarseWordsPerRow; ++w)
+                    coarseWords[coarseRow + w] = mergeBitPairs(fineWord(2 * w)) | (mergeBitPairs(fineWord(2 * w + 1)) << 32);
+            }
+        }
+    });
+}
+}
+
+OccupancyPyramid::OccupancyPyramid(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+void OccupancyPyramid::build(const OccupancyVolume& finest)
+{
+    m_levels.resize(1);
+    m_levels[0] = finest;
+    while (m_levels.back().gridLength() > 1 && m_levels.back().gridLength() % 2 == 0) {
+        OccupancyVolume coarse;
+        reduce(m_levels.back(), coarse, m_numThreads);
+        m_levels.push_back(std::move(coarse));
+    }
+}
+
+void OccupancyPyramid::clear()
+{
+    m_levels.clear();
+}
+
+int OccupancyPyramid::findLevel(int gridLength) const
+{
+    for (int level = 0; level < numLevels(); ++level) {
+        if (m_levels[size_t(level)].gridLength() == gridLength)
+            return level;
+    }
+    return -1;
+}
+
+bool OccupancyPyramid::anyInBox(const glm::ivec3& boxMin, const glm::ivec3& boxMax) const
+{
+    if (m_levels.empty())
+        return false;
+    const glm::ivec3 clampedMin = glm::max(boxMin, glm::ivec3(0));
+    const glm::ivec3 clampedMax = glm::min(boxMax, glm::ivec3(m_levels[0].gridLength() - 1));
+    if (glm::any(glm::greaterThan(clampedMin, clampedMax)))
+        return false;
+
+    const int top = numLevels() - 1;
+    const glm::ivec3 first = clampedMin >> top, last = clampedMax >> top;
+    for (int z = first.z; z <= last.z; ++z) {
+        for (int y = first.y; y <= last.y; ++y) {
+            for (int x = first.x; x <= last.x; ++x) {
+                if (anyInBox(top, glm::ivec3(x, y, z), clampedMin, clampedMax))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool OccupancyPyramid::anyInBox(int level, const glm::ivec3& voxel, const glm::ivec3& boxMin, const glm::ivec3& boxMax) const
+{
+    if (!m_levels[size_t(level)].test(voxel))
+        return false;
+    if (level == 0)
+        return true;
+    // Children of voxel that overlap the box, in the coordinates of the level below.
+    const int childLevel = level - 1;
+    const glm::ivec3 first = glm::max(voxel * 2, boxMin >> childLevel);
+    const glm::ivec3 last = glm::min(voxel * 2 + 1, boxMax >> childLevel);
+    for (int z = first.z; z <= last.z; ++z) {
+        for (int y = first.y; y <= last.y; ++y) {
+            for (int x = first.x; x <= last.x; ++x) {
+                if (anyInBox(childLevel, glm::ivec3(x, y, z), boxMin, boxMax))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t OccupancyPyramid::memoryBytes() const
+{
+    size_t total = 0;
+    for (const OccupancyVolume& level : m_levels)
+        total += level.memoryBytes();
+    return total;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "occupancy_volume.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <vector>
+
+// Occupancy mip chain: level 0 is a voxelized grid, every coarser level halves the grid length and marks a voxel
+// if any of the 2x2x2 voxels below it is occupied. Binning a point into a grid of half the length lands in the
+// parent of its voxel, and a box overlaps a triangle if one of its eight halves does, so a coarser level equals
+// voxelizing at its grid length directly. Levels stop at the first odd grid length, which cannot be halved.
+//
+// Every level is reduced from the one below it in parallel over z planes. Per coarse row, the four fine rows
+// are OR-ed word by word and pairs of neighbouring bits are merged and compacted into one.
+class OccupancyPyramid {
+public:
+    // numThreads = 0 uses all hardware threads.
+    explicit OccupancyPyramid(unsigned numThreads = 0);
+
+    // Builds all levels from the voxels of finest.
+    void build(const OccupancyVolume& finest);
+    void clear();
+
+    int numLevels() const { return int(m_levels.size()); }
+    const OccupancyVolume& level(int level) const { return m_levels[size_t(level)]; }
+    // Level with the given grid length, -1 if the pyramid has none.
+    int findLevel(int gridLength) const;
+
+    // Box query on level 0: whether any voxel in the inclusive box [boxMin, boxMax] is occupied. Descends from the
+    // coarsest level and only visits the children of occupied voxels.
+    bool anyInBox(const glm::ivec3& boxMin, const glm::ivec3& boxMax) const;
+
+    size_t memoryBytes() const;
+    unsigned numThreads() const { return m_numThreads; }
+
+private:
+    bool anyInBox(int level, const glm::ivec3& voxel, const glm::ivec3& boxMin, const glm::ivec3& boxMax) const;
+
+private:
+    unsigned m_numThreads;
+    std::vector<OccupancyVolume> m_levels;
+};
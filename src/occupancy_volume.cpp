@@ -0,0 +1,37 @@
+#include "occupancy_volume.h"
+#include <algorithm>
+#include <cassert>
+
+OccupancyVolume::OccupancyVolume(int gridLength)
+{
+    resize(gridLength);
+}
+
+void OccupancyVolume::resize(int gridLength)
+{
+    m_gridLength = gridLength;
+    m_wordsPerRow = (gridLength + 63) / 64;
+    m_words.assign(size_t(gridLength) * size_t(gridLength) * size_t(m_wordsPerRow), 0);
+}
+
+void OccupancyVolume::clear()
+{
+    std::fill(m_words.begin(), m_words.end(), uint64_t(0));
+}
+
+size_t OccupancyVolume::count() const
+{
+    size_t total = 0;
+    for (uint64_t word : m_words)
+        total += size_t(std::popcount(word));
+    return total;
+}
+
+size_t OccupancyVolume::countDifferences(const OccupancyVolume& other) const
+{
+    assert(other.m_gridLength == m_gridLength);
+    size_t total = 0;
+    for (size_t i = 0; i < m_words.size(); ++i)
+        total += size_t(std::popcount(m_words[i] ^ other.m_words[i]));
+    return total;
+}
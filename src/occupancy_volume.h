@@ -0,0 +1,93 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Dense occupancy bitfield for a cubic voxel grid, storing 1 bit per voxel in 64-bit words.
+// Voxels are laid out x-fastest; every (y, z) row starts on a new word so a row can be processed word by word.
+class OccupancyVolume {
+public:
+    OccupancyVolume() = default;
+    explicit OccupancyVolume(int gridLength);
+
+    // Resizes the volume to gridLength^3 voxels and clears all bits.
+    void resize(int gridLength);
+    // Clears all bits while keeping the current size.
+    void clear();
+
+    bool test(const glm::ivec3& gridPos) const
+    {
+        return (m_words[wordIndex(gridPos)] >> (gridPos.x & 63)) & 1u;
+    }
+
+    // Marks a voxel as occupied, returns true if it was not occupied before.
+    bool set(const glm::ivec3& gridPos)
+    {
+        uint64_t& word = m_words[wordIndex(gridPos)];
+        const uint64_t bit = uint64_t(1) << (gridPos.x & 63);
+        const bool wasSet = (word & bit) != 0;
+        word |= bit;
+        return !wasSet;
+    }
+
+    void reset(const glm::ivec3& gridPos)
+    {
+        m_words[wordIndex(gridPos)] &= ~(uint64_t(1) << (gridPos.x & 63));
+    }
+
+    bool contains(const glm::ivec3& gridPos) const
+    {
+        return gridPos.x >= 0 && gridPos.y >= 0 && gridPos.z >= 0
+            && gridPos.x < m_gridLength && gridPos.y < m_gridLength && gridPos.z < m_gridLength;
+    }
+
+    // Number of occupied voxels (popcount over all words).
+    size_t count() const;
+    // Number of voxels whose occupancy differs from other, which must have the same grid length.
+    size_t countDifferences(const OccupancyVolume& other) const;
+    size_t memoryBytes() const { return m_words.size() * sizeof(uint64_t); }
+
+    int gridLength() const { return m_gridLength; }
+    int wordsPerRow() const { return m_wordsPerRow; }
+    size_t rowIndex(int y, int z) const { return (size_t(z) * size_t(m_gridLength) + size_t(y)) * size_t(m_wordsPerRow); }
+
+    std::span<uint64_t> words() { return m_words; }
+    std::span<const uint64_t> words() const { return m_words; }
+
+    // Calls f(glm::ivec3) for every occupied voxel, skipping empty words entirely.
+    template <typename F>
+    void forEachOccupied(F&& f) const
+    {
+        for (int z = 0; z < m_gridLength; ++z) {
+            for (int y = 0; y < m_gridLength; ++y) {
+                const size_t row = rowIndex(y, z);
+                for (int w = 0; w < m_wordsPerRow; ++w) {
+                    uint64_t word = m_words[row + size_t(w)];
+                    while (word) {
+                        const int bit = std::countr_zero(word);
+                        f(glm::ivec3(w * 64 + bit, y, z));
+                        word &= word - 1; // clear lowest set bit
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    size_t wordIndex(const glm::ivec3& gridPos) const
+    {
+        return rowIndex(gridPos.y, gridPos.z) + size_t(gridPos.x >> 6);
+    }
+
+private:
+    int m_gridLength { 0 };
+    int m_wordsPerRow { 0 };
+    std::vector<uint64_t> m_words;
+};
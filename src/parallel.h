@@ -0,0 +1,47 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Fork-join helpers shared by the CPU voxelization stages. Threads are started per call, the stages
+// run once per voxelization so a thread pool would not pay off.
+namespace parallel {
+
+// Number of threads to use when the caller passes 0 (all hardware threads), at least 1.
+inline unsigned resolveThreadCount(unsigned numThreads)
+{
+    if (numThreads == 0)
+        numThreads = std::thread::hardware_concurrency();
+    return std::max(numThreads, 1u);
+}
+
+// Runs f(chunkIndex, begin, end) over numChunks contiguous chunks of [0, count), each on its own thread.
+// Chunks may be empty when count is smaller than numChunks.
+template <typename F>
+void forEachChunk(size_t count, unsigned numChunks, F&& f)
+{
+    if (numChunks <= 1) {
+        f(0u, size_t(0), count);
+        return;
+    }
+    std::vector<std::thread> threads;
+    const size_t chunk = (count + numChunks - 1) / numChunks;
+    for (unsigned t = 0; t < numChunks; ++t) {
+        const size_t begin = std::min(count, t * chunk);
+        const size_t end = std::min(count, begin + chunk);
+        threads.emplace_back([&f, t, begin, end]() { f(t, begin, end); });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+// Runs f(begin, end) over numThreads contiguous chunks of [0, count), or on the calling thread if count is small.
+template <typename F>
+void parallelChunks(size_t count, unsigned numThreads, F&& f)
+{
+    if (count < 4096)
+        numThreads = 1;
+    forEachChunk(count, numThreads, [&f](unsigned, size_t begin, size_t end) { f(begin, end); });
+}
+}
@@ -0,0 +1,78 @@
+#include "reflective_shadow_map.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+ReflectiveShadowMap::~ReflectiveShadowMap()
+{
+    release();
+}
+
+void ReflectiveShadowMap::resize(int length)
+{
+    if (length == m_length && m_framebuffer)
+        return;
+    release();
+    m_length = length;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_positionTexture);
+    glTextureStorage2D(m_positionTexture, 1, GL_RGBA32F, length, length);
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_normalTexture);
+    glTextureStorage2D(m_normalTexture, 1, GL_RGBA16F, length, length);
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_fluxTexture);
+    glTextureStorage2D(m_fluxTexture, 1, GL_RGBA16F, length, length);
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+    glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT32F, length, length);
+    for (GLuint texture : { m_positionTexture, m_normalTexture, m_fluxTexture, m_depthTexture }) {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    glCreateFramebuffers(1, &m_framebuffer);
+    glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0, m_positionTexture, 0);
+    glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT1, m_normalTexture, 0);
+    glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT2, m_fluxTexture, 0);
+    glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_ATTACHMENT, m_depthTexture, 0);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glNamedFramebufferDrawBuffers(m_framebuffer, 3, drawBuffers);
+}
+
+void ReflectiveShadowMap::setLight(const glm::vec3& lightPos, const glm::vec3& sceneCenter, float sceneRadius)
+{
+    const glm::vec3 toScene = sceneCenter - lightPos;
+    const float distance = glm::length(toScene);
+    // A light inside the sphere sees what it can through a 120 degree frustum
+    const float halfAngle = distance > sceneRadius ? std::asin(sceneRadius / distance) : glm::radians(60.0f);
+    const float nearPlane = std::max(distance - sceneRadius, 0.01f * sceneRadius);
+    const glm::vec3 forward = distance > 0.0f ? toScene / distance : glm::vec3(0.0f, -1.0f, 0.0f);
+    const glm::vec3 up = std::abs(forward.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    m_viewProjection = glm::perspective(2.0f * halfAngle, 1.0f, nearPlane, distance + sceneRadius) * glm::lookAt(lightPos, lightPos + forward, up);
+}
+
+void ReflectiveShadowMap::bindAndClear()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_length, m_length);
+    const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat farDepth = 1.0f;
+    for (GLint drawBuffer = 0; drawBuffer < 3; ++drawBuffer)
+        glClearBufferfv(GL_COLOR, drawBuffer, zero);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
+
+void ReflectiveShadowMap::release()
+{
+    const GLuint textures[] = { m_positionTexture, m_normalTexture, m_fluxTexture, m_depthTexture };
+    glDeleteTextures(4, textures);
+    glDeleteFramebuffers(1, &m_framebuffer);
+    m_framebuffer = m_positionTexture = m_normalTexture = m_fluxTexture = m_depthTexture = 0;
+    m_length = 0;
+}
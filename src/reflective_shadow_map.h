@@ -0,0 +1,49 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <framework/opengl_includes.h>
+
+// Reflective shadow map (Dachsbacher and Stamminger 2005) of a point light: the surfaces the light sees, rendered
+// from the light's position into a square G-buffer holding world position (RGBA32F, w = 1 marks a surface), world
+// normal (RGBA16F) and reflected flux (RGBA16F: albedo times the light's Lambert term), with a depth attachment.
+// The light looks at a bounding sphere of the scene through a perspective frustum that just contains it.
+class ReflectiveShadowMap {
+public:
+    ReflectiveShadowMap() = default;
+    ReflectiveShadowMap(const ReflectiveShadowMap&) = delete;
+    ~ReflectiveShadowMap();
+
+    ReflectiveShadowMap& operator=(const ReflectiveShadowMap&) = delete;
+
+    // (Re)allocates the attachments at length^2 texels when the length changes.
+    void resize(int length);
+    // Points the light at the sphere around sceneCenter, see viewProjection().
+    void setLight(const glm::vec3& lightPos, const glm::vec3& sceneCenter, float sceneRadius);
+    // Binds the framebuffer with all color attachments as draw buffers, sets the viewport and clears it.
+    void bindAndClear();
+
+    int length() const { return m_length; }
+    // World space to the light's clip space.
+    const glm::mat4& viewProjection() const { return m_viewProjection; }
+    GLuint framebuffer() const { return m_framebuffer; }
+    GLuint positionTexture() const { return m_positionTexture; }
+    GLuint normalTexture() const { return m_normalTexture; }
+    GLuint fluxTexture() const { return m_fluxTexture; }
+    GLuint depthTexture() const { return m_depthTexture; }
+
+private:
+    void release();
+
+private:
+    int m_length { 0 };
+    glm::mat4 m_viewProjection { 1.0f };
+    GLuint m_framebuffer { 0 };
+    GLuint m_positionTexture { 0 };
+    GLuint m_normalTexture { 0 };
+    GLuint m_fluxTexture { 0 };
+    GLuint m_depthTexture { 0 };
+};
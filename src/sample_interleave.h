@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+
+// Spreads the rays or cones of every pixel over frameCount consecutive frames. In each frame a pixel traces every
+// frameCount-th sample of its pattern, starting at an offset that combines its place in a 4x4 Bayer tile with the
+// frame number: neighbouring pixels trace different samples, and frameCount frames in a row trace all of them.
+struct SampleInterleave {
+    uint32_t frame { 0 };
+    int frameCount { 1 }; // 1 traces every sample each frame
+};
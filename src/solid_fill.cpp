@@ -0,0 +1,190 @@
+#include "solid_fill.h"
+#include "occupancy_volume.h"
+#include "parallel.h"
+#include <algorithm>
+#include <bit>
+#include <span>
+
+namespace {
+// Spreads the bits of seeds towards higher bit indices through the set bits of open (a Kogge-Stone occluded fill).
+// seeds must be a subset of open.
+uint64_t fillUp(uint64_t seeds, uint64_t open)
+{
+    seeds |= open & (seeds << 1);
+    open &= open << 1;
+    seeds |= open & (seeds << 2);
+    open &= open << 2;
+    seeds |= open & (seeds << 4);
+    open &= open << 4;
+    seeds |= open & (seeds << 8);
+    open &= open << 8;
+    seeds |= open & (seeds << 16);
+    open &= open << 16;
+    return seeds | (open & (seeds << 32));
+}
+
+// fillUp towards lower bit indices.
+uint64_t fillDown(uint64_t seeds, uint64_t open)
+{
+    seeds |= open & (seeds >> 1);
+    open &= open >> 1;
+    seeds |= open & (seeds >> 2);
+    open &= open >> 2;
+    seeds |= open & (seeds >> 4);
+    open &= open >> 4;
+    seeds |= open & (seeds >> 8);
+    open &= open >> 8;
+    seeds |= open & (seeds >> 16);
+    open &= open >> 16;
+    return seeds | (open & (seeds >> 32));
+}
+
+// Fills whole runs of open bits along a row that contain a seed, carrying across word boundaries.
+void fillRow(std::span<uint64_t> seeds, std::span<const uint64_t> open)
+{
+    const size_t numWords = seeds.size();
+    uint64_t carry = 0;
+    for (size_t w = 0; w < numWords; ++w) {
+        seeds[w] = fillUp(seeds[w] | (carry & open[w]), open[w]);
+        carry = seeds[w] >> 63;
+    }
+    carry = 0;
+    for (size_t w = numWords; w-- > 0;) {
+        seeds[w] = fillDown(seeds[w] | ((carry << 63) & open[w]), open[w]);
+        carry = seeds[w] & 1;
+    }
+}
+}
+
+SolidFiller::SolidFiller(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+size_t SolidFiller::fill(OccupancyVolume& occupancy)
+{
+    m_rounds = 0;
+    const int gridLength = occupancy.gridLength();
+    const size_t numWords = size_t(occupancy.wordsPerRow());
+    if (gridLength == 0)
+        return 0;
+    const std::span<uint64_t> words = occupancy.words();
+    const size_t planeWords = size_t(gridLength) * numWords;
+    // Bits past the end of a row are not voxels and never open.
+    const uint64_t lastWordMask = gridLength % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (gridLength % 64)) - 1;
+    const auto openWord = [&](size_t index) {
+        const uint64_t open = ~words[index];
+        return index % numWords == numWords - 1 ? open & lastWordMask : open;
+    };
+
+    // Seeds: the empty voxels on the faces of the grid.
+    m_exterior.assign(words.size(), 0);
+    for (int z = 0; z < gridLength; ++z) {
+        for (int y = 0; y < gridLength; ++y) {
+            const size_t row = occupancy.rowIndex(y, z);
+            const bool borderRow = y == 0 || z == 0 || y == gridLength - 1 || z == gridLength - 1;
+            for (size_t w = 0; w < numWords; ++w) {
+                if (borderRow)
+                    m_exterior[row + w] = openWord(row + w);
+            }
+            m_exterior[row] |= openWord(row) & 1;
+            const int last = gridLength - 1;
+            const size_t lastWord = row + size_t(last / 64);
+            m_exterior[lastWord] |= openWord(lastWord) & (uint64_t(1) << (last % 64));
+        }
+    }
+
+    // Rounding the depth up can leave fewer slabs than threads (10 planes over 8 threads make 5 slabs of 2), none of
+    // them may start past the last plane.
+    const int maxSlabs = int(std::min<size_t>(m_numThreads, size_t(gridLength)));
+    const int slabDepth = (gridLength + maxSlabs - 1) / maxSlabs;
+    const unsigned numSlabs = unsigned((gridLength + slabDepth - 1) / slabDepth);
+    m_ghostPlanes.assign(2 * size_t(numSlabs) * planeWords, 0);
+    std::vector<char> dirtySlabs(numSlabs, 1);
+    // Planes next to a slab, an empty span outside the grid.
+    const auto planeBelow = [&](unsigned slab) {
+        const int z = int(slab) * slabDepth - 1;
+        return z >= 0 ? std::span<const uint64_t>(&m_exterior[occupancy.rowIndex(0, z)], planeWords) : std::span<const uint64_t>();
+    };
+    const auto planeAbove = [&](unsigned slab) {
+        const int z = (int(slab) + 1) * slabDepth;
+        return z < gridLength ? std::span<const uint64_t>(&m_exterior[occupancy.rowIndex(0, z)], planeWords) : std::span<const uint64_t>();
+    };
+
+    while (std::find(dirtySlabs.begin(), dirtySlabs.end(), 1) != dirtySlabs.end()) {
+        ++m_rounds;
+        // Planes next to every slab as they were at the start of the round.
+        for (unsigned slab = 0; slab < numSlabs; ++slab) {
+            uint64_t* ghosts = &m_ghostPlanes[2 * slab * planeWords];
+            std::fill(ghosts, ghosts + 2 * planeWords, uint64_t(0));
+            std::ranges::copy(planeBelow(slab), ghosts);
+            std::ranges::copy(planeAbove(slab), ghosts + planeWords);
+        }
+
+        parallel::forEachChunk(numSlabs, numSlabs, [&](unsigned slab, size_t, size_t) {
+            if (!dirtySlabs[slab])
+                return;
+            const int zBegin = int(slab) * slabDepth, zEnd = std::min(zBegin + slabDepth, gridLength);
+            const uint64_t* ghosts = &m_ghostPlanes[2 * slab * planeWords];
+            std::vector<uint64_t> seeds(numWords), open(numWords);
+            // Neighbouring row of (y, z) in the exterior, or in the ghost planes outside the slab.
+            const auto neighbour = [&](int y, int z, size_t w) -> uint64_t {
+                if (y < 0 || y >= gridLength || z < 0 || z >= gridLength)
+                    return 0;
+                if (z < zBegin)
+                    return ghosts[size_t(y) * numWords + w];
+                if (z >= zEnd)
+                    return ghosts[planeWords + size_t(y) * numWords + w];
+                return m_exterior[occupancy.rowIndex(y, z) + w];
+            };
+            const auto sweepRow = [&](int y, int z) {
+                const size_t index = occupancy.rowIndex(y, z);
+                bool anySeed = false;
+                for (size_t w = 0; w < numWords; ++w) {
+                    open[w] = openWord(index + w);
+                    seeds[w] = m_exterior[index + w]
+                        | (open[w] & (neighbour(y - 1, z, w) | neighbour(y + 1, z, w) | neighbour(y, z - 1, w) | neighbour(y, z + 1, w)));
+                    anySeed |= seeds[w] != 0;
+                }
+                if (!anySeed)
+                    return false;
+                fillRow(seeds, open);
+                bool changed = false;
+                for (size_t w = 0; w < numWords; ++w) {
+                    changed |= seeds[w] != m_exterior[index + w];
+                    m_exterior[index + w] = seeds[w];
+                }
+                return changed;
+            };
+
+            // Alternating sweep directions carry the fill across the slab in both directions within one pass.
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (int z = zBegin; z < zEnd; ++z) {
+                    for (int y = 0; y < gridLength; ++y)
+                        changed |= sweepRow(y, z);
+                }
+                for (int z = zEnd - 1; z >= zBegin; --z) {
+                    for (int y = gridLength - 1; y >= 0; --y)
+                        changed |= sweepRow(y, z);
+                }
+            }
+        });
+
+        // A slab is done until the planes next to it change.
+        for (unsigned slab = 0; slab < numSlabs; ++slab) {
+            const uint64_t* ghosts = &m_ghostPlanes[2 * slab * planeWords];
+            dirtySlabs[slab] = !std::ranges::equal(planeBelow(slab), std::span(ghosts, planeBelow(slab).size()))
+                || !std::ranges::equal(planeAbove(slab), std::span(ghosts + planeWords, planeAbove(slab).size()));
+        }
+    }
+
+    // Everything that is neither exterior nor already occupied is interior.
+    size_t added = 0;
+    for (size_t index = 0; index < words.size(); ++index) {
+        const uint64_t interior = openWord(index) & ~m_exterior[index];
+        added += size_t(std::popcount(interior));
+        words[index] |= interior;
+    }
+    return added;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class OccupancyVolume;
+
+// Fills the interior of a voxelized surface: every empty voxel that cannot be reached from outside the grid
+// through empty voxels (6-connected) becomes occupied. Surfaces with holes leak and stay hollow.
+//
+// The exterior is flood filled over the 64-bit occupancy words. Along x, runs of empty voxels are filled a word
+// at a time with shift-and-mask fills; along y and z the fill spreads between neighbouring rows. Every thread
+// owns a slab of z planes and sweeps it until it stops changing, reading the planes next to its slab from a copy
+// taken before each round. Rounds repeat for the slabs whose neighbouring planes changed.
+class SolidFiller {
+public:
+    // numThreads = 0 uses all hardware threads.
+    explicit SolidFiller(unsigned numThreads = 0);
+
+    // Marks the interior voxels of occupancy, returns how many were added.
+    size_t fill(OccupancyVolume& occupancy);
+
+    // Rounds of slab sweeps the last fill needed.
+    int rounds() const { return m_rounds; }
+    unsigned numThreads() const { return m_numThreads; }
+
+private:
+    unsigned m_numThreads;
+    int m_rounds { 0 };
+    std::vector<uint64_t> m_exterior;
+    std::vector<uint64_t> m_ghostPlanes; // per slab: the plane below it, then the plane above it
+};
@@ -0,0 +1,244 @@
+#include "sparse_voxel_octree.h"
+#include "morton.h"
+#include "occupancy_volume.h"
+#include "parallel.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/common.hpp>
+#include <glm/vector_relational.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace {
+bool intersectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& origin, const glm::vec3& invDirection, float& tEnter, float& tExit)
+{
+    const glm::vec3 t0 = (boxMin - origin) * invDirection;
+    const glm::vec3 t1 = (boxMax - origin) * invDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+    tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, tEnter));
+    tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tExit));
+    return tEnter <= tExit;
+}
+
+glm::ivec3 octantOffset(int octant)
+{
+    return glm::ivec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1);
+}
+}
+
+void SparseVoxelOctree::build(std::span<const glm::ivec3> occupiedPositions, int gridLength, unsigned numThreads)
+{
+    clear();
+    m_depth = 1;
+    while ((1 << m_depth) < gridLength)
+        ++m_depth;
+    if (occupiedPositions.empty())
+        return;
+    numThreads = parallel::resolveThreadCount(numThreads);
+
+    // Morton keys of all voxels, computed in parallel.
+    std::vector<uint64_t> keys(occupiedPositions.size());
+    parallel::parallelChunks(keys.size(), numThreads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            keys[i] = morton::encode21(occupiedPositions[i]);
+    });
+
+    // Bucket the keys by their top 6 bits (the first two octree levels) so that the buckets can be sorted
+    // independently; concatenating the sorted buckets gives the globally sorted key list.
+    const int bucketShift = std::max(0, 3 * m_depth - 6);
+    std::array<size_t, 65> bucketStart {};
+    for (uint64_t key : keys)
+        ++bucketStart[(key >> bucketShift) + 1];
+    for (size_t i = 1; i < bucketStart.size(); ++i)
+        bucketStart[i] += bucketStart[i - 1];
+    {
+        std::vector<uint64_t> bucketed(keys.size());
+        std::array<size_t, 65> cursor = bucketStart;
+        for (uint64_t key : keys)
+            bucketed[cursor[key >> bucketShift]++] = key;
+        keys.swap(bucketed);
+    }
+    std::atomic<size_t> nextBucket { 0 };
+    std::vector<std::thread> sorters;
+    for (unsigned t = 0; t < std::min(numThreads, 64u); ++t) {
+        sorters.emplace_back([&]() {
+            for (size_t bucket = nextBucket++; bucket < 64; bucket = nextBucket++)
+                std::sort(keys.begin() + std::ptrdiff_t(bucketStart[bucket]), keys.begin() + std::ptrdiff_t(bucketStart[bucket + 1]));
+        });
+    }
+    for (std::thread& sorter : sorters)
+        sorter.join();
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    m_voxelCount = keys.size();
+
+    // Reduce the sorted keys level by level: the parent key is the child key without its lowest octant.
+    const size_t numLevels = size_t(m_depth);
+    std::vector<std::vector<uint64_t>> levelKeys(numLevels);
+    std::vector<std::vector<uint32_t>> levelMasks(numLevels);
+    const std::vector<uint64_t>* childKeys = &keys;
+    for (int level = m_depth - 1; level >= 0; --level) {
+        std::vector<uint64_t>& parentKeys = levelKeys[size_t(level)];
+        std::vector<uint32_t>& parentMasks = levelMasks[size_t(level)];
+        for (uint64_t key : *childKeys) {
+            const uint64_t parent = key >> 3;
+            if (parentKeys.empty() || parentKeys.back() != parent) {
+                parentKeys.push_back(parent);
+                parentMasks.push_back(0);
+            }
+            parentMasks.back() |= 1u << (key & 7);
+        }
+        childKeys = &parentKeys;
+    }
+
+    // Lay out the pool breadth first. The first child of a node follows from the number of children of
+    // the nodes before it on the same level. On the deepest level firstChild is the Morton-ordered index of
+    // the node's first voxel, which can be used to look up per-voxel attributes.
+    size_t nodeCount = 0;
+    for (const std::vector<uint32_t>& masks : levelMasks)
+        nodeCount += masks.size();
+    m_nodes.resize(nodeCount);
+    size_t levelStart = 0;
+    for (int level = 0; level < m_depth; ++level) {
+        const std::vector<uint32_t>& masks = levelMasks[size_t(level)];
+        uint32_t child = level + 1 < m_depth ? uint32_t(levelStart + masks.size()) : 0;
+        for (size_t i = 0; i < masks.size(); ++i) {
+            m_nodes[levelStart + i] = Node { child, masks[i] };
+            child += uint32_t(std::popcount(masks[i]));
+        }
+        levelStart += masks.size();
+    }
+}
+
+void SparseVoxelOctree::build(const OccupancyVolume& occupancy, unsigned numThreads)
+{
+    std::vector<glm::ivec3> positions;
+    positions.reserve(occupancy.count());
+    occupancy.forEachOccupied([&](const glm::ivec3& gridPos) { positions.push_back(gridPos); });
+    build(positions, occupancy.gridLength(), numThreads);
+}
+
+void SparseVoxelOctree::clear()
+{
+    m_depth = 0;
+    m_voxelCount = 0;
+    m_nodes.clear();
+}
+
+bool SparseVoxelOctree::contains(const glm::ivec3& gridPos) const
+{
+    if (m_nodes.empty() || glm::any(glm::lessThan(gridPos, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(gridPos, glm::ivec3(gridLength()))))
+        return false;
+
+    uint32_t nodeIndex = 0;
+    for (int level = 0; level < m_depth; ++level) {
+        const int shift = m_depth - 1 - level;
+        const int octant = ((gridPos.x >> shift) & 1) | (((gridPos.y >> shift) & 1) << 1) | (((gridPos.z >> shift) & 1) << 2);
+        const Node& node = m_nodes[nodeIndex];
+        if (!(node.childMask & (1u << octant)))
+            return false;
+        nodeIndex = childIndex(node, octant);
+    }
+    return true;
+}
+
+bool SparseVoxelOctree::anyInBox(const glm::ivec3& boxMin, const glm::ivec3& boxMax) const
+{
+    if (m_nodes.empty())
+        return false;
+    return countInBox(0, 0, glm::ivec3(0), boxMin, boxMax, true) > 0;
+}
+
+size_t SparseVoxelOctree::countInBox(const glm::ivec3& boxMin, const glm::ivec3& boxMax) const
+{
+    if (m_nodes.empty())
+        return 0;
+    return countInBox(0, 0, glm::ivec3(0), boxMin, boxMax, false);
+}
+
+size_t SparseVoxelOctree::countInBox(uint32_t nodeIndex, int level, const glm::ivec3& nodeMin, const glm::ivec3& boxMin, const glm::ivec3& boxMax, bool stopAtFirst) const
+{
+    const Node& node = m_nodes[nodeIndex];
+    const int childSize = 1 << (m_depth - 1 - level);
+    size_t count = 0;
+    for (int octant = 0; octant < 8; ++octant) {
+        if (!(node.childMask & (1u << octant)))
+            continue;
+        const glm::ivec3 childMin = nodeMin + octantOffset(octant) * childSize;
+        const glm::ivec3 childMax = childMin + (childSize - 1);
+        if (glm::any(glm::greaterThan(childMin, boxMax)) || glm::any(glm::lessThan(childMax, boxMin)))
+            continue;
+        // Every stored node contains at least one voxel.
+        if (level == m_depth - 1 || (stopAtFirst && glm::all(glm::greaterThanEqual(childMin, boxMin)) && glm::all(glm::lessThanEqual(childMax, boxMax))))
+            count += 1;
+        else
+            count += countInBox(childIndex(node, octant), level + 1, childMin, boxMin, boxMax, stopAtFirst);
+        if (stopAtFirst && count > 0)
+            return count;
+    }
+    return count;
+}
+
+SparseVoxelOctree::RayHit SparseVoxelOctree::raycast(const glm::vec3& origin, const glm::vec3& direction, float tMax) const
+{
+    RayHit hit;
+    if (m_nodes.empty())
+        return hit;
+
+    // Avoid 0 * inf in the slab test for axis aligned rays.
+    glm::vec3 safeDirection = direction;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::abs(safeDirection[axis]) < 1e-20f)
+            safeDirection[axis] = std::copysign(1e-20f, safeDirection[axis]);
+    }
+    const glm::vec3 invDirection = 1.0f / safeDirection;
+
+    float tEnter = 0.0f, tExit = tMax;
+    if (!intersectBox(glm::vec3(0.0f), glm::vec3(float(gridLength())), origin, invDirection, tEnter, tExit))
+        return hit;
+    raycast(0, 0, glm::ivec3(0), origin, invDirection, tEnter, tExit, hit);
+    return hit;
+}
+
+bool SparseVoxelOctree::raycast(uint32_t nodeIndex, int level, const glm::ivec3& nodeMin, const glm::vec3& origin, const glm::vec3& invDirection, float tMin, float tMax, RayHit& hit) const
+{
+    const Node& node = m_nodes[nodeIndex];
+    const int childSize = 1 << (m_depth - 1 - level);
+
+    // Gather the intersected children and visit them front to back.
+    struct ChildHit {
+        float t;
+        int octant;
+    };
+    std::array<ChildHit, 8> children;
+    size_t numChildren = 0;
+    for (int octant = 0; octant < 8; ++octant) {
+        if (!(node.childMask & (1u << octant)))
+            continue;
+        const glm::vec3 childMin = glm::vec3(nodeMin + octantOffset(octant) * childSize);
+        float tEnter = tMin, tExit = tMax;
+        if (!intersectBox(childMin, childMin + float(childSize), origin, invDirection, tEnter, tExit))
+            continue;
+        // Insertion sort, there are at most 4 intersected children.
+        size_t i = numChildren++;
+        for (; i > 0 && children[i - 1].t > tEnter; --i)
+            children[i] = children[i - 1];
+        children[i] = ChildHit { tEnter, octant };
+    }
+
+    for (size_t i = 0; i < numChildren; ++i) {
+        const glm::ivec3 childMin = nodeMin + octantOffset(children[i].octant) * childSize;
+        if (level == m_depth - 1) {
+            hit = RayHit { true, childMin, children[i].t };
+            return true;
+        }
+        if (raycast(childIndex(node, children[i].octant), level + 1, childMin, origin, invDirection, children[i].t, tMax, hit))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,76 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class OccupancyVolume;
+
+// Sparse voxel octree over a cubic grid, built bottom-up from occupied grid positions.
+//
+// Nodes live in a single pool, stored level by level (root first) and in Morton order within a level.
+// A node only stores a child mask and the index of its first child; the children of a node are stored
+// contiguously, so child i is found at firstChild + popcount(childMask & ((1 << i) - 1)).
+// The nodes on the deepest level have voxels as children, which are described by their child mask alone.
+//
+// The octree is a query structure next to the grid, not its storage: the application voxelizes into the dense
+// OccupancyVolume at every grid length and builds the octree from it afterwards, so grids past 512^3 still take
+// gridLength^3 bits in the application.
+class SparseVoxelOctree {
+public:
+    struct Node {
+        uint32_t firstChild { 0 };
+        uint32_t childMask { 0 }; // lower 8 bits used
+    };
+
+    struct RayHit {
+        bool hit { false };
+        glm::ivec3 gridPos { 0 };
+        float t { 0.0f }; // distance along the ray in grid units (voxel side length = 1)
+    };
+
+    SparseVoxelOctree() = default;
+
+    // Builds the octree from a list of occupied grid positions in [0, gridLength)^3. Duplicates are allowed.
+    // Key generation and sorting are split over numThreads threads (0 = hardware concurrency).
+    void build(std::span<const glm::ivec3> occupiedPositions, int gridLength, unsigned numThreads = 0);
+    void build(const OccupancyVolume& occupancy, unsigned numThreads = 0);
+    void clear();
+
+    // Point query: whether the voxel at gridPos is occupied.
+    bool contains(const glm::ivec3& gridPos) const;
+    // Box query: whether any voxel in the inclusive box [boxMin, boxMax] is occupied.
+    bool anyInBox(const glm::ivec3& boxMin, const glm::ivec3& boxMax) const;
+    // Box query: number of occupied voxels in the inclusive box [boxMin, boxMax].
+    size_t countInBox(const glm::ivec3& boxMin, const glm::ivec3& boxMax) const;
+    // Ray query: first occupied voxel hit by the ray, origin and direction are in grid coordinates.
+    RayHit raycast(const glm::vec3& origin, const glm::vec3& direction, float tMax = 1e30f) const;
+
+    bool empty() const { return m_nodes.empty(); }
+    int depth() const { return m_depth; }
+    int gridLength() const { return 1 << m_depth; }
+    size_t voxelCount() const { return m_voxelCount; }
+    size_t nodeCount() const { return m_nodes.size(); }
+    size_t memoryBytes() const { return m_nodes.size() * sizeof(Node); }
+    std::span<const Node> nodes() const { return m_nodes; }
+
+private:
+    uint32_t childIndex(const Node& node, int octant) const
+    {
+        return node.firstChild + uint32_t(std::popcount(node.childMask & ((1u << octant) - 1u)));
+    }
+
+    size_t countInBox(uint32_t nodeIndex, int level, const glm::ivec3& nodeMin, const glm::ivec3& boxMin, const glm::ivec3& boxMax, bool stopAtFirst) const;
+    bool raycast(uint32_t nodeIndex, int level, const glm::ivec3& nodeMin, const glm::vec3& origin, const glm::vec3& invDirection, float tMin, float tMax, RayHit& hit) const;
+
+private:
+    int m_depth { 0 }; // number of node levels, the grid side length is 2^depth
+    size_t m_voxelCount { 0 };
+    std::vector<Node> m_nodes;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Keeps the most recent CPU time of each named pipeline stage, in the order the stages were first recorded.
+class StageTimings {
+public:
+    struct Entry {
+        std::string name;
+        double milliseconds { 0.0 };
+    };
+
+    // Measures the time until the scope object is destroyed and records it under the given name.
+    class Scope {
+    public:
+        Scope(StageTimings& timings, std::string name)
+            : m_timings(timings)
+            , m_name(std::move(name))
+            , m_start(std::chrono::steady_clock::now())
+        {
+        }
+        Scope(const Scope&) = delete;
+        ~Scope()
+        {
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+            m_timings.record(m_name, elapsed.count());
+        }
+
+    private:
+        StageTimings& m_timings;
+        std::string m_name;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    Scope measure(std::string name) { return Scope(*this, std::move(name)); }
+
+    void record(const std::string& name, double milliseconds)
+    {
+        for (Entry& entry : m_entries) {
+            if (entry.name == name) {
+                entry.milliseconds = milliseconds;
+                return;
+            }
+        }
+        m_entries.push_back(Entry { name, milliseconds });
+    }
+
+    const std::vector<Entry>& entries() const { return m_entries; }
+
+private:
+    std::vector<Entry> m_entries;
+};
@@ -0,0 +1,76 @@
+#include "temporal_accumulator.h"
+#include "g_buffer.h"
+#include "gl_compute.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/trigonometric.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+
+TemporalAccumulator::TemporalAccumulator()
+{
+    m_accumulateShader = gl_compute::buildShader("shaders/temporal_accumulate_comp.glsl");
+}
+
+TemporalAccumulator::~TemporalAccumulator()
+{
+    glDeleteTextures(GLsizei(m_colorTextures.size()), m_colorTextures.data());
+    glDeleteTextures(GLsizei(m_geometryTextures.size()), m_geometryTextures.data());
+}
+
+void TemporalAccumulator::reset()
+{
+    m_historyValid = false;
+}
+
+void TemporalAccumulator::accumulate(const GBuffer& gBuffer, GLuint samples, const glm::mat4& viewProjection, const glm::mat4& previousViewProjection, const TemporalSettings& settings)
+{
+    resize(gBuffer.width(), gBuffer.height());
+    const int previous = m_current;
+    m_current = 1 - m_current;
+
+    m_accumulateShader.bind();
+    glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(previousViewProjection));
+    glUniform1i(2, m_historyValid);
+    glUniform1f(3, float(std::max(settings.historyLength, 1)));
+    glUniform1f(4, settings.depthTolerance);
+    glUniform1f(5, std::cos(glm::radians(settings.normalTolerance)));
+    glBindTextureUnit(0, gBuffer.positionTexture());
+    glBindTextureUnit(1, gBuffer.normalTexture());
+    glBindTextureUnit(2, samples);
+    glBindTextureUnit(3, m_colorTextures[previous]);
+    glBindTextureUnit(4, m_geometryTextures[previous]);
+    glBindImageTexture(0, m_colorTextures[m_current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glBindImageTexture(1, m_geometryTextures[m_current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+
+    glDispatchCompute(gl_compute::divideRoundUp(size_t(m_width), 8), gl_compute::divideRoundUp(size_t(m_height), 8), 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    m_historyValid = true;
+}
+
+void TemporalAccumulator::resize(int width, int height)
+{
+    if (width == m_width && height == m_height)
+        return;
+    glDeleteTextures(GLsizei(m_colorTextures.size()), m_colorTextures.data());
+    glDeleteTextures(GLsizei(m_geometryTextures.size()), m_geometryTextures.data());
+    m_width = width;
+    m_height = height;
+    m_historyValid = false;
+    glCreateTextures(GL_TEXTURE_2D, GLsizei(m_colorTextures.size()), m_colorTextures.data());
+    glCreateTextures(GL_TEXTURE_2D, GLsizei(m_geometryTextures.size()), m_geometryTextures.data());
+    for (size_t i = 0; i < m_colorTextures.size(); ++i) {
+        glTextureStorage2D(m_colorTextures[i], 1, GL_RGBA16F, width, height);
+        glTextureStorage2D(m_geometryTextures[i], 1, GL_RGBA32F, width, height);
+        for (GLuint texture : { m_colorTextures[i], m_geometryTextures[i] }) {
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+    }
+}
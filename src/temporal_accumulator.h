@@ -0,0 +1,56 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/mat4x4.hpp>
+DISABLE_WARNINGS_POP()
+#include <framework/opengl_includes.h>
+#include <framework/shader.h>
+#include <array>
+
+class GBuffer;
+
+struct TemporalSettings {
+    bool enabled { true };
+    int historyLength { 16 }; // frames averaged at most, older frames fade out exponentially
+    float depthTolerance { 0.05f }; // relative difference of the view depth that still accepts history
+    float normalTolerance { 25.0f }; // angle in degrees between the normals that still accepts history
+};
+
+// Temporal accumulation of a screen space lighting signal, such as the indirect light of the GI passes.
+//
+// Every pixel of the G-buffer is reprojected into the previous frame with the previous view projection matrix.
+// The four history texels around that point are bilinearly filtered, each only when its stored view depth and
+// normal match the pixel within the tolerances, so disoccluded pixels and pixels that landed on other surfaces
+// start over. The new sample is blended in with weight 1 / n, n the number of frames the history holds plus one,
+// at most historyLength. The history, its view depth, normal and frame count are kept in two sets of textures
+// that swap every frame.
+class TemporalAccumulator {
+public:
+    TemporalAccumulator();
+    TemporalAccumulator(const TemporalAccumulator&) = delete;
+    ~TemporalAccumulator();
+
+    TemporalAccumulator& operator=(const TemporalAccumulator&) = delete;
+
+    // Drops the history, for when the signal changes entirely or frames were skipped.
+    void reset();
+    // Blends the samples (RGBA, the size of the G-buffer) into the history and writes the result to
+    // outputTexture().
+    void accumulate(const GBuffer& gBuffer, GLuint samples, const glm::mat4& viewProjection, const glm::mat4& previousViewProjection, const TemporalSettings& settings);
+
+    GLuint outputTexture() const { return m_colorTextures[m_current]; }
+
+private:
+    void resize(int width, int height);
+
+private:
+    Shader m_accumulateShader;
+
+    std::array<GLuint, 2> m_colorTextures {}; // RGBA16F accumulated signal
+    std::array<GLuint, 2> m_geometryTextures {}; // RGBA32F octahedral normal, view depth and frame count
+    int m_current { 0 };
+    bool m_historyValid { false };
+    int m_width { 0 };
+    int m_height { 0 };
+};
@@ -0,0 +1,59 @@
+#include "texel_cloud_cache.h"
+
+TexelCloudCache::TexelCloudCache(size_t budgetBytes)
+    : m_budgetBytes(budgetBytes)
+{
+}
+
+const TexelCloud* TexelCloudCache::find(const Key& key)
+{
+    const auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &it->second->texels;
+}
+
+void TexelCloudCache::insert(const Key& key, const TexelCloud& texels)
+{
+    if (const auto it = m_index.find(key); it != m_index.end()) {
+        m_memoryBytes -= it->second->texels.memoryBytes();
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+    const size_t bytes = texels.memoryBytes();
+    if (bytes > m_budgetBytes)
+        return;
+
+    evictUntil(m_budgetBytes - bytes);
+    m_entries.push_front(Entry { key, texels });
+    m_index[key] = m_entries.begin();
+    m_memoryBytes += bytes;
+}
+
+void TexelCloudCache::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    m_memoryBytes = 0;
+}
+
+void TexelCloudCache::setBudget(size_t budgetBytes)
+{
+    m_budgetBytes = budgetBytes;
+    evictUntil(budgetBytes);
+}
+
+void TexelCloudCache::evictUntil(size_t budgetBytes)
+{
+    while (m_memoryBytes > budgetBytes) {
+        const Entry& oldest = m_entries.back();
+        m_memoryBytes -= oldest.texels.memoryBytes();
+        m_index.erase(oldest.key);
+        m_entries.pop_back();
+        ++m_evictions;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "texel_compaction.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/mat4x4.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+// Least recently used cache of compacted texel clouds, so an atlas configuration that was rendered before does
+// not have to be rendered, read back and compacted again. Texel clouds are in object space, the model matrix
+// is applied when binning, so the same cloud serves every transform of a mesh. Packed voxel atlases are the
+// exception: they are quantized to the grid in world space, so their key includes the grid length and transform.
+//
+// The memory budget counts the texels and attributes of the cached clouds. Inserting evicts the least recently used clouds
+// until the new one fits, a cloud larger than the whole budget is not cached.
+class TexelCloudCache {
+public:
+    struct Key {
+        size_t meshIndex { 0 };
+        int atlasLength { 0 };
+        // Only set for conservative atlases: the GPU tests conservative coverage in floats, so a few texels differ
+        // from AtlasRasterizer. Center and jittered samples are bit-identical and share their clouds.
+        bool cpuRasterized { false };
+        int encoding { 0 }; // format of the position attachment, 0 = RGB32F, 1 = RGB16F, 2 = R32UI packed voxels
+        bool attributes { true }; // normals and albedos were read back too
+        bool conservative { false }; // conservatively rasterized, see AtlasSampling
+        int jitterPasses { 1 }; // number of jittered passes whose texels the cloud holds
+        // Only set for packed voxel atlases.
+        int gridLength { 0 };
+        glm::mat4 modelMatrix { 1.0f };
+
+        bool operator==(const Key&) const = default;
+    };
+
+    explicit TexelCloudCache(size_t budgetBytes = size_t(256) << 20);
+
+    // The cached texel cloud of key, nullptr if it is not cached. Marks the cloud as most recently used.
+    const TexelCloud* find(const Key& key);
+    // Caches a copy of texels under key, replacing an older cloud with the same key.
+    void insert(const Key& key, const TexelCloud& texels);
+    void clear();
+
+    // Evicts least recently used clouds until the cache fits in the new budget.
+    void setBudget(size_t budgetBytes);
+    size_t budget() const { return m_budgetBytes; }
+
+    size_t size() const { return m_entries.size(); }
+    size_t memoryBytes() const { return m_memoryBytes; }
+    size_t hits() const { return m_hits; }
+    size_t misses() const { return m_misses; }
+    size_t evictions() const { return m_evictions; }
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const
+        {
+            return (key.meshIndex * 0x9e3779b97f4a7c15ull) ^ (size_t(key.atlasLength) << 1) ^ size_t(key.cpuRasterized)
+                ^ (size_t(key.encoding) << 24) ^ (size_t(key.attributes) << 26) ^ (size_t(key.conservative) << 27)
+                ^ (size_t(key.jitterPasses) << 28) ^ (size_t(key.gridLength) << 40);
+        }
+    };
+    struct Entry {
+        Key key;
+        TexelCloud texels;
+    };
+
+    void evictUntil(size_t budgetBytes);
+
+private:
+    size_t m_budgetBytes;
+    size_t m_memoryBytes { 0 };
+    size_t m_hits { 0 }, m_misses { 0 }, m_evictions { 0 };
+    std::list<Entry> m_entries; // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+};
@@ -0,0 +1,214 @@
+#include "texel_compaction.h"
+#include "parallel.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/gtc/packing.hpp>
+DISABLE_WARNINGS_POP()
+#include <bit>
+#if defined(__AVX2__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace {
+constexpr size_t groupSize = 8;
+// Starting threads costs more than scanning small atlases on one thread.
+constexpr size_t minTexelsPerThread = 32 * 1024;
+
+uint32_t validMaskScalar(const glm::vec3* texels, size_t count, float invalidValue)
+{
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (texels[i] != glm::vec3(invalidValue))
+            mask |= 1u << i;
+    }
+    return mask;
+}
+
+uint32_t validMaskHalfScalar(const uint16_t* texels, size_t count, uint16_t invalidValue)
+{
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (texels[3 * i] != invalidValue || texels[3 * i + 1] != invalidValue || texels[3 * i + 2] != invalidValue)
+            mask |= 1u << i;
+    }
+    return mask;
+}
+
+uint32_t validMaskPackedScalar(const uint32_t* texels, size_t count)
+{
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; ++i)
+        mask |= (texels[i] >> 31) << i;
+    return mask;
+}
+
+float halfToFloat(uint16_t value)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(value);
+#else
+    return glm::unpackHalf1x16(value);
+#endif
+}
+
+#if defined(__AVX2__)
+// Bit 3i + k is set if component k of texel i differs, fold the components onto bit i.
+uint32_t foldComponents(uint32_t components)
+{
+    components |= (components >> 1) | (components >> 2);
+#if defined(__BMI2__)
+    return _pext_u32(components, 0x249249);
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < groupSize; ++i)
+        mask |= ((components >> (3 * i)) & 1u) << i;
+    return mask;
+#endif
+}
+
+// Compares 8 packed RGB texels (3 registers of 8 floats) against the invalid value. NEQ_UQ is true for NaN,
+// like operator!= in validMaskScalar.
+uint32_t validMask8(const glm::vec3* texels, __m256 invalidValue)
+{
+    const float* base = &texels->x;
+    const uint32_t a = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(base), invalidValue, _CMP_NEQ_UQ)));
+    const uint32_t b = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(base + 8), invalidValue, _CMP_NEQ_UQ)));
+    const uint32_t c = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(base + 16), invalidValue, _CMP_NEQ_UQ)));
+    return foldComponents(a | (b << 8) | (c << 16));
+}
+
+// validMask8 for 8 texels of 3 half floats (3 registers of 8 halves), compared bitwise.
+uint32_t validMaskHalf8(const uint16_t* texels, __m128i invalidValue)
+{
+    const __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels)), invalidValue);
+    const __m128i b = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 8)), invalidValue);
+    const __m128i c = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 16)), invalidValue);
+    // Narrow the 16-bit lanes to bytes to get one bit per component, inverted to differ instead of equal.
+    const uint32_t ab = uint32_t(_mm_movemask_epi8(_mm_packs_epi16(a, b)));
+    const uint32_t cc = uint32_t(_mm_movemask_epi8(_mm_packs_epi16(c, c))) & 0xFF;
+    return foldComponents(~(ab | (cc << 16)) & 0xFFFFFF);
+}
+
+// The valid bit is the sign bit, movemask collects it from 8 texels at once.
+uint32_t validMaskPacked8(const uint32_t* texels)
+{
+    return uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(texels)))));
+}
+#endif
+}
+
+void TexelCloud::append(const TexelCloud& other)
+{
+    positions.insert(positions.end(), other.positions.begin(), other.positions.end());
+    gridPositions.insert(gridPositions.end(), other.gridPositions.begin(), other.gridPositions.end());
+    normals.insert(normals.end(), other.normals.begin(), other.normals.end());
+    albedos.insert(albedos.end(), other.albedos.begin(), other.albedos.end());
+}
+
+TexelCompactor::TexelCompactor(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+template <typename GroupMask>
+size_t TexelCompactor::buildMasks(size_t numTexels, GroupMask&& groupMask)
+{
+    const size_t numGroups = (numTexels + groupSize - 1) / groupSize;
+    const unsigned numChunks = unsigned(std::clamp<size_t>(numTexels / minTexelsPerThread, 1, m_numThreads));
+    m_groupMasks.resize(numGroups);
+    m_chunkOffsets.assign(numChunks + 1, 0);
+
+    parallel::forEachChunk(numGroups, numChunks, [&](unsigned chunk, size_t beginGroup, size_t endGroup) {
+        size_t count = 0;
+        for (size_t group = beginGroup; group < endGroup; ++group) {
+            const uint32_t mask = groupMask(group);
+            m_groupMasks[group] = uint8_t(mask);
+            count += size_t(std::popcount(mask));
+        }
+        m_chunkOffsets[chunk + 1] = count;
+    });
+
+    // Exclusive prefix sum over the chunk counts gives every chunk its output offset.
+    for (unsigned chunk = 0; chunk < numChunks; ++chunk)
+        m_chunkOffsets[chunk + 1] += m_chunkOffsets[chunk];
+    return m_chunkOffsets[numChunks];
+}
+
+template <typename Store>
+void TexelCompactor::scatter(Store&& store) const
+{
+    const size_t numGroups = m_groupMasks.size();
+    const unsigned numChunks = unsigned(m_chunkOffsets.size() - 1);
+    // Uses the same chunk boundaries as pass 1.
+    parallel::forEachChunk(numGroups, numChunks, [&](unsigned chunk, size_t beginGroup, size_t endGroup) {
+        size_t out = m_chunkOffsets[chunk];
+        for (size_t group = beginGroup; group < endGroup; ++group) {
+            for (uint32_t mask = m_groupMasks[group]; mask; mask &= mask - 1)
+                store(out++, group * groupSize + size_t(std::countr_zero(mask)));
+        }
+    });
+}
+
+size_t TexelCompactor::compact(std::span<const glm::vec3> texels, float invalidValue, std::vector<glm::vec3>& output)
+{
+#if defined(__AVX2__)
+    const __m256 invalid = _mm256_set1_ps(invalidValue);
+#endif
+    const size_t validCount = buildMasks(texels.size(), [&](size_t group) {
+        const size_t first = group * groupSize;
+#if defined(__AVX2__)
+        // The last group may be partial and is handled by the scalar test.
+        if (first + groupSize <= texels.size())
+            return validMask8(&texels[first], invalid);
+#endif
+        return validMaskScalar(&texels[first], std::min(groupSize, texels.size() - first), invalidValue);
+    });
+    output.resize(validCount);
+    scatter([&](size_t out, size_t texel) { output[out] = texels[texel]; });
+    return validCount;
+}
+
+size_t TexelCompactor::compactHalf(std::span<const uint16_t> texels, float invalidValue, std::vector<glm::vec3>& output)
+{
+    const size_t numTexels = texels.size() / 3;
+    const uint16_t invalidHalf = glm::packHalf1x16(invalidValue);
+#if defined(__AVX2__)
+    const __m128i invalid = _mm_set1_epi16(short(invalidHalf));
+#endif
+    const size_t validCount = buildMasks(numTexels, [&](size_t group) {
+        const size_t first = group * groupSize;
+#if defined(__AVX2__)
+        if (first + groupSize <= numTexels)
+            return validMaskHalf8(&texels[3 * first], invalid);
+#endif
+        return validMaskHalfScalar(&texels[3 * first], std::min(groupSize, numTexels - first), invalidHalf);
+    });
+    output.resize(validCount);
+    scatter([&](size_t out, size_t texel) {
+        const uint16_t* half = &texels[3 * texel];
+        output[out] = glm::vec3(halfToFloat(half[0]), halfToFloat(half[1]), halfToFloat(half[2]));
+    });
+    return validCount;
+}
+
+size_t TexelCompactor::compactPacked(std::span<const uint32_t> texels, std::vector<uint32_t>& output)
+{
+    const size_t validCount = buildMasks(texels.size(), [&](size_t group) {
+        const size_t first = group * groupSize;
+#if defined(__AVX2__)
+        if (first + groupSize <= texels.size())
+            return validMaskPacked8(&texels[first]);
+#endif
+        return validMaskPackedScalar(&texels[first], std::min(groupSize, texels.size() - first));
+    });
+    output.resize(validCount);
+    scatter([&](size_t out, size_t texel) { output[out] = texels[texel] & ~packedValidBit; });
+    return validCount;
+}
+
+void TexelCompactor::compactAttribute(std::span<const uint32_t> attribute, std::vector<uint32_t>& output) const
+{
+    output.resize(m_chunkOffsets.back());
+    scatter([&](size_t out, size_t texel) { output[out] = attribute[texel]; });
+}
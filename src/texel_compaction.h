@@ -0,0 +1,69 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// The valid texels of an atlas G-buffer, in atlas order. An atlas holds either object space positions or grid
+// positions packed as in voxel_instance.h, the other vector is empty. normals and albedos are packed as in
+// voxel_attributes.h and may be empty when only positions were compacted.
+struct TexelCloud {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> gridPositions;
+    std::vector<uint32_t> normals;
+    std::vector<uint32_t> albedos;
+
+    size_t size() const { return positions.size() + gridPositions.size(); }
+    size_t memoryBytes() const { return positions.size() * sizeof(glm::vec3) + (gridPositions.size() + normals.size() + albedos.size()) * sizeof(uint32_t); }
+    // Adds the texels of another atlas of the same encoding, such as a further jittered pass over the same mesh.
+    void append(const TexelCloud& other);
+};
+
+// Stream compaction of the valid texels of an atlas readback.
+//
+// Runs in two parallel passes over contiguous chunks of the atlas: the first tests 8 packed texels at a time
+// for validity (AVX2) and stores a validity mask per group along with a count per chunk,
+// the second scatters the valid texels of each chunk to its offset in the output, given by an exclusive
+// prefix sum over the chunk counts. The output keeps the atlas order, so results do not depend on the
+// number of threads.
+class TexelCompactor {
+public:
+    // numThreads = 0 uses all hardware threads.
+    // Set in the texels of a packed voxel atlas that a triangle covers, next to the 10:10:10 grid position.
+    static constexpr uint32_t packedValidBit = 1u << 31;
+
+    explicit TexelCompactor(unsigned numThreads = 0);
+
+    // Writes the texels that differ from invalidValue in any component to output, which is resized to the
+    // number of valid texels (its capacity is reused between calls). Returns that number.
+    size_t compact(std::span<const glm::vec3> texels, float invalidValue, std::vector<glm::vec3>& output);
+    // compact for an RGB16F atlas, 3 half floats per texel. Texels are compared bitwise against invalidValue
+    // rounded to a half float and converted to floats on output.
+    size_t compactHalf(std::span<const uint16_t> texels, float invalidValue, std::vector<glm::vec3>& output);
+    // compact for an R32UI atlas of packed grid positions, keeps the texels with packedValidBit set and clears it.
+    size_t compactPacked(std::span<const uint32_t> texels, std::vector<uint32_t>& output);
+    // Compacts another attachment of the same atlas with the validity masks of the last compact call, so the
+    // output lines up with its positions.
+    void compactAttribute(std::span<const uint32_t> attribute, std::vector<uint32_t>& output) const;
+
+    unsigned numThreads() const { return m_numThreads; }
+
+private:
+    // Pass 1: stores groupMask(group) for every group of 8 texels and the output offset of every chunk.
+    // Returns the number of valid texels.
+    template <typename GroupMask>
+    size_t buildMasks(size_t numTexels, GroupMask&& groupMask);
+    // Pass 2: calls store(outputIndex, texelIndex) for every valid texel, in parallel over the chunks of pass 1.
+    template <typename Store>
+    void scatter(Store&& store) const;
+
+private:
+    unsigned m_numThreads;
+    std::vector<uint8_t> m_groupMasks; // bit i set if texel i of a group of 8 is valid
+    std::vector<size_t> m_chunkOffsets;
+};
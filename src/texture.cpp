@@ -7,21 +7,30 @@ DISABLE_WARNINGS_POP()
 
 #include <iostream>
 
+// Load image from disk to CPU memory.
+// Image class is defined in <framework/image.h>
 Texture::Texture(std::filesystem::path filePath)
+    : Texture(Image { filePath })
 {
-    // Load image from disk to CPU memory.
-    // Image class is defined in <framework/image.h>
-    Image cpuTexture { filePath };
+}
 
+Texture::Texture(const Image& cpuTexture)
+{
     // Create a texture on the GPU
     glCreateTextures(GL_TEXTURE_2D, 1, &m_texture);
 
     // Define GPU texture parameters and upload corresponding data based on number of image channels
+    // Image rows are tightly packed, GL expects them 4-byte aligned by default
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     switch (cpuTexture.channels) {
-        case 1:
+        case 1: {
             glTextureStorage2D(m_texture, 1, GL_R8, cpuTexture.width, cpuTexture.height);
             glTextureSubImage2D(m_texture, 0, 0, 0, cpuTexture.width, cpuTexture.height, GL_RED, GL_UNSIGNED_BYTE, cpuTexture.pixels.data());
+            // Grayscale, like the CPU code reads single channel images
+            const GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+            glTextureParameteriv(m_texture, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
             break;
+        }
         case 3:
             glTextureStorage2D(m_texture, 1, GL_RGB8, cpuTexture.width, cpuTexture.height);
             glTextureSubImage2D(m_texture, 0, 0, 0, cpuTexture.width, cpuTexture.height, GL_RGB, GL_UNSIGNED_BYTE, cpuTexture.pixels.data());
@@ -35,6 +44,8 @@ Texture::Texture(std::filesystem::path filePath)
             throw std::exception();
     }
 
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
     // Generate mip-maps
     glGenerateTextureMipmap(m_texture);
 
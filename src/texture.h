@@ -7,6 +7,8 @@ DISABLE_WARNINGS_POP()
 #include <filesystem>
 #include <framework/opengl_includes.h>
 
+struct Image;
+
 struct ImageLoadingException : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
@@ -14,6 +16,7 @@ struct ImageLoadingException : public std::runtime_error {
 class Texture {
 public:
     Texture(std::filesystem::path filePath);
+    explicit Texture(const Image& cpuTexture);
     Texture(const Texture&) = delete;
     Texture(Texture&&);
     ~Texture();
@@ -0,0 +1,158 @@
+#include "triangle_voxelizer.h"
+#include "occupancy_volume.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Projections onto the planes orthogonal to x, y and z, as (first, second) axis pairs. With the edge normals
+// rotated the same way in every projection, the triangle normal component along the dropped axis gives the winding.
+constexpr int projections[3][3] = { { 1, 2, 0 }, { 2, 0, 1 }, { 0, 1, 2 } };
+}
+
+TriangleVoxelizer::TriangleVoxelizer(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+void TriangleVoxelizer::voxelize(const Mesh& mesh, const glm::mat4& modelMatrix, const glm::vec3& worldMin, const glm::vec3& worldMax, OccupancyVolume& occupancy)
+{
+    const int gridLength = occupancy.gridLength();
+    if (gridLength == 0)
+        return;
+    m_bricksPerAxis = glm::ivec3((gridLength + brickWidth - 1) / brickWidth, (gridLength + brickLength - 1) / brickLength, (gridLength + brickLength - 1) / brickLength);
+
+    setupTriangles(mesh, modelMatrix, worldMin, worldMax, gridLength);
+    binTriangles();
+
+    const size_t numBricks = size_t(m_bricksPerAxis.x) * size_t(m_bricksPerAxis.y) * size_t(m_bricksPerAxis.z);
+    parallel::forEachChunk(numBricks, unsigned(std::min<size_t>(m_numThreads, numBricks)), [&](unsigned, size_t begin, size_t end) {
+        for (size_t brick = begin; brick < end; ++brick) {
+            const int x = int(brick % size_t(m_bricksPerAxis.x));
+            const int y = int(brick / size_t(m_bricksPerAxis.x) % size_t(m_bricksPerAxis.y));
+            const int z = int(brick / (size_t(m_bricksPerAxis.x) * size_t(m_bricksPerAxis.y)));
+            voxelizeBrick(glm::ivec3(x, y, z), occupancy);
+        }
+    });
+}
+
+void TriangleVoxelizer::setupTriangles(const Mesh& mesh, const glm::mat4& modelMatrix, const glm::vec3& worldMin, const glm::vec3& worldMax, int gridLength)
+{
+    const glm::vec3 toGrid = float(gridLength) / (worldMax - worldMin);
+    const size_t numTriangles = mesh.triangles.size();
+    const unsigned numChunks = unsigned(std::clamp<size_t>(numTriangles / 1024, 1, m_numThreads));
+    std::vector<std::vector<Triangle>> chunkTriangles(numChunks);
+
+    parallel::forEachChunk(numTriangles, numChunks, [&](unsigned chunk, size_t begin, size_t end) {
+        std::vector<Triangle>& triangles = chunkTriangles[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec3 v[3];
+            for (int k = 0; k < 3; ++k) {
+                const glm::vec3 worldPos = glm::vec3(modelMatrix * glm::vec4(mesh.vertices[mesh.triangles[i][k]].position, 1.0f));
+                v[k] = (worldPos - worldMin) * toGrid;
+            }
+
+            Triangle triangle;
+            const glm::vec3 lower = glm::min(v[0], glm::min(v[1], v[2]));
+            const glm::vec3 upper = glm::max(v[0], glm::max(v[1], v[2]));
+            // Like worldToGridPosition, a point on a voxel face belongs to the voxel above it.
+            triangle.minVoxel = glm::max(glm::ivec3(glm::floor(lower)), glm::ivec3(0));
+            triangle.maxVoxel = glm::min(glm::ivec3(glm::floor(upper)), glm::ivec3(gridLength - 1));
+            if (glm::any(glm::greaterThan(triangle.minVoxel, triangle.maxVoxel)))
+                continue;
+
+            const glm::vec3 edges[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+            triangle.normal = glm::cross(edges[0], -edges[2]);
+            // Zero area triangles have no plane to test against, and the atlas does not rasterize them either.
+            if (triangle.normal == glm::vec3(0.0f))
+                continue;
+
+            // The box corner furthest along the normal and the one furthest against it.
+            const glm::vec3 critical = glm::vec3(glm::greaterThan(triangle.normal, glm::vec3(0.0f)));
+            triangle.planeMin = glm::dot(triangle.normal, critical - v[0]);
+            triangle.planeMax = glm::dot(triangle.normal, (1.0f - critical) - v[0]);
+
+            for (int p = 0; p < 3; ++p) {
+                const int a = projections[p][0], b = projections[p][1], dropped = projections[p][2];
+                const float winding = triangle.normal[dropped] >= 0.0f ? 1.0f : -1.0f;
+                for (int k = 0; k < 3; ++k) {
+                    const glm::vec2 normal = glm::vec2(-edges[k][b], edges[k][a]) * winding;
+                    triangle.edgeNormals[p][k] = normal;
+                    // Measured at the box corner furthest along the edge normal.
+                    triangle.edgeDistances[p][k] = -glm::dot(normal, glm::vec2(v[k][a], v[k][b]))
+                        + std::max(0.0f, normal.x) + std::max(0.0f, normal.y);
+                }
+            }
+            triangles.push_back(triangle);
+        }
+    });
+
+    m_triangles.clear();
+    for (const std::vector<Triangle>& triangles : chunkTriangles)
+        m_triangles.insert(m_triangles.end(), triangles.begin(), triangles.end());
+}
+
+void TriangleVoxelizer::binTriangles()
+{
+    const size_t numBricks = size_t(m_bricksPerAxis.x) * size_t(m_bricksPerAxis.y) * size_t(m_bricksPerAxis.z);
+    const unsigned numChunks = unsigned(std::clamp<size_t>(m_triangles.size() / 1024, 1, m_numThreads));
+    m_bins.resize(numChunks);
+    parallel::forEachChunk(m_triangles.size(), numChunks, [&](unsigned chunk, size_t begin, size_t end) {
+        std::vector<std::vector<uint32_t>>& bins = m_bins[chunk];
+        bins.resize(numBricks);
+        for (std::vector<uint32_t>& bin : bins)
+            bin.clear();
+        const glm::ivec3 brickSize(brickWidth, brickLength, brickLength);
+        for (size_t i = begin; i < end; ++i) {
+            const glm::ivec3 first = m_triangles[i].minVoxel / brickSize;
+            const glm::ivec3 last = m_triangles[i].maxVoxel / brickSize;
+            for (int z = first.z; z <= last.z; ++z) {
+                for (int y = first.y; y <= last.y; ++y) {
+                    for (int x = first.x; x <= last.x; ++x)
+                        bins[(size_t(z) * size_t(m_bricksPerAxis.y) + size_t(y)) * size_t(m_bricksPerAxis.x) + size_t(x)].push_back(uint32_t(i));
+                }
+            }
+        }
+    });
+}
+
+void TriangleVoxelizer::voxelizeBrick(const glm::ivec3& brick, OccupancyVolume& occupancy) const
+{
+    const size_t brickIndex = (size_t(brick.z) * size_t(m_bricksPerAxis.y) + size_t(brick.y)) * size_t(m_bricksPerAxis.x) + size_t(brick.x);
+    const glm::ivec3 brickMin = brick * glm::ivec3(brickWidth, brickLength, brickLength);
+    const glm::ivec3 brickMax = glm::min(brickMin + glm::ivec3(brickWidth, brickLength, brickLength), glm::ivec3(occupancy.gridLength())) - 1;
+    uint64_t* words = occupancy.words().data();
+
+    const auto insideEdges = [](const Triangle& triangle, int projection, float a, float b) {
+        for (int k = 0; k < 3; ++k) {
+            if (glm::dot(triangle.edgeNormals[projection][k], glm::vec2(a, b)) + triangle.edgeDistances[projection][k] < 0.0f)
+                return false;
+        }
+        return true;
+    };
+
+    for (const std::vector<std::vector<uint32_t>>& bins : m_bins) {
+        for (uint32_t index : bins[brickIndex]) {
+            const Triangle& triangle = m_triangles[index];
+            const glm::ivec3 minVoxel = glm::max(triangle.minVoxel, brickMin);
+            const glm::ivec3 maxVoxel = glm::min(triangle.maxVoxel, brickMax);
+            for (int z = minVoxel.z; z <= maxVoxel.z; ++z) {
+                for (int y = minVoxel.y; y <= maxVoxel.y; ++y) {
+                    // The yz projection is the same for the whole row.
+                    if (!insideEdges(triangle, 0, float(y), float(z)))
+                        continue;
+                    uint64_t row = 0;
+                    for (int x = minVoxel.x; x <= maxVoxel.x; ++x) {
+                        const glm::vec3 corner = glm::vec3(x, y, z);
+                        const float plane = glm::dot(triangle.normal, corner);
+                        if ((plane + triangle.planeMin) * (plane + triangle.planeMax) > 0.0f)
+                            continue;
+                        if (insideEdges(triangle, 1, float(z), float(x)) && insideEdges(triangle, 2, float(x), float(y)))
+                            row |= uint64_t(1) << (x - brickMin.x);
+                    }
+                    words[occupancy.rowIndex(y, z) + size_t(brickMin.x / 64)] |= row;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <framework/mesh.h>
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class OccupancyVolume;
+
+// Voxelizes triangles directly, without an atlas: a voxel is occupied if its box overlaps a triangle. The
+// overlap test is the separating axis test of a triangle against a box (Akenine-Moeller), in the form of
+// Schwarz and Seidel: the triangle plane against the box corners and the triangle edges against the box in
+// the three axis projections. Unlike the atlas, every voxel a triangle touches is found, however the mesh is
+// unwrapped.
+//
+// Triangles are binned into bricks of 64x8x8 voxels, each row of a brick being one occupancy word, and bricks
+// are voxelized in parallel. No two threads write the same word, so no atomics are needed.
+class TriangleVoxelizer {
+public:
+    static constexpr int brickWidth = 64;
+    static constexpr int brickLength = 8; // along y and z
+
+    // numThreads = 0 uses all hardware threads.
+    explicit TriangleVoxelizer(unsigned numThreads = 0);
+
+    // Marks the voxels of occupancy that overlap a triangle of mesh transformed by modelMatrix. The grid spans
+    // [worldMin, worldMax], parts of triangles outside it are dropped. Voxels already set stay set.
+    void voxelize(const Mesh& mesh, const glm::mat4& modelMatrix, const glm::vec3& worldMin, const glm::vec3& worldMax, OccupancyVolume& occupancy);
+
+    // Triangles of the last mesh that have an area and overlap the grid.
+    size_t binnedTriangleCount() const { return m_triangles.size(); }
+    unsigned numThreads() const { return m_numThreads; }
+
+private:
+    // Overlap test setup in grid units, where voxel p covers [p, p + 1].
+    struct Triangle {
+        glm::vec3 normal;
+        float planeMin, planeMax; // normal . p + planeMin and + planeMax have different signs for overlapping boxes
+        glm::vec2 edgeNormals[3][3]; // per projection (yz, zx, xy) and edge, inside where normal . p + distance >= 0
+        float edgeDistances[3][3];
+        glm::ivec3 minVoxel, maxVoxel; // inclusive, clamped to the grid
+    };
+
+    void setupTriangles(const Mesh& mesh, const glm::mat4& modelMatrix, const glm::vec3& worldMin, const glm::vec3& worldMax, int gridLength);
+    void binTriangles();
+    void voxelizeBrick(const glm::ivec3& brick, OccupancyVolume& occupancy) const;
+
+private:
+    unsigned m_numThreads;
+    glm::ivec3 m_bricksPerAxis { 0 };
+    std::vector<Triangle> m_triangles;
+    // Triangle indices per (chunk of triangles, brick).
+    std::vector<std::vector<std::vector<uint32_t>>> m_bins;
+};
@@ -0,0 +1,439 @@
+#include "uv_unwrapper.h"
+#include "parallel.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+namespace {
+constexpr uint32_t unassigned = std::numeric_limits<uint32_t>::max();
+
+float cross2(const glm::vec2& a, const glm::vec2& b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+// Convex hull of points, counter-clockwise (Andrew's monotone chain). Reorders points.
+std::vector<glm::vec2> convexHull(std::vector<glm::vec2>& points)
+{
+    std::sort(points.begin(), points.end(), [](const glm::vec2& a, const glm::vec2& b) { return std::tie(a.x, a.y) < std::tie(b.x, b.y); });
+    if (points.size() < 3)
+        return points;
+    std::vector<glm::vec2> hull(2 * points.size());
+    size_t count = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        while (count >= 2 && cross2(hull[count - 1] - hull[count - 2], points[i] - hull[count - 2]) <= 0.0f)
+            --count;
+        hull[count++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = count + 1; i-- > 0;) {
+        while (count >= lower && cross2(hull[count - 1] - hull[count - 2], points[i] - hull[count - 2]) <= 0.0f)
+            --count;
+        hull[count++] = points[i];
+    }
+    hull.resize(count - 1);
+    return hull;
+}
+
+// A quarter turns counter-clockwise of the point uv of a chart's bounding rectangle of size, kept in the positive quadrant.
+glm::vec2 orient(const glm::vec2& uv, const glm::vec2& size, int rotation)
+{
+    switch (rotation) {
+    case 1:
+        return glm::vec2(size.y - uv.y, uv.x);
+    case 2:
+        return size - uv;
+    case 3:
+        return glm::vec2(uv.y, size.x - uv.x);
+    default:
+        return uv;
+    }
+}
+
+// Grows [lower, upper] by the y range of triangle abc over the slab x0 <= x <= x1. A convex polygon takes its extremes at
+// its vertices or where its edges cross the slab's sides.
+void addSlabRange(const glm::vec2 (&corners)[3], float x0, float x1, float& lower, float& upper)
+{
+    for (int k = 0; k < 3; ++k) {
+        const glm::vec2& p = corners[k];
+        const glm::vec2& q = corners[(k + 1) % 3];
+        if (p.x >= x0 && p.x <= x1) {
+            lower = std::min(lower, p.y);
+            upper = std::max(upper, p.y);
+        }
+        for (float x : { x0, x1 }) {
+            if ((p.x < x && q.x > x) || (q.x < x && p.x > x)) {
+                const float y = p.y + (x - p.x) * (q.y - p.y) / (q.x - p.x);
+                lower = std::min(lower, y);
+                upper = std::max(upper, y);
+            }
+        }
+    }
+}
+}
+
+UvUnwrapper::UvUnwrapper(unsigned numThreads)
+    : m_numThreads(parallel::resolveThreadCount(numThreads))
+{
+}
+
+bool UvUnwrapper::needsUnwrap(const Mesh& mesh)
+{
+    double worldArea = 0.0, unmappedArea = 0.0, uvArea = 0.0;
+    for (const glm::uvec3& triangle : mesh.triangles) {
+        const Vertex& v0 = mesh.vertices[triangle[0]];
+        const Vertex& v1 = mesh.vertices[triangle[1]];
+        const Vertex& v2 = mesh.vertices[triangle[2]];
+        for (const Vertex* vertex : { &v0, &v1, &v2 }) {
+            if (glm::any(glm::lessThan(vertex->texCoord, glm::vec2(0.0f))) || glm::any(glm::greaterThan(vertex->texCoord, glm::vec2(1.0f))))
+                return true;
+        }
+        const double area = 0.5 * double(glm::length(glm::cross(v1.position - v0.position, v2.position - v0.position)));
+        const double triangleUvArea = 0.5 * std::abs(double(cross2(v1.texCoord - v0.texCoord, v2.texCoord - v0.texCoord)));
+        worldArea += area;
+        uvArea += triangleUvArea;
+        if (triangleUvArea <= 1e-12)
+            unmappedArea += area;
+    }
+    return uvArea > 1.0001 || unmappedArea > 0.01 * worldArea;
+}
+
+void UvUnwrapper::unwrap(Mesh& mesh, int atlasLength, int paddingTexels)
+{
+    segment(mesh);
+    std::vector<glm::vec2> uvs(3 * mesh.triangles.size());
+    parameterize(mesh, uvs);
+
+    // Half the padding around every chart keeps neighbours paddingTexels apart.
+    const float margin = 0.5f * float(std::max(paddingTexels, 0));
+    float texelScale = 0.0f;
+    const float side = pack(uvs, std::max(atlasLength, 1), margin, texelScale);
+    const float scale = side > 0.0f ? 1.0f / side : 0.0f;
+
+    // One copy of every vertex per chart it is used in.
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    std::vector<uint32_t> copyChart(mesh.vertices.size(), unassigned), copyIndex(mesh.vertices.size());
+    m_utilization = 0.0;
+    for (uint32_t chartIndex = 0; chartIndex < m_charts.size(); ++chartIndex) {
+        const Chart& chart = m_charts[chartIndex];
+        const glm::vec2 origin = chart.offset + glm::vec2(margin, 0.0f);
+        for (uint32_t triangle : chart.triangles) {
+            glm::vec2 triangleUvs[3];
+            for (int k = 0; k < 3; ++k) {
+                const glm::vec2 uv = uvs[3 * triangle + uint32_t(k)];
+                triangleUvs[k] = (origin + orient(uv, chart.size, chart.rotation) * texelScale) * scale;
+                const uint32_t vertex = mesh.triangles[triangle][k];
+                if (copyChart[vertex] != chartIndex) {
+                    copyChart[vertex] = chartIndex;
+                    copyIndex[vertex] = uint32_t(vertices.size());
+                    vertices.push_back(mesh.vertices[vertex]);
+                    vertices.back().texCoord = glm::clamp(triangleUvs[k], glm::vec2(0.0f), glm::vec2(1.0f));
+                }
+                mesh.triangles[triangle][k] = copyIndex[vertex];
+            }
+            m_utilization += 0.5 * std::abs(double(cross2(triangleUvs[1] - triangleUvs[0], triangleUvs[2] - triangleUvs[0])));
+        }
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+void UvUnwrapper::segment(const Mesh& mesh)
+{
+    const size_t numTriangles = mesh.triangles.size();
+    m_triangleNormals.resize(numTriangles);
+    m_triangleAreas.resize(numTriangles);
+    for (size_t i = 0; i < numTriangles; ++i) {
+        const glm::uvec3& triangle = mesh.triangles[i];
+        const glm::vec3 p0 = mesh.vertices[triangle[0]].position;
+        const glm::vec3 normal = glm::cross(mesh.vertices[triangle[1]].position - p0, mesh.vertices[triangle[2]].position - p0);
+        const float length = glm::length(normal);
+        m_triangleAreas[i] = 0.5f * length;
+        m_triangleNormals[i] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+    }
+
+    // Vertices that differ only in their normal or texture coordinate share a position, weld them so that
+    // triangles across hard edges and UV seams are neighbours too.
+    std::vector<uint32_t> byPosition(mesh.vertices.size());
+    std::iota(byPosition.begin(), byPosition.end(), 0u);
+    const auto positionKey = [&](uint32_t vertex) {
+        const glm::vec3& p = mesh.vertices[vertex].position;
+        return std::tie(p.x, p.y, p.z);
+    };
+    std::sort(byPosition.begin(), byPosition.end(), [&](uint32_t a, uint32_t b) { return positionKey(a) < positionKey(b); });
+    std::vector<uint32_t> welded(mesh.vertices.size());
+    for (size_t i = 0; i < byPosition.size(); ++i)
+        welded[byPosition[i]] = i > 0 && positionKey(byPosition[i]) == positionKey(byPosition[i - 1]) ? welded[byPosition[i - 1]] : uint32_t(i);
+
+    // Triangles sharing an edge of welded positions are neighbours.
+    std::vector<std::pair<uint64_t, uint32_t>> edges;
+    edges.reserve(3 * numTriangles);
+    for (uint32_t i = 0; i < numTriangles; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = welded[mesh.triangles[i][k]], b = welded[mesh.triangles[i][(k + 1) % 3]];
+            if (a != b)
+                edges.emplace_back((uint64_t(std::min(a, b)) << 32) | std::max(a, b), i);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<std::vector<uint32_t>> neighbours(numTriangles);
+    for (size_t first = 0, last; first < edges.size(); first = last) {
+        for (last = first + 1; last < edges.size() && edges[last].first == edges[first].first; ++last) { }
+        for (size_t i = first; i < last; ++i) {
+            for (size_t j = first; j < last; ++j) {
+                if (i != j)
+                    neighbours[edges[i].second].push_back(edges[j].second);
+            }
+        }
+    }
+
+    // Grow charts from the largest triangles. Triangles without area join any chart that reaches them.
+    std::vector<uint32_t> seeds(numTriangles);
+    std::iota(seeds.begin(), seeds.end(), 0u);
+    std::stable_sort(seeds.begin(), seeds.end(), [&](uint32_t a, uint32_t b) { return m_triangleAreas[a] > m_triangleAreas[b]; });
+    const float minCosine = std::cos(glm::radians(maxChartAngle));
+    std::vector<uint32_t> chartOf(numTriangles, unassigned);
+    m_charts.clear();
+    for (uint32_t seed : seeds) {
+        if (chartOf[seed] != unassigned)
+            continue;
+        const uint32_t chartIndex = uint32_t(m_charts.size());
+        Chart& chart = m_charts.emplace_back();
+        const glm::vec3 seedNormal = m_triangleNormals[seed];
+        glm::vec3 normalSum(0.0f);
+        chartOf[seed] = chartIndex;
+        chart.triangles.push_back(seed);
+        for (size_t next = 0; next < chart.triangles.size(); ++next) {
+            const uint32_t triangle = chart.triangles[next];
+            normalSum += m_triangleNormals[triangle] * m_triangleAreas[triangle];
+            for (uint32_t neighbour : neighbours[triangle]) {
+                if (chartOf[neighbour] == unassigned && (m_triangleAreas[neighbour] == 0.0f || glm::dot(m_triangleNormals[neighbour], seedNormal) >= minCosine)) {
+                    chartOf[neighbour] = chartIndex;
+                    chart.triangles.push_back(neighbour);
+                }
+            }
+        }
+        const float length = glm::length(normalSum);
+        chart.normal = length > 0.0f ? normalSum / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+}
+
+void UvUnwrapper::parameterize(const Mesh& mesh, std::vector<glm::vec2>& uvs)
+{
+    const unsigned numChunks = unsigned(std::clamp<size_t>(m_charts.size() / 16, 1, m_numThreads));
+    parallel::forEachChunk(m_charts.size(), numChunks, [&](unsigned, size_t begin, size_t end) {
+        std::vector<glm::vec2> points;
+        for (size_t chartIndex = begin; chartIndex < end; ++chartIndex) {
+            Chart& chart = m_charts[chartIndex];
+            // The averaged normal can tilt past a triangle at the rim of a strongly curved chart, the seed's normal
+            // is within maxChartAngle of all of them.
+            glm::vec3 axis = chart.normal;
+            for (uint32_t triangle : chart.triangles) {
+                if (m_triangleAreas[triangle] > 0.0f && glm::dot(m_triangleNormals[triangle], axis) <= 0.0f) {
+                    axis = m_triangleAreas[chart.triangles[0]] > 0.0f ? m_triangleNormals[chart.triangles[0]] : chart.normal;
+                    break;
+                }
+            }
+            const glm::vec3 tangent = glm::normalize(glm::cross(axis, std::abs(axis.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f)));
+            const glm::vec3 bitangent = glm::cross(axis, tangent);
+
+            points.clear();
+            for (uint32_t triangle : chart.triangles) {
+                for (int k = 0; k < 3; ++k) {
+                    const glm::vec3& position = mesh.vertices[mesh.triangles[triangle][k]].position;
+                    uvs[3 * triangle + uint32_t(k)] = glm::vec2(glm::dot(position, tangent), glm::dot(position, bitangent));
+                    points.push_back(uvs[3 * triangle + uint32_t(k)]);
+                }
+            }
+
+            // The minimum area bounding rectangle has a side along an edge of the convex hull.
+            const std::vector<glm::vec2> hull = convexHull(points);
+            glm::vec2 direction(1.0f, 0.0f);
+            float bestArea = std::numeric_limits<float>::max();
+            for (size_t i = 0; i < hull.size() && hull.size() >= 3; ++i) {
+                const glm::vec2 edge = hull[(i + 1) % hull.size()] - hull[i];
+                const float length = glm::length(edge);
+                if (length == 0.0f)
+                    continue;
+                const glm::vec2 u = edge / length, v(-u.y, u.x);
+                glm::vec2 lower(std::numeric_limits<float>::max()), upper(std::numeric_limits<float>::lowest());
+                for (const glm::vec2& point : hull) {
+                    const glm::vec2 rotated(glm::dot(point, u), glm::dot(point, v));
+                    lower = glm::min(lower, rotated);
+                    upper = glm::max(upper, rotated);
+                }
+                const float area = (upper.x - lower.x) * (upper.y - lower.y);
+                if (area < bestArea) {
+                    bestArea = area;
+                    direction = u;
+                }
+            }
+
+            const glm::vec2 perpendicular(-direction.y, direction.x);
+            glm::vec2 lower(std::numeric_limits<float>::max()), upper(std::numeric_limits<float>::lowest());
+            for (uint32_t triangle : chart.triangles) {
+                for (int k = 0; k < 3; ++k) {
+                    glm::vec2& uv = uvs[3 * triangle + uint32_t(k)];
+                    uv = glm::vec2(glm::dot(uv, direction), glm::dot(uv, perpendicular));
+                    lower = glm::min(lower, uv);
+                    upper = glm::max(upper, uv);
+                }
+            }
+            for (uint32_t triangle : chart.triangles) {
+                for (int k = 0; k < 3; ++k)
+                    uvs[3 * triangle + uint32_t(k)] -= lower;
+            }
+            chart.size = upper - lower;
+        }
+    });
+}
+
+float UvUnwrapper::pack(const std::vector<glm::vec2>& uvs, int atlasLength, float margin, float& texelScale)
+{
+    texelScale = 0.0f;
+    if (m_charts.empty())
+        return 0.0f;
+    // Long charts first, then by area.
+    std::vector<uint32_t> order(m_charts.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const glm::vec2 sizeA = m_charts[a].size, sizeB = m_charts[b].size;
+        const float longA = std::max(sizeA.x, sizeA.y), longB = std::max(sizeB.x, sizeB.y);
+        return longA != longB ? longA > longB : sizeA.x * sizeA.y > sizeB.x * sizeB.y;
+    });
+
+    // Start at the density where the bounding rectangles would fill 80% of the atlas. The packed area grows with the
+    // square of the density, which gives the next guess, and the densities that fit and that do not bracket the search.
+    double rectangleArea = 0.0;
+    for (const Chart& chart : m_charts)
+        rectangleArea += double(chart.size.x) * double(chart.size.y);
+    const float length = float(atlasLength);
+    float scale = rectangleArea > 0.0 ? length / float(std::sqrt(rectangleArea / 0.8)) : 1.0f;
+    float fits = 0.0f, overflows = std::numeric_limits<float>::infinity();
+    float bestHeight = std::numeric_limits<float>::infinity(), bestWidth = 0.0f;
+    std::vector<Profile> profiles;
+    std::vector<Placement> placed, bestPlaced;
+    for (int iteration = 0; iteration < 12 && overflows > fits * 1.01f; ++iteration) {
+        buildProfiles(uvs, scale, margin, profiles);
+        const float height = packProfiles(profiles, order, atlasLength, placed);
+        // Without a density that fits (the padding alone can overflow a small atlas), keep the lowest layout.
+        if (height <= length || (fits == 0.0f && height < bestHeight)) {
+            bestHeight = height;
+            bestWidth = 0.0f;
+            for (size_t i = 0; i < placed.size(); ++i)
+                bestWidth = std::max(bestWidth, placed[i].offset.x + float(profiles[4 * i + size_t(placed[i].rotation)].bottom.size()));
+            texelScale = scale;
+            std::swap(bestPlaced, placed);
+        }
+        if (height <= length)
+            fits = scale;
+        else
+            overflows = scale;
+        scale = std::isinf(height) ? 0.5f * scale : scale * std::sqrt(length / height);
+        if (fits > 0.0f && !(scale > fits * 1.001f && scale < overflows * 0.999f))
+            scale = std::isinf(overflows) ? 1.1f * fits : std::sqrt(fits * overflows);
+    }
+
+    // The padding alone is wider than the atlas, every chart lands on the origin.
+    if (bestPlaced.empty()) {
+        texelScale = 0.0f;
+        bestPlaced.assign(m_charts.size(), Placement { glm::vec2(0.0f), 0 });
+        bestWidth = bestHeight = 0.0f;
+    }
+    for (size_t i = 0; i < m_charts.size(); ++i) {
+        m_charts[i].offset = bestPlaced[i].offset;
+        m_charts[i].rotation = bestPlaced[i].rotation;
+    }
+    return std::max(bestWidth, bestHeight);
+}
+
+void UvUnwrapper::buildProfiles(const std::vector<glm::vec2>& uvs, float texelScale, float margin, std::vector<Profile>& profiles) const
+{
+    profiles.resize(4 * m_charts.size());
+    const unsigned numChunks = unsigned(std::clamp<size_t>(m_charts.size() / 16, 1, m_numThreads));
+    parallel::forEachChunk(m_charts.size(), numChunks, [&](unsigned, size_t begin, size_t end) {
+        for (size_t chartIndex = begin; chartIndex < end; ++chartIndex) {
+            const Chart& chart = m_charts[chartIndex];
+            for (int rotation = 0; rotation < 4; ++rotation) {
+                Profile& profile = profiles[4 * chartIndex + size_t(rotation)];
+                const float width = texelScale * (rotation % 2 ? chart.size.y : chart.size.x);
+                const size_t numColumns = size_t(std::max(std::ceil(width + 2.0f * margin), 1.0f));
+                profile.bottom.assign(numColumns, std::numeric_limits<float>::infinity());
+                profile.top.assign(numColumns, -std::numeric_limits<float>::infinity());
+                // Column c holds x in [c - margin, c + 1 - margin) of the chart, the points within margin of it
+                // (in both axes) are the ones in [c - 2 margin, c + 1].
+                for (uint32_t triangle : chart.triangles) {
+                    glm::vec2 corners[3];
+                    for (int k = 0; k < 3; ++k)
+                        corners[k] = orient(uvs[3 * triangle + uint32_t(k)], chart.size, rotation) * texelScale;
+                    const float minX = std::min({ corners[0].x, corners[1].x, corners[2].x });
+                    const float maxX = std::max({ corners[0].x, corners[1].x, corners[2].x });
+                    const size_t first = size_t(std::max(std::ceil(minX - 1.0f), 0.0f));
+                    const size_t last = std::min(numColumns - 1, size_t(std::max(std::floor(maxX + 2.0f * margin), 0.0f)));
+                    for (size_t column = first; column <= last; ++column)
+                        addSlabRange(corners, float(column) - 2.0f * margin, float(column) + 1.0f, profile.bottom[column], profile.top[column]);
+                }
+                profile.height = 0.0f;
+                for (size_t column = 0; column < numColumns; ++column) {
+                    profile.bottom[column] -= margin;
+                    profile.top[column] += margin;
+                    profile.height = std::max(profile.height, profile.top[column]);
+                }
+            }
+        }
+    });
+}
+
+float UvUnwrapper::packProfiles(const std::vector<Profile>& profiles, const std::vector<uint32_t>& order, int numColumns, std::vector<Placement>& placed)
+{
+    placed.assign(profiles.size() / 4, Placement {});
+    std::vector<float> horizon(size_t(numColumns), 0.0f);
+    float height = 0.0f;
+    for (uint32_t index : order) {
+        // The position that wastes the least area between the horizon and the chart, then the lowest one.
+        float bestTop = std::numeric_limits<float>::infinity(), bestWaste = 0.0f, bestY = 0.0f;
+        size_t bestX = 0;
+        int bestRotation = -1;
+        for (int rotation = 0; rotation < 4; ++rotation) {
+            const Profile& profile = profiles[4 * index + uint32_t(rotation)];
+            const size_t width = profile.bottom.size();
+            for (size_t x = 0; x + width <= horizon.size(); ++x) {
+                // Columns past the best top found so far cannot win.
+                float y = 0.0f;
+                const float maxY = bestTop - profile.height;
+                for (size_t i = 0; i < width && y <= maxY; ++i)
+                    y = std::max(y, horizon[x + i] - profile.bottom[i]);
+                if (y > maxY)
+                    continue;
+                float waste = 0.0f;
+                for (size_t i = 0; i < width; ++i) {
+                    if (profile.bottom[i] < profile.top[i])
+                        waste += y + profile.bottom[i] - horizon[x + i];
+                }
+                const float top = y + profile.height;
+                if (top < bestTop || (top == bestTop && waste < bestWaste)) {
+                    bestWaste = waste;
+                    bestTop = top;
+                    bestX = x;
+                    bestY = y;
+                    bestRotation = rotation;
+                }
+            }
+        }
+        if (bestRotation < 0)
+            return std::numeric_limits<float>::infinity();
+        placed[index] = { glm::vec2(float(bestX), bestY), bestRotation };
+        height = std::max(height, bestTop);
+        const Profile& profile = profiles[4 * index + uint32_t(bestRotation)];
+        for (size_t i = 0; i < profile.top.size(); ++i)
+            horizon[bestX + i] = std::max(horizon[bestX + i], bestY + profile.top[i]);
+    }
+    return height;
+}
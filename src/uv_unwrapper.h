@@ -0,0 +1,86 @@
+#pragma once
+#include <framework/mesh.h>
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Generates a lightmap-style UV layout for meshes whose texture coordinates the atlas cannot use: missing ones
+// (loadMesh sets them to 0, so the whole mesh lands on one texel), or layouts that overlap or leave [0, 1].
+//
+// Triangles are segmented into charts by normal clustering: charts grow from the largest unassigned triangle over
+// shared edges (of welded positions) to the triangles whose normal is within maxChartAngle of the seed's. Every
+// chart is projected onto the plane orthogonal to its area-weighted normal, which keeps every triangle's
+// orientation, so neighbouring triangles never fold over each other (charts that wind around, like a spiral ramp,
+// can still overlap themselves). The projection is rotated to the minimum area bounding rectangle of the chart's
+// convex hull. Charts are packed by their shape rather than their rectangle, in texels of the target atlas: every chart
+// is reduced to the lowest and highest point of each texel column it covers, grown by half the padding, and dropped
+// Tetris-like onto the horizon of the charts packed before it, trying its four quarter turns and every column. Concave
+// charts nest into each other this way, which the bounding rectangles (about half empty) would not allow. The texel
+// density is searched for the largest one whose layout fits the atlas. All charts keep the same texel density, world
+// units map uniformly to UV.
+//
+// Vertices on chart borders are split, one copy per chart. Charts are parameterized in parallel.
+class UvUnwrapper {
+public:
+    static constexpr float maxChartAngle = 30.0f; // degrees between a chart's seed normal and its other triangles
+
+    // numThreads = 0 uses all hardware threads.
+    explicit UvUnwrapper(unsigned numThreads = 0);
+
+    // True if the texture coordinates of mesh leave [0, 1], overlap (their UV area exceeds the square), or more than
+    // 1% of the surface lies on triangles without UV area.
+    static bool needsUnwrap(const Mesh& mesh);
+
+    // Replaces the texture coordinates of mesh with a packed chart layout in [0, 1]^2, splitting the vertices on chart
+    // borders. Charts are kept at least paddingTexels apart, and half of that from the border, at atlasLength.
+    void unwrap(Mesh& mesh, int atlasLength = 1024, int paddingTexels = 1);
+
+    size_t chartCount() const { return m_charts.size(); }
+    // Fraction of the UV square covered by triangles after the last unwrap.
+    double utilization() const { return m_utilization; }
+    unsigned numThreads() const { return m_numThreads; }
+
+private:
+    struct Chart {
+        std::vector<uint32_t> triangles;
+        glm::vec3 normal; // area-weighted, the projection axis
+        glm::vec2 size; // bounding rectangle after rotation, in world units, without padding
+        glm::vec2 offset; // position of the chart's profile in the packed layout, in texels
+        int rotation; // quarter turns counter-clockwise
+    };
+    // A chart in one orientation at one texel density: the extent of the chart grown by the padding margin over each of
+    // its texel columns, relative to the bottom of its rotated bounding rectangle.
+    struct Profile {
+        std::vector<float> bottom;
+        std::vector<float> top;
+        float height; // largest top
+    };
+    struct Placement {
+        glm::vec2 offset;
+        int rotation;
+    };
+
+    void segment(const Mesh& mesh);
+    // Projects and rotates every chart, writes the corner coordinates of its triangles (3 per triangle) to uvs.
+    void parameterize(const Mesh& mesh, std::vector<glm::vec2>& uvs);
+    // Packs the charts into an atlasLength^2 atlas with the largest texel density found, sets texelScale to it (texels
+    // per world unit) and returns the side of the packed layout in texels.
+    float pack(const std::vector<glm::vec2>& uvs, int atlasLength, float margin, float& texelScale);
+    void buildProfiles(const std::vector<glm::vec2>& uvs, float texelScale, float margin, std::vector<Profile>& profiles) const;
+    // Drops the charts (profiles holds 4 orientations per chart) in order onto a horizon numColumns wide, returns the
+    // height of the layout, or infinity if a chart is wider than the atlas in every orientation.
+    static float packProfiles(const std::vector<Profile>& profiles, const std::vector<uint32_t>& order, int numColumns, std::vector<Placement>& placed);
+
+private:
+    unsigned m_numThreads;
+    std::vector<Chart> m_charts;
+    std::vector<glm::vec3> m_triangleNormals; // unit face normals, zero for triangles without area
+    std::vector<float> m_triangleAreas;
+    double m_utilization { 0.0 };
+};
@@ -0,0 +1,64 @@
+#include "voxel_attributes.h"
+
+void VoxelAttributes::reset(const OccupancyVolume& occupancy)
+{
+    m_occupancy = &occupancy;
+    const std::span<const uint64_t> words = occupancy.words();
+    m_wordRanks.resize(words.size());
+    uint32_t rank = 0;
+    for (size_t i = 0; i < words.size(); ++i) {
+        m_wordRanks[i] = rank;
+        rank += uint32_t(std::popcount(words[i]));
+    }
+    m_normalSums.assign(rank, glm::vec3(0.0f));
+    m_albedoSums.assign(rank, glm::vec4(0.0f));
+}
+
+void VoxelAttributes::clear()
+{
+    m_occupancy = nullptr;
+    m_wordRanks.clear();
+    m_normalSums.clear();
+    m_albedoSums.clear();
+}
+
+void VoxelAttributes::add(const glm::ivec3& gridPos, const glm::vec3& normal, const glm::vec3& albedo)
+{
+    const size_t index = rank(gridPos);
+    m_normalSums[index] += normal;
+    m_albedoSums[index] += glm::vec4(albedo, 1.0f);
+}
+
+void VoxelAttributes::addFiner(const VoxelAttributes& finer, int levels)
+{
+    if (!m_occupancy || !finer.m_occupancy)
+        return;
+    size_t finerIndex = 0;
+    // forEachOccupied walks the voxels in row order, which is rank order.
+    finer.m_occupancy->forEachOccupied([&](const glm::ivec3& gridPos) {
+        const size_t index = rank(gridPos >> levels);
+        m_normalSums[index] += finer.m_normalSums[finerIndex];
+        m_albedoSums[index] += finer.m_albedoSums[finerIndex];
+        ++finerIndex;
+    });
+}
+
+uint32_t VoxelAttributes::packedNormal(const glm::ivec3& gridPos) const
+{
+    if (!m_occupancy)
+        return 0;
+    return voxel_attributes::packNormal(m_normalSums[rank(gridPos)]);
+}
+
+uint32_t VoxelAttributes::packedAlbedo(const glm::ivec3& gridPos) const
+{
+    if (!m_occupancy)
+        return 0;
+    const glm::vec4 sum = m_albedoSums[rank(gridPos)];
+    return sum.w > 0.0f ? voxel_attributes::packAlbedo(glm::vec4(glm::vec3(sum) / sum.w, 1.0f)) : 0;
+}
+
+size_t VoxelAttributes::sampledVoxelCount() const
+{
+    return size_t(std::count_if(m_albedoSums.begin(), m_albedoSums.end(), [](const glm::vec4& sum) { return sum.w > 0.0f; }));
+}
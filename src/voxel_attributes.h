@@ -0,0 +1,105 @@
+#pragma once
+#include "occupancy_volume.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/geometric.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Surface attributes of the voxels, gathered from the atlas G-buffer (see shaders/atlas_attributes_frag.glsl). Both
+// are packed into 32 bits the way the atlas stores them and GLSL unpacks them: normals as octahedral coordinates in
+// two snorm16 (unpackSnorm2x16), albedo as RGBA8 (unpackUnorm4x8) with alpha 1 where a surface was found.
+namespace voxel_attributes {
+inline uint32_t packSnorm16(float value)
+{
+    return uint32_t(uint16_t(int16_t(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f))));
+}
+
+inline float unpackSnorm16(uint32_t bits)
+{
+    return std::max(float(int16_t(uint16_t(bits))) / 32767.0f, -1.0f);
+}
+
+// normal does not have to be normalized, a zero vector packs to 0.
+inline uint32_t packNormal(const glm::vec3& normal)
+{
+    const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 == 0.0f)
+        return 0;
+    glm::vec2 octahedral = glm::vec2(normal) / l1;
+    // The lower hemisphere is folded over the diagonals.
+    if (normal.z < 0.0f) {
+        const glm::vec2 sign(octahedral.x >= 0.0f ? 1.0f : -1.0f, octahedral.y >= 0.0f ? 1.0f : -1.0f);
+        octahedral = (1.0f - glm::abs(glm::vec2(octahedral.y, octahedral.x))) * sign;
+    }
+    return packSnorm16(octahedral.x) | (packSnorm16(octahedral.y) << 16);
+}
+
+inline glm::vec3 unpackNormal(uint32_t packed)
+{
+    const glm::vec2 octahedral(unpackSnorm16(packed), unpackSnorm16(packed >> 16));
+    glm::vec3 normal(octahedral, 1.0f - std::abs(octahedral.x) - std::abs(octahedral.y));
+    const float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::normalize(normal);
+}
+
+inline uint32_t packAlbedo(const glm::vec4& albedo)
+{
+    const glm::vec4 bytes = glm::round(glm::clamp(albedo, 0.0f, 1.0f) * 255.0f);
+    return uint32_t(bytes.r) | (uint32_t(bytes.g) << 8) | (uint32_t(bytes.b) << 16) | (uint32_t(bytes.a) << 24);
+}
+
+inline glm::vec4 unpackAlbedo(uint32_t packed)
+{
+    return glm::vec4(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff, packed >> 24) / 255.0f;
+}
+}
+
+// Averages the normals and albedos of the texels binned into each occupied voxel of a dense grid.
+//
+// There is one accumulator per occupied voxel rather than per grid cell: a voxel's accumulator is its rank, the
+// number of occupied voxels before it in row order, found from a prefix count per occupancy word and a popcount
+// within the word.
+class VoxelAttributes {
+public:
+    // Starts over with empty accumulators for the occupied voxels of occupancy, which has to stay alive and
+    // unchanged while the attributes are used.
+    void reset(const OccupancyVolume& occupancy);
+    void clear();
+
+    // Adds a surface sample to the occupied voxel at gridPos. normal is expected to be normalized.
+    void add(const glm::ivec3& gridPos, const glm::vec3& normal, const glm::vec3& albedo);
+    // Adds every accumulator of finer, whose grid is 2^levels times as long as this one, to its parent voxel.
+    void addFiner(const VoxelAttributes& finer, int levels);
+
+    // Packed average normal and albedo of an occupied voxel, 0 for voxels without samples (and after clear).
+    uint32_t packedNormal(const glm::ivec3& gridPos) const;
+    uint32_t packedAlbedo(const glm::ivec3& gridPos) const;
+
+    size_t voxelCount() const { return m_albedoSums.size(); }
+    size_t sampledVoxelCount() const;
+
+private:
+    size_t rank(const glm::ivec3& gridPos) const
+    {
+        const size_t word = m_occupancy->rowIndex(gridPos.y, gridPos.z) + size_t(gridPos.x >> 6);
+        const uint64_t below = (uint64_t(1) << (gridPos.x & 63)) - 1;
+        return m_wordRanks[word] + size_t(std::popcount(m_occupancy->words()[word] & below));
+    }
+
+private:
+    const OccupancyVolume* m_occupancy { nullptr };
+    std::vector<uint32_t> m_wordRanks; // occupied voxels in all words before this one
+    std::vector<glm::vec3> m_normalSums;
+    std::vector<glm::vec4> m_albedoSums; // rgb sum, sample count
+};
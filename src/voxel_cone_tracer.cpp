@@ -0,0 +1,215 @@
+#include "voxel_cone_tracer.h"
+#include "g_buffer.h"
+#include "gl_compute.h"
+#include "reflective_shadow_map.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/trigonometric.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+// Reflective shadow map flux is summed in steps of 1/256
+constexpr float fluxFixedPointScale = 256.0f;
+// Voxel radiance in steps of 1/4096, finer than the half floats of the volume around 1, which leaves a sum of 2^20 for
+// the voxels of the grid that share a texel of the volume
+constexpr float radianceFixedPointScale = 4096.0f;
+
+// Samples outside the volume are empty space.
+void setVolumeSampling(GLuint texture, GLenum minFilter)
+{
+    const GLfloat transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GLint(minFilter));
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    for (GLenum wrap : { GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T, GL_TEXTURE_WRAP_R })
+        glTextureParameteri(texture, wrap, GL_CLAMP_TO_BORDER);
+    glTextureParameterfv(texture, GL_TEXTURE_BORDER_COLOR, transparent);
+}
+}
+
+VoxelConeTracer::VoxelConeTracer()
+{
+    m_injectShader = gl_compute::buildShader("shaders/radiance_inject_comp.glsl");
+    m_rsmInjectShader = gl_compute::buildShader("shaders/rsm_inject_comp.glsl");
+    m_resolveShader = gl_compute::buildShader("shaders/radiance_resolve_comp.glsl");
+    m_mipmapShader = gl_compute::buildShader("shaders/radiance_mipmap_comp.glsl");
+    m_traceShader = gl_compute::buildShader("shaders/cone_trace_comp.glsl");
+}
+
+VoxelConeTracer::~VoxelConeTracer()
+{
+    glDeleteTextures(1, &m_radianceTexture);
+    glDeleteTextures(1, &m_accumulationTexture);
+    glDeleteTextures(GLsizei(m_directionalTextures.size()), m_directionalTextures.data());
+    glDeleteTextures(1, &m_diffuseTexture);
+    glDeleteTextures(1, &m_glossyTexture);
+}
+
+void VoxelConeTracer::begin(int volumeLength, const glm::vec3& worldMin, float worldLength)
+{
+    volumeLength = std::clamp(volumeLength, 2, maxVolumeLength);
+    if (volumeLength != m_volumeLength) {
+        glDeleteTextures(1, &m_radianceTexture);
+        glDeleteTextures(1, &m_accumulationTexture);
+        glDeleteTextures(GLsizei(m_directionalTextures.size()), m_directionalTextures.data());
+        m_volumeLength = volumeLength;
+        m_directionalLength = volumeLength / 2;
+        m_directionalLevels = std::bit_width(unsigned(m_directionalLength));
+
+        glCreateTextures(GL_TEXTURE_3D, 1, &m_radianceTexture);
+        glTextureStorage3D(m_radianceTexture, 1, GL_RGBA16F, volumeLength, volumeLength, volumeLength);
+        setVolumeSampling(m_radianceTexture, GL_LINEAR);
+        glCreateTextures(GL_TEXTURE_3D, 1, &m_accumulationTexture);
+        glTextureStorage3D(m_accumulationTexture, 1, GL_R32UI, 4 * volumeLength, volumeLength, volumeLength);
+        glCreateTextures(GL_TEXTURE_3D, GLsizei(m_directionalTextures.size()), m_directionalTextures.data());
+        for (GLuint texture : m_directionalTextures) {
+            glTextureStorage3D(texture, m_directionalLevels, GL_RGBA16F, m_directionalLength, m_directionalLength, m_directionalLength);
+            setVolumeSampling(texture, GL_LINEAR_MIPMAP_LINEAR);
+        }
+    }
+    m_worldMin = worldMin;
+    m_worldLength = worldLength;
+
+    const GLfloat transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearTexImage(m_radianceTexture, 0, GL_RGBA, GL_FLOAT, transparent);
+}
+
+void VoxelConeTracer::injectInstances(const VoxelInstanceBuffers& instances, const glm::vec3& lightPos, const glm::vec3& lightColor)
+{
+    if (instances.count == 0)
+        return;
+    clearAccumulation();
+    m_injectShader.bind();
+    glUniform1ui(0, GLuint(instances.count));
+    glUniform1i(1, instances.drawCommandBuffer != 0);
+    glUniform1i(2, instances.attributeBuffer != 0);
+    glUniform3fv(3, 1, glm::value_ptr(instances.gridOrigin));
+    glUniform1f(4, instances.voxelScale);
+    glUniform3fv(5, 1, glm::value_ptr(m_worldMin));
+    glUniform1f(6, m_worldLength / float(m_volumeLength));
+    glUniform3fv(7, 1, glm::value_ptr(lightPos));
+    glUniform3fv(8, 1, glm::value_ptr(lightColor));
+    glUniform1f(9, radianceFixedPointScale);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instances.positionBuffer);
+    if (instances.attributeBuffer)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, instances.attributeBuffer);
+    if (instances.drawCommandBuffer)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, instances.drawCommandBuffer);
+    glBindImageTexture(0, m_accumulationTexture, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+
+    // The shader loops over the instances, so the work group count stays below the limit for any count.
+    glDispatchCompute(std::min(gl_compute::divideRoundUp(instances.count, 64), GLuint(4096)), 1, 1);
+    resolveAccumulation(radianceFixedPointScale);
+}
+
+void VoxelConeTracer::injectOccupancy(const VoxelInstanceBuffers& instances)
+{
+    // Without light every voxel gets zero radiance and full coverage
+    injectInstances(instances, glm::vec3(0.0f), glm::vec3(0.0f));
+}
+
+void VoxelConeTracer::injectReflectiveShadowMap(const ReflectiveShadowMap& rsm)
+{
+    clearAccumulation();
+    m_rsmInjectShader.bind();
+    glUniform3fv(0, 1, glm::value_ptr(m_worldMin));
+    glUniform1f(1, m_worldLength / float(m_volumeLength));
+    glUniform1i(2, m_volumeLength);
+    glUniform1f(3, fluxFixedPointScale);
+    glBindTextureUnit(0, rsm.positionTexture());
+    glBindTextureUnit(1, rsm.normalTexture());
+    glBindTextureUnit(2, rsm.fluxTexture());
+    glBindImageTexture(0, m_accumulationTexture, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+    const GLuint groups = gl_compute::divideRoundUp(size_t(rsm.length()), 8);
+    glDispatchCompute(groups, groups, 1);
+    // Overwrites the voxels injectOccupancy() wrote where texels were added
+    resolveAccumulation(fluxFixedPointScale);
+}
+
+void VoxelConeTracer::filter()
+{
+    m_mipmapShader.bind();
+    glBindTextureUnit(0, m_radianceTexture);
+    for (size_t direction = 0; direction < m_directionalTextures.size(); ++direction)
+        glBindTextureUnit(GLuint(1 + direction), m_directionalTextures[direction]);
+
+    // Every level is filtered from the one before it, level 0 from the radiance volume.
+    for (int level = 0; level < m_directionalLevels; ++level) {
+        const int length = std::max(m_directionalLength >> level, 1);
+        const int sourceLength = level == 0 ? m_volumeLength : std::max(m_directionalLength >> (level - 1), 1);
+        glUniform1i(0, level - 1);
+        glUniform1i(1, sourceLength);
+        for (size_t direction = 0; direction < m_directionalTextures.size(); ++direction)
+            glBindImageTexture(GLuint(direction), m_directionalTextures[direction], level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        const GLuint groups = gl_compute::divideRoundUp(size_t(length), 4);
+        glDispatchCompute(groups, groups, groups);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+}
+
+void VoxelConeTracer::trace(const GBuffer& gBuffer, const glm::vec3& cameraPos, const ConeTraceSettings& settings, const SampleInterleave& interleave)
+{
+    resizeOutput(gBuffer.width(), gBuffer.height());
+    const int coneCount = std::clamp(settings.coneCount, 1, maxConeCount);
+
+    m_traceShader.bind();
+    glUniform3fv(0, 1, glm::value_ptr(m_worldMin));
+    glUniform1f(1, m_worldLength);
+    glUniform1i(2, m_volumeLength);
+    glUniform3fv(3, 1, glm::value_ptr(cameraPos));
+    glUniform1i(4, coneCount);
+    glUniform1f(5, settings.maxDistance);
+    glUniform1i(6, settings.glossy);
+    glUniform1f(7, std::tan(glm::radians(std::clamp(settings.glossyAperture, 0.5f, 60.0f))));
+    glUniform1ui(8, interleave.frame);
+    glUniform1i(9, std::clamp(interleave.frameCount, 1, coneCount));
+    glBindTextureUnit(0, gBuffer.positionTexture());
+    glBindTextureUnit(1, gBuffer.normalTexture());
+    glBindTextureUnit(2, m_radianceTexture);
+    for (size_t direction = 0; direction < m_directionalTextures.size(); ++direction)
+        glBindTextureUnit(GLuint(3 + direction), m_directionalTextures[direction]);
+    glBindImageTexture(0, m_diffuseTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glBindImageTexture(1, m_glossyTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute(gl_compute::divideRoundUp(size_t(m_outputWidth), 8), gl_compute::divideRoundUp(size_t(m_outputHeight), 8), 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void VoxelConeTracer::clearAccumulation()
+{
+    const GLuint zero = 0;
+    glClearTexImage(m_accumulationTexture, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+}
+
+void VoxelConeTracer::resolveAccumulation(float fixedPointScale)
+{
+    // The resolve reads the sums of the atomic adds before it
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    m_resolveShader.bind();
+    glUniform1f(0, fixedPointScale);
+    glBindImageTexture(0, m_accumulationTexture, 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI);
+    glBindImageTexture(1, m_radianceTexture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    const GLuint groups = gl_compute::divideRoundUp(size_t(m_volumeLength), 4);
+    glDispatchCompute(groups, groups, groups);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void VoxelConeTracer::resizeOutput(int width, int height)
+{
+    if (width == m_outputWidth && height == m_outputHeight)
+        return;
+    glDeleteTextures(1, &m_diffuseTexture);
+    glDeleteTextures(1, &m_glossyTexture);
+    m_outputWidth = width;
+    m_outputHeight = height;
+    for (GLuint* texture : { &m_diffuseTexture, &m_glossyTexture }) {
+        glCreateTextures(GL_TEXTURE_2D, 1, texture);
+        glTextureStorage2D(*texture, 1, GL_RGBA16F, width, height);
+        glTextureParameteri(*texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(*texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <framework/opengl_includes.h>
+#include <framework/shader.h>
+#include "sample_interleave.h"
+#include "voxel_instance_buffers.h"
+#include <array>
+#include <cstddef>
+
+class GBuffer;
+class ReflectiveShadowMap;
+
+struct ConeTraceSettings {
+    int coneCount { 6 }; // diffuse cones over the hemisphere, 1 to VoxelConeTracer::maxConeCount
+    float maxDistance { 1.0f }; // world units a cone travels at most
+    bool glossy { true }; // trace a glossy cone along the reflected view direction
+    float glossyAperture { 10.0f }; // half angle of the glossy cone in degrees
+};
+
+// Indirect diffuse and glossy lighting by voxel cone tracing (Crassin et al. 2011).
+//
+// The radiance of the occupied voxels is written to an RGBA16F 3D texture, premultiplied with alpha = coverage.
+// Either every voxel is lit by a point light (Lambert, unshadowed), or the voxels are written black and opaque and
+// the texels of a reflective shadow map are injected into the voxels their surfaces lie in. Both sum what falls into
+// a voxel with atomic adds in fixed point, along with its count, and a second pass writes the averages. That costs the same every frame whatever the meshes are, and the voxels the light does not see stay
+// dark, so the indirect light is shadowed. A compute pass filters it into six directional volumes
+// at half resolution with full mip chains, one per axis direction: every texel holds its 2x2x2 children composited
+// front to back along its direction, averaged over the other two axes, so a cone that looks along +x through a
+// wall sees the wall's near side occlude its far side. Cones then march through the volume from every G-buffer
+// pixel, sampling the mip level that matches their diameter from the three directional volumes facing them,
+// weighted by the squared components of the cone direction, and composite front to back until they are opaque.
+// Close to the surface the level is limited to cells of half the height above it, otherwise the coarse texels
+// would contain the surface the cone starts from and every pixel would light itself.
+//
+// The diffuse cones are spread over the hemisphere with a cosine weighted Fibonacci pattern, each as wide as its
+// share of the hemisphere (at most 60 degrees), so equal weights give the cosine weighted average radiance.
+// The volume covers a cube in world space at up to maxVolumeLength^3 voxels. When the voxel grid is finer, several
+// of its voxels fall into one texel of the volume, which holds their average radiance whatever order they are
+// written in, so the volume does not flicker from frame to frame.
+class VoxelConeTracer {
+public:
+    static constexpr int maxVolumeLength = 128;
+    static constexpr int maxConeCount = 16;
+
+    VoxelConeTracer();
+    VoxelConeTracer(const VoxelConeTracer&) = delete;
+    ~VoxelConeTracer();
+
+    VoxelConeTracer& operator=(const VoxelConeTracer&) = delete;
+
+    // Clears the radiance volume over the cube [worldMin, worldMin + worldLength], (re)allocating it at
+    // volumeLength^3 (clamped to maxVolumeLength) when the length changes.
+    void begin(int volumeLength, const glm::vec3& worldMin, float worldLength);
+    // Writes the radiance of the instances lit by a point light to the volume. Voxels without attributes are white
+    // and receive the light's average over all orientations, a quarter of it.
+    void injectInstances(const VoxelInstanceBuffers& instances, const glm::vec3& lightPos, const glm::vec3& lightColor);
+    // Writes the instances to the volume as opaque voxels without radiance, for injectReflectiveShadowMap().
+    void injectOccupancy(const VoxelInstanceBuffers& instances);
+    // Writes the average flux of the reflective shadow map texels that fall into each voxel to the volume.
+    void injectReflectiveShadowMap(const ReflectiveShadowMap& rsm);
+    // Builds the directional mip chains from the radiance volume.
+    void filter();
+    // Traces the cones of every G-buffer pixel. Writes the cosine weighted average radiance of the diffuse cones
+    // (alpha: their average occlusion) to diffuseTexture() and the glossy cone to glossyTexture(), both the size of
+    // the G-buffer, zero where no surface was rendered. The diffuse cones can be spread over several frames, at
+    // most one frame per cone.
+    void trace(const GBuffer& gBuffer, const glm::vec3& cameraPos, const ConeTraceSettings& settings, const SampleInterleave& interleave = {});
+
+    int volumeLength() const { return m_volumeLength; }
+    GLuint radianceTexture() const { return m_radianceTexture; }
+    GLuint diffuseTexture() const { return m_diffuseTexture; }
+    GLuint glossyTexture() const { return m_glossyTexture; }
+
+private:
+    void clearAccumulation();
+    // Writes the averages of the sums in the accumulation texture to the radiance volume.
+    void resolveAccumulation(float fixedPointScale);
+    void resizeOutput(int width, int height);
+
+private:
+    Shader m_injectShader;
+    Shader m_rsmInjectShader;
+    Shader m_resolveShader;
+    Shader m_mipmapShader;
+    Shader m_traceShader;
+
+    GLuint m_radianceTexture { 0 };
+    GLuint m_accumulationTexture { 0 }; // R32UI, 4 texels along x per voxel: the sums of the radiance or flux and the count
+    std::array<GLuint, 6> m_directionalTextures {}; // +x, -x, +y, -y, +z, -z
+    GLuint m_diffuseTexture { 0 };
+    GLuint m_glossyTexture { 0 };
+
+    int m_volumeLength { 0 };
+    int m_directionalLength { 0 };
+    int m_directionalLevels { 0 };
+    glm::vec3 m_worldMin { 0.0f };
+    float m_worldLength { 1.0f };
+    int m_outputWidth { 0 };
+    int m_outputHeight { 0 };
+};
@@ -8,15 +8,23 @@ DISABLE_WARNINGS_PUSH()
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 DISABLE_WARNINGS_POP()
+#include "hashed_occupancy.h"
+#include "morton.h"
+#include "occupancy_volume.h"
 
 class VoxelGrid {
 public:
     int gridLength = 64; // size of voxel grid, cubic
     float worldLength = 2.0f; // actual world space size of world bounds
-    float voxelScale = worldLength / gridLength; // size of voxels
+    float voxelScale = worldLength / float(gridLength); // size of voxels
     glm::vec3 worldMin = glm::vec3(-1.0f, -1.0f, -1.0f); // world bounds
     glm::vec3 worldMax = glm::vec3(1.0f, 1.0f, 1.0f);
-    std::vector<glm::ivec3> occupiedPositions;
+    OccupancyVolume occupancy{ gridLength }; // 1 bit per voxel
+    HashedOccupancy sparseOccupancy; // used instead of occupancy when the grid is unbounded
+    bool mortonOrder = false; // list occupied voxels in Morton (Z-)order instead of row order, the occupancy itself stays in row order
+    // keep voxels outside the world bounds instead of clamping them to the boundary voxels, grid positions must stay
+    // within [-HashedOccupancy::coordinateLimit, HashedOccupancy::coordinateLimit) on every axis
+    bool unbounded = false;
 
      /**
      * Checks if a given grid position is already occupied.
@@ -24,8 +32,60 @@ public:
      * @param gridPos The grid position to check, represented as a vec3i
      * @return True if the position is occupied, false otherwise.
      */
-    bool isGridPositionOccupied(const glm::ivec3& gridPos) {
-        return std::find(occupiedPositions.begin(), occupiedPositions.end(), gridPos) != occupiedPositions.end();
+    bool isGridPositionOccupied(const glm::ivec3& gridPos) const {
+        return unbounded ? sparseOccupancy.test(gridPos) : occupancy.test(gridPos);
+    }
+
+    /**
+     * Marks a grid position as occupied.
+     *
+     * @param gridPos The grid position to mark, represented as a vec3i
+     * @return True if the position was not occupied before, false otherwise.
+     */
+    bool markGridPositionOccupied(const glm::ivec3& gridPos) {
+        return unbounded ? sparseOccupancy.set(gridPos) : occupancy.set(gridPos);
+    }
+
+    // Number of occupied voxels in the grid
+    size_t occupiedCount() const {
+        return unbounded ? sparseOccupancy.count() : occupancy.count();
+    }
+
+    // Calls f(glm::ivec3) for every occupied grid position
+    template <typename F>
+    void forEachOccupied(F&& f) const {
+        if (unbounded)
+            sparseOccupancy.forEachOccupied(f);
+        else
+            occupancy.forEachOccupied(f);
+    }
+
+    /**
+     * Lists all occupied grid positions, in Morton order if mortonOrder is set and in x-fastest row order otherwise.
+     * Only the order of the list changes (and with it the order of the voxel instances), not the occupancy storage.
+     *
+     * @return The occupied grid positions
+     */
+    std::vector<glm::ivec3> occupiedPositions() const {
+        std::vector<glm::ivec3> positions;
+        positions.reserve(occupiedCount());
+        forEachOccupied([&](const glm::ivec3& gridPos) { positions.push_back(gridPos); });
+        if (mortonOrder && !positions.empty()) {
+            // Morton keys need non-negative coordinates, unbounded grids can extend below 0
+            glm::ivec3 minPos = positions.front(), maxPos = positions.front();
+            for (const glm::ivec3& gridPos : positions) {
+                minPos = glm::min(minPos, gridPos);
+                maxPos = glm::max(maxPos, gridPos);
+            }
+            for (glm::ivec3& gridPos : positions)
+                gridPos -= minPos;
+            const glm::ivec3 extent = maxPos - minPos;
+            std::vector<uint64_t> keys(positions.size());
+            std::transform(positions.begin(), positions.end(), keys.begin(), [](const glm::ivec3& gridPos) { return morton::encode21(gridPos); });
+            morton::sortKeys(keys, 3 * int(std::bit_width(unsigned(std::max({ extent.x, extent.y, extent.z })))));
+            std::transform(keys.begin(), keys.end(), positions.begin(), [&](uint64_t key) { return morton::decode21(key) + minPos; });
+        }
+        return positions;
     }
 
     /**
@@ -35,18 +95,23 @@ public:
     * @return The corresponding grid position as a vec3i
     */
     glm::ivec3 worldToGridPosition(const glm::vec3& worldPos) {
+        if (unbounded) {
+            // no clamping, positions outside the world bounds get grid positions outside [0, gridLength)
+            return glm::ivec3(glm::floor((worldPos - worldMin) / voxelScale));
+        }
+
         // normalize within [0,1]
         glm::vec3 normalizedPos = (worldPos - worldMin) / (worldMax - worldMin);
 
         // clamp to [0,1]
         normalizedPos = glm::clamp(normalizedPos, glm::vec3(0.0f), glm::vec3(1.0f));
 
-        // convert world position to grid position
-        return glm::ivec3(
-            static_cast<int>(glm::floor(normalizedPos.x * gridLength)),
-            static_cast<int>(glm::floor(normalizedPos.y * gridLength)),
-            static_cast<int>(glm::floor(normalizedPos.z * gridLength))
-        );
+        // convert world position to grid position, a position exactly on worldMax belongs to the last voxel
+        return glm::min(glm::ivec3(
+            static_cast<int>(glm::floor(normalizedPos.x * float(gridLength))),
+            static_cast<int>(glm::floor(normalizedPos.y * float(gridLength))),
+            static_cast<int>(glm::floor(normalizedPos.z * float(gridLength)))
+        ), glm::ivec3(gridLength - 1));
     }
 
     /**
@@ -61,13 +126,18 @@ public:
 
     /**
      * Clears the grid by removing all occupied positions.
+     * The occupancy volume is resized if the grid length has changed.
      */
     void clearGrid() {
-        occupiedPositions.clear();
+        sparseOccupancy.clear();
+        if (occupancy.gridLength() != gridLength)
+            occupancy.resize(gridLength);
+        else
+            occupancy.clear();
     }
 
     // Calculates the voxel scale based on world length and grid length
     void calculateVoxelScale() {
-        voxelScale = worldLength / gridLength;
+        voxelScale = worldLength / float(gridLength);
     }
 };
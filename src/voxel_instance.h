@@ -0,0 +1,33 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <cstdint>
+
+// Voxels are drawn as instanced unit cubes. An instance is only its grid position, packed as 10:10:10 bits
+// (x in the lowest bits) relative to an origin voxel; the world space origin and voxel scale are uniforms
+// shared by all instances (see shaders/voxel_vert.glsl).
+namespace voxel_instance {
+constexpr int coordinateBits = 10;
+constexpr int maxCoordinate = (1 << coordinateBits) - 1;
+// Largest grid that fits the packed format.
+constexpr int maxGridLength = maxCoordinate + 1;
+
+// offset has to be in [0, maxCoordinate] on every axis.
+inline uint32_t pack(const glm::ivec3& offset)
+{
+    return uint32_t(offset.x) | (uint32_t(offset.y) << coordinateBits) | (uint32_t(offset.z) << (2 * coordinateBits));
+}
+
+inline glm::ivec3 unpack(uint32_t instance)
+{
+    return glm::ivec3(instance & maxCoordinate, (instance >> coordinateBits) & maxCoordinate, (instance >> (2 * coordinateBits)) & maxCoordinate);
+}
+
+inline bool fits(const glm::ivec3& offset)
+{
+    return offset.x >= 0 && offset.y >= 0 && offset.z >= 0 && offset.x <= maxCoordinate && offset.y <= maxCoordinate && offset.z <= maxCoordinate;
+}
+}
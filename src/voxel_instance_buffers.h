@@ -0,0 +1,19 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <framework/opengl_includes.h>
+#include <cstddef>
+
+// The voxels of the current build as the instance buffers of the voxel renderers hold them, for the compute
+// passes that light or rasterize them on the GPU.
+struct VoxelInstanceBuffers {
+    GLuint positionBuffer { 0 }; // 10:10:10 packed grid positions relative to gridOrigin (voxel_instance.h)
+    GLuint attributeBuffer { 0 }; // packed normal and albedo per instance (voxel_attributes.h), 0 if the voxels have none
+    GLuint drawCommandBuffer { 0 }; // DrawElementsIndirectCommand holding the instance count, 0 to use count
+    size_t count { 0 }; // instances, an upper bound when the count comes from drawCommandBuffer
+    glm::vec3 gridOrigin { 0.0f }; // world space minimum corner of the voxel at packed position 0
+    float voxelScale { 1.0f };
+};
@@ -0,0 +1,124 @@
+#include "voxel_ray_caster.h"
+#include "g_buffer.h"
+#include "gl_compute.h"
+#include "reflective_shadow_map.h"
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/gtc/type_ptr.hpp>
+DISABLE_WARNINGS_POP()
+#include <algorithm>
+#include <bit>
+
+VoxelRayCaster::VoxelRayCaster()
+{
+    m_voxelizeShader = gl_compute::buildShader("shaders/voxel_bitmask_comp.glsl");
+    m_mipmapShader = gl_compute::buildShader("shaders/voxel_bitmask_mipmap_comp.glsl");
+    m_traceShader = gl_compute::buildShader("shaders/voxel_ray_cast_comp.glsl");
+}
+
+VoxelRayCaster::~VoxelRayCaster()
+{
+    glDeleteTextures(1, &m_bitmaskTexture);
+    glDeleteTextures(1, &m_indirectTexture);
+}
+
+void VoxelRayCaster::begin(int gridLength, const glm::vec3& worldMin, float voxelScale)
+{
+    // Longer grids merge factor^3 voxels into one cell
+    const int factor = int(gl_compute::divideRoundUp(size_t(std::max(gridLength, 1)), size_t(maxBitmaskLength)));
+    const int cells = int(gl_compute::divideRoundUp(size_t(std::max(gridLength, 1)), size_t(factor)));
+    const int bitmaskLength = int(std::bit_ceil(unsigned(std::max(cells, 2))));
+    if (bitmaskLength != m_bitmaskLength) {
+        glDeleteTextures(1, &m_bitmaskTexture);
+        m_bitmaskLength = bitmaskLength;
+        m_bitmaskLevels = std::bit_width(unsigned(bitmaskLength));
+        m_wordCount = int(gl_compute::divideRoundUp(size_t(bitmaskLength), 32));
+
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_bitmaskTexture);
+        glTextureStorage3D(m_bitmaskTexture, m_bitmaskLevels, GL_R32UI, bitmaskLength, bitmaskLength, m_wordCount);
+        glTextureParameteri(m_bitmaskTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTextureParameteri(m_bitmaskTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    m_worldMin = worldMin;
+    m_cellSize = voxelScale * float(factor);
+
+    const GLuint empty = 0;
+    glClearTexImage(m_bitmaskTexture, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &empty);
+}
+
+void VoxelRayCaster::voxelize(const VoxelInstanceBuffers& instances)
+{
+    if (instances.count == 0)
+        return;
+    m_voxelizeShader.bind();
+    glUniform1ui(0, GLuint(instances.count));
+    glUniform1i(1, instances.drawCommandBuffer != 0);
+    glUniform3fv(2, 1, glm::value_ptr(instances.gridOrigin));
+    glUniform1f(3, instances.voxelScale);
+    glUniform3fv(4, 1, glm::value_ptr(m_worldMin));
+    glUniform1f(5, m_cellSize);
+    glUniform1i(6, m_bitmaskLength);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instances.positionBuffer);
+    if (instances.drawCommandBuffer)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, instances.drawCommandBuffer);
+    glBindImageTexture(0, m_bitmaskTexture, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+
+    // The shader loops over the instances, so the work group count stays below the limit for any count.
+    glDispatchCompute(std::min(gl_compute::divideRoundUp(instances.count, 64), GLuint(4096)), 1, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void VoxelRayCaster::buildMipmaps()
+{
+    m_mipmapShader.bind();
+    glBindTextureUnit(0, m_bitmaskTexture);
+    for (int level = 1; level < m_bitmaskLevels; ++level) {
+        const int length = std::max(m_bitmaskLength >> level, 1);
+        glUniform1i(0, level - 1);
+        glBindImageTexture(0, m_bitmaskTexture, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32UI);
+        const GLuint groups = gl_compute::divideRoundUp(size_t(length), 8);
+        glDispatchCompute(groups, groups, GLuint(m_wordCount));
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+}
+
+void VoxelRayCaster::trace(const GBuffer& gBuffer, const ReflectiveShadowMap& rsm, const RayCastSettings& settings, const SampleInterleave& interleave)
+{
+    resizeOutput(gBuffer.width(), gBuffer.height());
+    const int rayCount = std::clamp(settings.rayCount, 1, maxRayCount);
+
+    m_traceShader.bind();
+    glUniform3fv(0, 1, glm::value_ptr(m_worldMin));
+    glUniform1f(1, m_cellSize);
+    glUniform1i(2, m_bitmaskLength);
+    glUniform1i(3, m_bitmaskLevels - 1);
+    glUniform1i(4, rayCount);
+    glUniform1f(5, settings.rayLength);
+    glUniformMatrix4fv(6, 1, GL_FALSE, glm::value_ptr(rsm.viewProjection()));
+    glUniform1ui(10, interleave.frame);
+    glUniform1i(11, std::clamp(interleave.frameCount, 1, rayCount));
+    glBindTextureUnit(0, gBuffer.positionTexture());
+    glBindTextureUnit(1, gBuffer.normalTexture());
+    glBindTextureUnit(2, m_bitmaskTexture);
+    glBindTextureUnit(3, rsm.positionTexture());
+    glBindTextureUnit(4, rsm.normalTexture());
+    glBindTextureUnit(5, rsm.fluxTexture());
+    glBindImageTexture(0, m_indirectTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute(gl_compute::divideRoundUp(size_t(m_outputWidth), 8), gl_compute::divideRoundUp(size_t(m_outputHeight), 8), 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void VoxelRayCaster::resizeOutput(int width, int height)
+{
+    if (width == m_outputWidth && height == m_outputHeight)
+        return;
+    glDeleteTextures(1, &m_indirectTexture);
+    m_outputWidth = width;
+    m_outputHeight = height;
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_indirectTexture);
+    glTextureStorage2D(m_indirectTexture, 1, GL_RGBA16F, width, height);
+    glTextureParameteri(m_indirectTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(m_indirectTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
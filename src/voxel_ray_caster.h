@@ -0,0 +1,79 @@
+#pragma once
+// Suppress warnings in third-party code.
+#include <framework/disable_all_warnings.h>
+DISABLE_WARNINGS_PUSH()
+#include <glm/vec3.hpp>
+DISABLE_WARNINGS_POP()
+#include <framework/opengl_includes.h>
+#include <framework/shader.h>
+#include "sample_interleave.h"
+#include "voxel_instance_buffers.h"
+
+class GBuffer;
+class ReflectiveShadowMap;
+
+struct RayCastSettings {
+    int rayCount { 8 }; // rays per pixel, 1 to VoxelRayCaster::maxRayCount
+    float rayLength { 0.25f }; // world units a ray travels at most
+};
+
+// Near-field indirect diffuse lighting by ray casting a binary voxelization (Thiedemann et al. 2011).
+//
+// The voxels are stored one bit each in an R32UI 2D array texture: texel (x, y) of layer z / 32 holds the column of
+// voxels (x, y, z) in bit z % 32. Its mip levels OR 2x2 columns in x and y and keep z at full resolution, so one
+// texel fetch tells whether any voxel of a wider column lies in the z range a ray crosses there. Rays walk the
+// columns hierarchically, refining occupied ones and skipping empty ones a level coarser, and stop at the first
+// voxel. Its direct light is looked up in the reflective shadow map: when the light sees a surface in that voxel
+// the ray receives its reflected flux, otherwise the voxel is in shadow.
+//
+// The rays of a pixel are a cosine weighted Fibonacci pattern rotated per pixel, so the average radiance they
+// return is the diffuse indirect light. Rays that leave the bitmask or reach rayLength return nothing, the pass
+// only gathers near-field light. The bitmask keeps the voxel size of grids up to maxBitmaskLength voxels long
+// (padded to a power of two), longer grids are stored at a multiple of it.
+class VoxelRayCaster {
+public:
+    static constexpr int maxBitmaskLength = 256;
+    static constexpr int maxRayCount = 32;
+
+    VoxelRayCaster();
+    VoxelRayCaster(const VoxelRayCaster&) = delete;
+    ~VoxelRayCaster();
+
+    VoxelRayCaster& operator=(const VoxelRayCaster&) = delete;
+
+    // Clears the bitmask for a grid of gridLength^3 voxels of voxelScale starting at worldMin, (re)allocating it
+    // when its length changes.
+    void begin(int gridLength, const glm::vec3& worldMin, float voxelScale);
+    // Sets the bits of the instances.
+    void voxelize(const VoxelInstanceBuffers& instances);
+    // Builds the mip levels of the bitmask from level 0.
+    void buildMipmaps();
+    // Casts the rays of every G-buffer pixel. Writes their average radiance (alpha: the fraction that hit a voxel)
+    // to indirectTexture(), the size of the G-buffer, zero where no surface was rendered. The rays can be spread
+    // over several frames, at most one frame per ray.
+    void trace(const GBuffer& gBuffer, const ReflectiveShadowMap& rsm, const RayCastSettings& settings, const SampleInterleave& interleave = {});
+
+    int bitmaskLength() const { return m_bitmaskLength; }
+    float cellSize() const { return m_cellSize; }
+    GLuint bitmaskTexture() const { return m_bitmaskTexture; }
+    GLuint indirectTexture() const { return m_indirectTexture; }
+
+private:
+    void resizeOutput(int width, int height);
+
+private:
+    Shader m_voxelizeShader;
+    Shader m_mipmapShader;
+    Shader m_traceShader;
+
+    GLuint m_bitmaskTexture { 0 };
+    GLuint m_indirectTexture { 0 };
+
+    int m_bitmaskLength { 0 };
+    int m_bitmaskLevels { 0 };
+    int m_wordCount { 0 }; // layers of 32 voxels along z
+    glm::vec3 m_worldMin { 0.0f };
+    float m_cellSize { 1.0f };
+    int m_outputWidth { 0 };
+    int m_outputHeight { 0 };
+};